@@ -0,0 +1,77 @@
+#include "AudioFileDecoder.h"
+
+#include <QEventLoop>
+#include <QUrl>
+#include <QtMultimedia/QAudioBuffer>
+#include <QtMultimedia/QAudioDecoder>
+#include <cstring>
+#include <vector>
+
+namespace {
+    // 解碼器輸出轉成交錯 float
+    bool toFloat(const QAudioBuffer &buf, std::vector<float> &out) {
+        const qsizetype n = static_cast<qsizetype>(buf.frameCount()) * buf.format().channelCount();
+        out.resize(static_cast<size_t>(n));
+        switch (buf.format().sampleFormat()) {
+            case QAudioFormat::UInt8: {
+                const auto *in = buf.constData<quint8>();
+                for (qsizetype i = 0; i < n; ++i) out[i] = (static_cast<float>(in[i]) - 128.0f) / 128.0f;
+                return true;
+            }
+            case QAudioFormat::Int16: {
+                const auto *in = buf.constData<qint16>();
+                for (qsizetype i = 0; i < n; ++i) out[i] = static_cast<float>(in[i]) / 32768.0f;
+                return true;
+            }
+            case QAudioFormat::Int32: {
+                const auto *in = buf.constData<qint32>();
+                for (qsizetype i = 0; i < n; ++i) out[i] = static_cast<float>(in[i] / 2147483648.0);
+                return true;
+            }
+            case QAudioFormat::Float:
+                memcpy(out.data(), buf.constData<float>(), n * sizeof(float));
+                return true;
+            default:
+                return false;
+        }
+    }
+}
+
+// 以原生格式解碼（不重新取樣），記憶體用量與曲長無關
+bool AudioFileDecoder::decode(const QString &path, const Sink &sink, const std::atomic<bool> *abort) {
+    QAudioDecoder decoder;
+    decoder.setSource(QUrl::fromLocalFile(path));
+
+    QEventLoop loop;
+    std::vector<float> samples;
+    QAudioFormat format;
+    bool done = false;
+    bool failed = false;
+    bool any = false;
+    auto finish = [&](bool error) {
+        failed = failed || error;
+        done = true;
+        loop.quit();
+    };
+
+    QObject::connect(&decoder, &QAudioDecoder::bufferReady, &loop, [&] {
+        const QAudioBuffer buf = decoder.read();
+        if (abort && abort->load(std::memory_order_relaxed)) {
+            decoder.stop();
+            finish(true);
+            return;
+        }
+        if (!buf.isValid()) return;
+        if (!format.isValid()) format = buf.format();
+        if (buf.format().channelCount() != format.channelCount() || !toFloat(buf, samples)) return;
+        sink(samples.data(), buf.frameCount(), format);
+        any = true;
+    });
+    QObject::connect(&decoder, &QAudioDecoder::finished, &loop, [&] { finish(false); });
+    QObject::connect(&decoder, qOverload<QAudioDecoder::Error>(&QAudioDecoder::error), &loop,
+                     [&](QAudioDecoder::Error) { finish(true); });
+
+    decoder.start();
+    if (!done) loop.exec(); // start() 可能同步回報錯誤
+    return !failed && any;
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include <QString>
+#include <QtMultimedia/QAudioFormat>
+#include <atomic>
+#include <functional>
+
+// 同步解碼整個檔案，逐塊交出交錯 float（響度分析、波形等背景工作共用）
+class AudioFileDecoder final {
+public:
+    using Sink = std::function<void(const float *samples, qint64 frames, const QAudioFormat &format)>;
+
+    // 呼叫端執行緒需能執行事件迴圈（執行緒池的執行緒即可）；abort 設為 true 時提前結束並回傳 false
+    static bool decode(const QString &path, const Sink &sink, const std::atomic<bool> *abort = nullptr);
+};
@@ -0,0 +1,122 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <utility>
+#include "SpscRingBuffer.h"
+
+// 從播放中的串流分出樣本給視覺化使用（不另外解碼）
+//
+// 區塊在建構時一次配置好，以參考計數的 Handle 交給消費端：之後只傳遞指標、不複製樣本。
+// 音訊執行緒寫入時不加鎖、不配置記憶體；消費端跟不上或沒人使用時直接丟棄。
+class AudioTap final {
+public:
+    static constexpr int kBlockFrames = 1024;
+    static constexpr int kMaxChannels = 2;
+    static constexpr int kBlocks = 16;
+
+    struct Block {
+        std::atomic<int> refs{0}; // 0 = 閒置
+        int frames = 0;
+        int channels = 2;
+        int sampleRate = 48000;
+        float samples[kBlockFrames * kMaxChannels];
+    };
+
+    // 複製只增加參考計數；最後一個 Handle 消失時區塊回到閒置
+    class Handle {
+    public:
+        Handle() = default;
+
+        Handle(const Handle &other) : m_block(other.m_block) {
+            if (m_block) m_block->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        Handle(Handle &&other) noexcept : m_block(std::exchange(other.m_block, nullptr)) {
+        }
+
+        Handle &operator=(Handle other) noexcept {
+            std::swap(m_block, other.m_block);
+            return *this;
+        }
+
+        ~Handle() {
+            if (m_block) m_block->refs.fetch_sub(1, std::memory_order_release);
+        }
+
+        explicit operator bool() const { return m_block != nullptr; }
+
+        const float *samples() const { return m_block->samples; }
+
+        int frames() const { return m_block->frames; }
+
+        int channels() const { return m_block->channels; }
+
+        int sampleRate() const { return m_block->sampleRate; }
+
+    private:
+        friend class AudioTap;
+
+        explicit Handle(Block *adopt) : m_block(adopt) {
+        }
+
+        Block *m_block = nullptr;
+    };
+
+    AudioTap() : m_ready(kBlocks) {
+    }
+
+    AudioTap(const AudioTap &) = delete;
+
+    AudioTap &operator=(const AudioTap &) = delete;
+
+    // 關閉時音訊執行緒只多讀一個 atomic
+    void setEnabled(bool on) { m_enabled.store(on, std::memory_order_relaxed); }
+
+    bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    // 音訊執行緒（唯一的生產者）
+    void write(const float *interleaved, int frames, int channels, int sampleRate) {
+        if (!isEnabled() || channels < 1 || channels > kMaxChannels) return;
+        while (frames > 0) {
+            if (!m_filling && !(m_filling = acquire())) return;
+            if (m_filling->frames == 0) {
+                m_filling->channels = channels;
+                m_filling->sampleRate = sampleRate;
+            }
+            const int n = std::min(frames, kBlockFrames - m_filling->frames);
+            memcpy(m_filling->samples + m_filling->frames * channels, interleaved, sizeof(float) * n * channels);
+            m_filling->frames += n;
+            interleaved += n * channels;
+            frames -= n;
+            if (m_filling->frames == kBlockFrames) {
+                m_ready.write(&m_filling, 1); // 生產者持有的參考交給佇列
+                m_filling = nullptr;
+            }
+        }
+    }
+
+    // 消費端（唯一）
+    Handle take() {
+        Block *b = nullptr;
+        return m_ready.read(&b, 1) == 1 ? Handle(b) : Handle();
+    }
+
+private:
+    Block *acquire() {
+        for (Block &b: m_blocks) {
+            int idle = 0;
+            if (b.refs.compare_exchange_strong(idle, 1, std::memory_order_acquire)) {
+                b.frames = 0;
+                return &b;
+            }
+        }
+        return nullptr; // 全部還在使用中
+    }
+
+    std::array<Block, kBlocks> m_blocks;
+    Block *m_filling = nullptr; // 只由生產者使用
+    SpscRingBuffer<Block *> m_ready;
+    std::atomic<bool> m_enabled{false};
+};
@@ -0,0 +1,133 @@
+#include "DspChain.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+
+namespace {
+    constexpr double kBandQ = 1.41; // 約一個八度
+    constexpr double kLookaheadSec = 0.005;
+    constexpr double kReleaseSec = 0.1;
+
+    constexpr DspChain::Preset kPresets[] = {
+        {"Flat", {0, 0, 0, 0, 0, 0, 0, 0, 0, 0}},
+        {"Rock", {5, 4, 3, 1, -1, -1, 1, 3, 4, 5}},
+        {"Pop", {-1, 1, 3, 4, 3, 0, -1, -1, 1, 2}},
+        {"Jazz", {3, 2, 1, 2, -1, -1, 0, 1, 2, 3}},
+        {"Classical", {4, 3, 2, 1, 0, 0, 0, 1, 2, 3}},
+        {"Vocal", {-2, -2, -1, 1, 3, 3, 2, 1, 0, -1}},
+        {"Bass Boost", {6, 5, 4, 2, 0, 0, 0, 0, 0, 0}},
+        {"Treble Boost", {0, 0, 0, 0, 0, 1, 2, 4, 5, 6}},
+        {"Loudness", {5, 4, 2, 0, -1, 0, 0, 2, 4, 5}},
+    };
+
+    // RBJ cookbook 的 peaking EQ
+    Biquad peaking(double hz, double db, double rate) {
+        if (db == 0.0 || hz >= rate * 0.5) return {};
+        const double a = std::pow(10.0, db / 40.0);
+        const double w0 = 2.0 * std::numbers::pi * hz / rate;
+        const double alpha = std::sin(w0) / (2.0 * kBandQ);
+        const double cosw = std::cos(w0);
+        const double a0 = 1.0 + alpha / a;
+        return {(1.0 + alpha * a) / a0, -2.0 * cosw / a0, (1.0 - alpha * a) / a0, -2.0 * cosw / a0, (1.0 - alpha / a) / a0};
+    }
+
+    float dbToGain(float db) {
+        return std::pow(10.0f, db / 20.0f);
+    }
+}
+
+std::span<const DspChain::Preset> DspChain::presets() {
+    return kPresets;
+}
+
+DspChain::DspChain()
+    : m_params(Params{}), m_kernels(&DspKernels::best()) {
+    prepare(m_rate);
+    applyParams(m_params.read());
+}
+
+void DspChain::prepare(int sampleRate) {
+    m_rate = sampleRate > 0 ? sampleRate : 48000;
+    m_lookahead = std::clamp(static_cast<int>(m_rate * kLookaheadSec), 1, static_cast<int>(kMinCapacity) - 1);
+    m_delay.assign(static_cast<size_t>(2 * (m_lookahead + kBlock)), 0.0f);
+    m_attack = 1.0f - std::exp(-3.0f / static_cast<float>(m_lookahead)); // 前瞻期間內收斂到 95%
+    m_release = 1.0f - std::exp(-1.0f / static_cast<float>(m_rate * kReleaseSec));
+    applyParams(m_params.read());
+    reset();
+}
+
+void DspChain::setParams(const Params &params) {
+    m_params.write(params);
+}
+
+void DspChain::reset() {
+    for (BiquadState &s: m_state) s = {};
+    std::fill(m_delay.begin(), m_delay.end(), 0.0f);
+    m_gain = 1.0f;
+    m_minHead = m_minTail = 0;
+    m_frame = 0;
+}
+
+// 在音訊執行緒中計算係數（只有數學運算，不配置記憶體）
+void DspChain::applyParams(const Params &p) {
+    const bool anyBand = std::any_of(std::begin(p.bandDb), std::end(p.bandDb), [](float db) { return db != 0.0f; });
+    const bool eq = p.eqEnabled && anyBand;
+    if (eq && !m_eq) {
+        for (BiquadState &s: m_state) s = {};
+    }
+    m_eq = eq;
+    m_preamp = (p.eqEnabled ? dbToGain(p.preampDb) : 1.0f) * dbToGain(p.replayGainDb);
+    for (int b = 0; b < kBands; ++b) m_coeffs[b] = peaking(kBandHz[b], p.bandDb[b], m_rate);
+
+    if (p.limiter && !m_limiter) {
+        std::fill(m_delay.begin(), m_delay.end(), 0.0f);
+        m_gain = 1.0f;
+        m_minHead = m_minTail = 0;
+    }
+    m_limiter = p.limiter;
+    m_ceiling = dbToGain(std::min(p.ceilingDb, 0.0f));
+}
+
+void DspChain::process(float *io, int frames) {
+    if (m_params.update()) applyParams(m_params.read());
+    if (!m_eq && m_preamp == 1.0f && !m_limiter) return;
+
+    while (frames > 0) {
+        const int n = std::min(frames, kBlock);
+        processBlock(io, n);
+        io += 2 * n;
+        frames -= n;
+    }
+}
+
+void DspChain::processBlock(float *io, int n) {
+    if (m_eq || m_preamp != 1.0f) m_kernels->eq(io, n, m_coeffs, m_state, m_eq ? kBands : 0, m_preamp);
+    if (!m_limiter) return;
+
+    // 新樣本接在前瞻歷史之後；輸出的是延遲 m_lookahead 個 frame 的樣本
+    float *tail = m_delay.data() + 2 * m_lookahead;
+    std::copy_n(io, 2 * n, tail);
+    m_kernels->peaks(tail, m_peaks, n);
+    for (int i = 0; i < n; ++i) m_gains[i] = limiterGain(m_peaks[i]);
+    m_kernels->applyGain(m_delay.data(), io, m_gains, n, m_ceiling);
+    std::memmove(m_delay.data(), m_delay.data() + 2 * n, sizeof(float) * 2 * m_lookahead);
+}
+
+// 視窗 [t - lookahead, t] 內所需增益的最小值，再平滑（快速壓下、緩慢回復）
+float DspChain::limiterGain(float peak) {
+    constexpr std::uint32_t kMask = kMinCapacity - 1;
+    const float need = peak > m_ceiling ? m_ceiling / peak : 1.0f;
+
+    while (m_minTail != m_minHead && m_minValue[(m_minTail - 1) & kMask] >= need) --m_minTail;
+    m_minAt[m_minTail & kMask] = m_frame;
+    m_minValue[m_minTail & kMask] = need;
+    ++m_minTail;
+    while (m_minAt[m_minHead & kMask] < m_frame - m_lookahead) ++m_minHead;
+    ++m_frame;
+
+    const float target = m_minValue[m_minHead & kMask];
+    m_gain += (target - m_gain) * (target < m_gain ? m_attack : m_release);
+    return m_gain;
+}
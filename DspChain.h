@@ -0,0 +1,93 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "DspKernels.h"
+#include "TripleBuffer.h"
+
+// 播放端的即時 DSP：前級增益 → 10 段等化器 → 前瞻式限幅器
+//
+// 參數可以從 GUI 執行緒隨時設定（經由無鎖三重緩衝交給音訊執行緒）；
+// process() 在音訊回呼中執行，不加鎖、不配置記憶體。
+class DspChain final {
+public:
+    static constexpr int kBands = 10;
+    static constexpr std::array<float, kBands> kBandHz{31, 62, 125, 250, 500, 1000, 2000, 4000, 8000, 16000};
+
+    struct Params {
+        bool eqEnabled = false;
+        float preampDb = 0.0f;
+        float bandDb[kBands]{};
+        bool limiter = true;
+        float ceilingDb = -0.3f;
+        float replayGainDb = 0.0f; // 響度正規化，與前級相乘（在限幅器之前）
+    };
+
+    struct Preset {
+        const char *name;
+        float bandDb[kBands];
+    };
+
+    static std::span<const Preset> presets();
+
+    DspChain();
+
+    // 設定取樣率並配置緩衝區（不可與 process() 同時呼叫）
+    void prepare(int sampleRate);
+
+    // 單一寫入端
+    void setParams(const Params &params);
+
+    // 交錯立體聲，就地處理
+    void process(float *io, int frames);
+
+    // 清除濾波器與限幅器的狀態（不可與 process() 同時呼叫）
+    void reset();
+
+    // 基準測試用：指定核心版本
+    void setKernels(const DspKernels &kernels) { m_kernels = &kernels; }
+
+    const char *kernelName() const { return m_kernels->name; }
+
+    // 限幅器的前瞻延遲
+    int latencyFrames() const { return m_limiter ? m_lookahead : 0; }
+
+private:
+    static constexpr int kBlock = 256;
+    static constexpr std::uint32_t kMinCapacity = 2048; // 滑動最小值的容量，需大於前瞻長度
+
+    void applyParams(const Params &p);
+
+    void processBlock(float *io, int n);
+
+    float limiterGain(float peak);
+
+    TripleBuffer<Params> m_params;
+    const DspKernels *m_kernels;
+    int m_rate = 48000;
+
+    // 等化器
+    bool m_eq = false;
+    float m_preamp = 1.0f;
+    Biquad m_coeffs[kBands];
+    BiquadState m_state[kBands];
+
+    // 限幅器
+    bool m_limiter = false;
+    float m_ceiling = 1.0f;
+    int m_lookahead = 0;
+    std::vector<float> m_delay; // [前瞻歷史 | 本區塊]
+    float m_peaks[kBlock]{};
+    float m_gains[kBlock]{};
+    float m_gain = 1.0f;
+    float m_attack = 1.0f;
+    float m_release = 1.0f;
+
+    // 所需增益在前瞻視窗內的最小值（單調佇列）
+    std::array<std::int64_t, kMinCapacity> m_minAt{};
+    std::array<float, kMinCapacity> m_minValue{};
+    std::uint32_t m_minHead = 0;
+    std::uint32_t m_minTail = 0;
+    std::int64_t m_frame = 0;
+};
@@ -0,0 +1,193 @@
+#include "DspKernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef MUSICPLAYER_X86
+#include <emmintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+namespace {
+    // 純量版本
+    void eqScalar(float *io, int frames, const Biquad *c, BiquadState *st, int bands, float preamp) {
+        for (int i = 0; i < frames; ++i) {
+            double x[2] = {io[2 * i] * double(preamp), io[2 * i + 1] * double(preamp)};
+            for (int b = 0; b < bands; ++b) {
+                const Biquad &k = c[b];
+                BiquadState &s = st[b];
+                for (int ch = 0; ch < 2; ++ch) {
+                    const double y = k.b0 * x[ch] + s.s1[ch];
+                    s.s1[ch] = k.b1 * x[ch] - k.a1 * y + s.s2[ch];
+                    s.s2[ch] = k.b2 * x[ch] - k.a2 * y;
+                    x[ch] = y;
+                }
+            }
+            io[2 * i] = static_cast<float>(x[0]);
+            io[2 * i + 1] = static_cast<float>(x[1]);
+        }
+    }
+
+    void peaksScalar(const float *in, float *peak, int frames) {
+        for (int i = 0; i < frames; ++i) peak[i] = std::max(std::fabs(in[2 * i]), std::fabs(in[2 * i + 1]));
+    }
+
+    void applyGainScalar(const float *in, float *out, const float *gain, int frames, float ceiling) {
+        for (int i = 0; i < frames; ++i) {
+            out[2 * i] = std::clamp(in[2 * i] * gain[i], -ceiling, ceiling);
+            out[2 * i + 1] = std::clamp(in[2 * i + 1] * gain[i], -ceiling, ceiling);
+        }
+    }
+
+    void butterfliesScalar(float *re, float *im, const float *wr, const float *wi, int half) {
+        for (int k = 0; k < half; ++k) {
+            const float tr = re[k + half] * wr[k] - im[k + half] * wi[k];
+            const float ti = re[k + half] * wi[k] + im[k + half] * wr[k];
+            re[k + half] = re[k] - tr;
+            im[k + half] = im[k] - ti;
+            re[k] += tr;
+            im[k] += ti;
+        }
+    }
+
+    void powerScalar(const float *re, const float *im, float *out, int n) {
+        for (int k = 0; k < n; ++k) out[k] = re[k] * re[k] + im[k] * im[k];
+    }
+
+#ifdef MUSICPLAYER_X86
+    // SSE2：左右聲道放在同一個 __m128d
+    void eqSse2(float *io, int frames, const Biquad *c, BiquadState *st, int bands, float preamp) {
+        constexpr int kMaxBands = 16;
+        __m128d b0[kMaxBands], b1[kMaxBands], b2[kMaxBands], a1[kMaxBands], a2[kMaxBands];
+        __m128d s1[kMaxBands], s2[kMaxBands];
+        bands = std::min(bands, kMaxBands);
+        for (int b = 0; b < bands; ++b) {
+            b0[b] = _mm_set1_pd(c[b].b0);
+            b1[b] = _mm_set1_pd(c[b].b1);
+            b2[b] = _mm_set1_pd(c[b].b2);
+            a1[b] = _mm_set1_pd(c[b].a1);
+            a2[b] = _mm_set1_pd(c[b].a2);
+            s1[b] = _mm_loadu_pd(st[b].s1);
+            s2[b] = _mm_loadu_pd(st[b].s2);
+        }
+        const __m128d pre = _mm_set1_pd(preamp);
+
+        for (int i = 0; i < frames; ++i) {
+            const __m128 in = _mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(io + 2 * i)));
+            __m128d x = _mm_mul_pd(_mm_cvtps_pd(in), pre);
+            for (int b = 0; b < bands; ++b) {
+                const __m128d y = _mm_add_pd(_mm_mul_pd(b0[b], x), s1[b]);
+                s1[b] = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(b1[b], x), _mm_mul_pd(a1[b], y)), s2[b]);
+                s2[b] = _mm_sub_pd(_mm_mul_pd(b2[b], x), _mm_mul_pd(a2[b], y));
+                x = y;
+            }
+            _mm_storel_pi(reinterpret_cast<__m64 *>(io + 2 * i), _mm_cvtpd_ps(x));
+        }
+
+        for (int b = 0; b < bands; ++b) {
+            _mm_storeu_pd(st[b].s1, s1[b]);
+            _mm_storeu_pd(st[b].s2, s2[b]);
+        }
+    }
+
+    // 一次兩個 frame：取絕對值後與相鄰聲道比大小
+    void peaksSse2(const float *in, float *peak, int frames) {
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+        int i = 0;
+        for (; i + 2 <= frames; i += 2) {
+            const __m128 v = _mm_and_ps(_mm_loadu_ps(in + 2 * i), absMask);
+            const __m128 m = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+            peak[i] = _mm_cvtss_f32(m);
+            peak[i + 1] = _mm_cvtss_f32(_mm_movehl_ps(m, m));
+        }
+        peaksScalar(in + 2 * i, peak + i, frames - i);
+    }
+
+    void applyGainSse2(const float *in, float *out, const float *gain, int frames, float ceiling) {
+        const __m128 hi = _mm_set1_ps(ceiling);
+        const __m128 lo = _mm_set1_ps(-ceiling);
+        int i = 0;
+        for (; i + 2 <= frames; i += 2) {
+            const __m128 g2 = _mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(gain + i)));
+            const __m128 g = _mm_unpacklo_ps(g2, g2); // g0 g0 g1 g1
+            const __m128 v = _mm_mul_ps(_mm_loadu_ps(in + 2 * i), g);
+            _mm_storeu_ps(out + 2 * i, _mm_max_ps(_mm_min_ps(v, hi), lo));
+        }
+        applyGainScalar(in + 2 * i, out + 2 * i, gain + i, frames - i, ceiling);
+    }
+
+    // 一次四個蝶形；前幾級 half < 4 時走純量
+    void butterfliesSse2(float *re, float *im, const float *wr, const float *wi, int half) {
+        int k = 0;
+        for (; k + 4 <= half; k += 4) {
+            const __m128 br = _mm_loadu_ps(re + k + half);
+            const __m128 bi = _mm_loadu_ps(im + k + half);
+            const __m128 w0 = _mm_loadu_ps(wr + k);
+            const __m128 w1 = _mm_loadu_ps(wi + k);
+            const __m128 tr = _mm_sub_ps(_mm_mul_ps(br, w0), _mm_mul_ps(bi, w1));
+            const __m128 ti = _mm_add_ps(_mm_mul_ps(br, w1), _mm_mul_ps(bi, w0));
+            const __m128 ar = _mm_loadu_ps(re + k);
+            const __m128 ai = _mm_loadu_ps(im + k);
+            _mm_storeu_ps(re + k + half, _mm_sub_ps(ar, tr));
+            _mm_storeu_ps(im + k + half, _mm_sub_ps(ai, ti));
+            _mm_storeu_ps(re + k, _mm_add_ps(ar, tr));
+            _mm_storeu_ps(im + k, _mm_add_ps(ai, ti));
+        }
+        if (k < half) butterfliesScalar(re + k, im + k, wr + k, wi + k, half - k);
+    }
+
+    void powerSse2(const float *re, const float *im, float *out, int n) {
+        int k = 0;
+        for (; k + 4 <= n; k += 4) {
+            const __m128 r = _mm_loadu_ps(re + k);
+            const __m128 i = _mm_loadu_ps(im + k);
+            _mm_storeu_ps(out + k, _mm_add_ps(_mm_mul_ps(r, r), _mm_mul_ps(i, i)));
+        }
+        powerScalar(re + k, im + k, out + k, n - k);
+    }
+
+    // AVX2 與 FMA 需要 CPU 與作業系統（XSAVE）都支援
+    bool cpuHasAvx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+        int r[4];
+        __cpuid(r, 1);
+        const bool osxsave = r[2] & (1 << 27);
+        const bool fma = r[2] & (1 << 12);
+        if (!osxsave || !fma || (_xgetbv(0) & 0x6) != 0x6) return false;
+        __cpuidex(r, 7, 0);
+        return r[1] & (1 << 5);
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+    }
+#endif
+}
+
+const DspKernels kScalarKernels{"scalar", eqScalar, peaksScalar, applyGainScalar, butterfliesScalar, powerScalar};
+
+#ifdef MUSICPLAYER_X86
+const DspKernels kSse2Kernels{"sse2", eqSse2, peaksSse2, applyGainSse2, butterfliesSse2, powerSse2};
+#endif
+
+const DspKernels &DspKernels::best() {
+#ifdef MUSICPLAYER_X86
+    static const DspKernels &k = cpuHasAvx2() ? kAvx2Kernels : kSse2Kernels;
+    return k;
+#else
+    return kScalarKernels;
+#endif
+}
+
+const DspKernels *const *DspKernels::available() {
+#ifdef MUSICPLAYER_X86
+    static const DspKernels *const withAvx2[] = {&kScalarKernels, &kSse2Kernels, &kAvx2Kernels, nullptr};
+    static const DspKernels *const sse2Only[] = {&kScalarKernels, &kSse2Kernels, nullptr};
+    return cpuHasAvx2() ? withAvx2 : sse2Only;
+#else
+    static const DspKernels *const scalarOnly[] = {&kScalarKernels, nullptr};
+    return scalarOnly;
+#endif
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+// DSP 的向量化核心（交錯立體聲 float，以及頻譜用的 FFT）
+// 依 CPU 在執行期選擇 AVX2+FMA、SSE2 或純量版本
+
+// 雙二階濾波器係數（已除以 a0）
+struct Biquad {
+    double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+};
+
+// Transposed Direct Form II 的狀態，左右聲道分開
+struct BiquadState {
+    double s1[2]{};
+    double s2[2]{};
+};
+
+struct DspKernels {
+    const char *name;
+
+    // 前級增益後串接 bands 個雙二階濾波器（就地處理）
+    void (*eq)(float *io, int frames, const Biquad *coeffs, BiquadState *state, int bands, float preamp);
+
+    // 每個 frame 的峰值 max(|L|, |R|)
+    void (*peaks)(const float *in, float *peak, int frames);
+
+    // out = clamp(in * gain[frame], ±ceiling)
+    void (*applyGain)(const float *in, float *out, const float *gain, int frames, float ceiling);
+
+    // 基 2 FFT 的一級（實部/虛部分開存放）：x[k] 與 x[k + half] 以旋轉因子 w[k] 合併
+    void (*butterflies)(float *re, float *im, const float *wr, const float *wi, int half);
+
+    // out[k] = re[k]² + im[k]²
+    void (*power)(const float *re, const float *im, float *out, int n);
+
+    // 這台機器上最快的版本
+    static const DspKernels &best();
+
+    // 所有可用版本（基準測試用），以 nullptr 結尾
+    static const DspKernels *const *available();
+};
+
+extern const DspKernels kScalarKernels;
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MUSICPLAYER_X86 1
+extern const DspKernels kSse2Kernels;
+extern const DspKernels kAvx2Kernels; // 定義在 DspKernelsAvx2.cpp（以 -mavx2 -mfma 編譯）
+#endif
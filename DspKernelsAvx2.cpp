@@ -0,0 +1,113 @@
+#include "DspKernels.h"
+
+// 這個檔案以 -mavx2 -mfma（MSVC：/arch:AVX2）編譯，只在執行期確認 CPU 支援後才會被呼叫
+#ifdef MUSICPLAYER_X86
+#include <immintrin.h>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // 雙二階串接：左右聲道一組 __m128d，以 FMA 計算
+    void eqAvx2(float *io, int frames, const Biquad *c, BiquadState *st, int bands, float preamp) {
+        constexpr int kMaxBands = 16;
+        __m128d b0[kMaxBands], b1[kMaxBands], b2[kMaxBands], a1[kMaxBands], a2[kMaxBands];
+        __m128d s1[kMaxBands], s2[kMaxBands];
+        bands = std::min(bands, kMaxBands);
+        for (int b = 0; b < bands; ++b) {
+            b0[b] = _mm_set1_pd(c[b].b0);
+            b1[b] = _mm_set1_pd(c[b].b1);
+            b2[b] = _mm_set1_pd(c[b].b2);
+            a1[b] = _mm_set1_pd(c[b].a1);
+            a2[b] = _mm_set1_pd(c[b].a2);
+            s1[b] = _mm_loadu_pd(st[b].s1);
+            s2[b] = _mm_loadu_pd(st[b].s2);
+        }
+        const __m128d pre = _mm_set1_pd(preamp);
+
+        for (int i = 0; i < frames; ++i) {
+            const __m128 in = _mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(io + 2 * i)));
+            __m128d x = _mm_mul_pd(_mm_cvtps_pd(in), pre);
+            for (int b = 0; b < bands; ++b) {
+                const __m128d y = _mm_fmadd_pd(b0[b], x, s1[b]);
+                s1[b] = _mm_fmadd_pd(b1[b], x, _mm_fnmadd_pd(a1[b], y, s2[b]));
+                s2[b] = _mm_fnmadd_pd(a2[b], y, _mm_mul_pd(b2[b], x));
+                x = y;
+            }
+            _mm_storel_pi(reinterpret_cast<__m64 *>(io + 2 * i), _mm_cvtpd_ps(x));
+        }
+
+        for (int b = 0; b < bands; ++b) {
+            _mm_storeu_pd(st[b].s1, s1[b]);
+            _mm_storeu_pd(st[b].s2, s2[b]);
+        }
+    }
+
+    // 一次四個 frame
+    void peaksAvx2(const float *in, float *peak, int frames) {
+        const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+        const __m256i evens = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+        int i = 0;
+        for (; i + 4 <= frames; i += 4) {
+            const __m256 v = _mm256_and_ps(_mm256_loadu_ps(in + 2 * i), absMask);
+            const __m256 m = _mm256_max_ps(v, _mm256_permute_ps(v, _MM_SHUFFLE(2, 3, 0, 1)));
+            _mm_storeu_ps(peak + i, _mm256_castps256_ps128(_mm256_permutevar8x32_ps(m, evens)));
+        }
+        for (; i < frames; ++i) peak[i] = std::max(std::abs(in[2 * i]), std::abs(in[2 * i + 1]));
+    }
+
+    void applyGainAvx2(const float *in, float *out, const float *gain, int frames, float ceiling) {
+        const __m256 hi = _mm256_set1_ps(ceiling);
+        const __m256 lo = _mm256_set1_ps(-ceiling);
+        const __m256i spread = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+        int i = 0;
+        for (; i + 4 <= frames; i += 4) {
+            const __m256 g = _mm256_permutevar8x32_ps(_mm256_castps128_ps256(_mm_loadu_ps(gain + i)), spread);
+            const __m256 v = _mm256_mul_ps(_mm256_loadu_ps(in + 2 * i), g);
+            _mm256_storeu_ps(out + 2 * i, _mm256_max_ps(_mm256_min_ps(v, hi), lo));
+        }
+        for (; i < frames; ++i) {
+            out[2 * i] = std::clamp(in[2 * i] * gain[i], -ceiling, ceiling);
+            out[2 * i + 1] = std::clamp(in[2 * i + 1] * gain[i], -ceiling, ceiling);
+        }
+    }
+
+    // 一次八個蝶形，以 FMA 計算複數乘法
+    void butterfliesAvx2(float *re, float *im, const float *wr, const float *wi, int half) {
+        int k = 0;
+        for (; k + 8 <= half; k += 8) {
+            const __m256 br = _mm256_loadu_ps(re + k + half);
+            const __m256 bi = _mm256_loadu_ps(im + k + half);
+            const __m256 w0 = _mm256_loadu_ps(wr + k);
+            const __m256 w1 = _mm256_loadu_ps(wi + k);
+            const __m256 tr = _mm256_fmsub_ps(br, w0, _mm256_mul_ps(bi, w1));
+            const __m256 ti = _mm256_fmadd_ps(br, w1, _mm256_mul_ps(bi, w0));
+            const __m256 ar = _mm256_loadu_ps(re + k);
+            const __m256 ai = _mm256_loadu_ps(im + k);
+            _mm256_storeu_ps(re + k + half, _mm256_sub_ps(ar, tr));
+            _mm256_storeu_ps(im + k + half, _mm256_sub_ps(ai, ti));
+            _mm256_storeu_ps(re + k, _mm256_add_ps(ar, tr));
+            _mm256_storeu_ps(im + k, _mm256_add_ps(ai, ti));
+        }
+        for (; k < half; ++k) {
+            const float tr = re[k + half] * wr[k] - im[k + half] * wi[k];
+            const float ti = re[k + half] * wi[k] + im[k + half] * wr[k];
+            re[k + half] = re[k] - tr;
+            im[k + half] = im[k] - ti;
+            re[k] += tr;
+            im[k] += ti;
+        }
+    }
+
+    void powerAvx2(const float *re, const float *im, float *out, int n) {
+        int k = 0;
+        for (; k + 8 <= n; k += 8) {
+            const __m256 r = _mm256_loadu_ps(re + k);
+            const __m256 i = _mm256_loadu_ps(im + k);
+            _mm256_storeu_ps(out + k, _mm256_fmadd_ps(r, r, _mm256_mul_ps(i, i)));
+        }
+        for (; k < n; ++k) out[k] = re[k] * re[k] + im[k] * im[k];
+    }
+}
+
+const DspKernels kAvx2Kernels{"avx2+fma", eqAvx2, peaksAvx2, applyGainAvx2, butterfliesAvx2, powerAvx2};
+#endif
@@ -0,0 +1,355 @@
+#include "DuplicateFinder.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSemaphore>
+#include <QSet>
+#include <QStandardPaths>
+#include <QThread>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    constexpr char kMagic[4] = {'M', 'P', 'H', 'S'};
+    constexpr quint32 kVersion = 1;
+    constexpr qint64 kBlock = 64 * 1024; // 部分雜湊：頭尾各一塊
+    constexpr qint64 kChunk = 4 * 1024 * 1024; // 完整雜湊每次映射的範圍
+
+    constexpr quint64 kPrime1 = 0x9E3779B185EBCA87ULL;
+    constexpr quint64 kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+    constexpr quint64 kPrime3 = 0x165667B19E3779F9ULL;
+    constexpr quint64 kPrime4 = 0x85EBCA77C2B2AE63ULL;
+    constexpr quint64 kPrime5 = 0x27D4EB2F165667C5ULL;
+
+    quint64 rotl(quint64 x, int r) { return (x << r) | (x >> (64 - r)); }
+
+    quint64 read64(const uchar *p) {
+        quint64 v;
+        memcpy(&v, p, 8);
+        return v;
+    }
+
+    quint32 read32(const uchar *p) {
+        quint32 v;
+        memcpy(&v, p, 4);
+        return v;
+    }
+
+    quint64 mixRound(quint64 acc, quint64 input) {
+        acc += input * kPrime2;
+        return rotl(acc, 31) * kPrime1;
+    }
+
+    quint64 mergeRound(quint64 acc, quint64 val) {
+        acc ^= mixRound(0, val);
+        return acc * kPrime1 + kPrime4;
+    }
+
+    // 以 seed 串接：每一段的結果當下一段的 seed；映射失敗時改用 read()
+    bool hashRange(QFile &file, qint64 off, qint64 len, quint64 &h) {
+        if (uchar *map = file.map(off, len)) {
+            h = DuplicateFinder::hash(map, len, h);
+            file.unmap(map);
+            return true;
+        }
+        if (!file.seek(off)) return false;
+        const QByteArray data = file.read(len);
+        if (data.size() != len) return false;
+        h = DuplicateFinder::hash(data.constData(), len, h);
+        return true;
+    }
+}
+
+DuplicateFinder::DuplicateFinder(QObject *parent)
+    : QObject(parent) {
+    m_coord.setMaxThreadCount(1);
+    m_coord.setThreadPriority(QThread::LowPriority);
+    // 讀檔以等待 I/O 為主：執行緒多於核心，讓磁碟佇列保持滿載
+    m_io.setMaxThreadCount(std::max(4, QThread::idealThreadCount() * 2));
+    m_io.setThreadPriority(QThread::LowPriority);
+}
+
+DuplicateFinder::~DuplicateFinder() {
+    m_canceled = true;
+    m_coord.clear();
+    m_coord.waitForDone();
+    m_io.waitForDone();
+    if (m_cacheDirty) saveCache();
+}
+
+QString DuplicateFinder::defaultPath() {
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dir);
+    return dir + "/hashes.idx";
+}
+
+void DuplicateFinder::add(const QStringList &paths, bool report) {
+    if (paths.isEmpty()) return;
+    const int generation = m_generation;
+    ++m_queued;
+    m_coord.start([this, paths, report, generation] {
+        process(paths, report, generation);
+        // 佇列清空時才寫快取，大量匯入不會每批都寫一次
+        if (--m_queued == 0 && m_cacheDirty) saveCache();
+    });
+}
+
+// 只從大小分組拿掉，m_files 的位置不動（索引順序代表加入先後）
+void DuplicateFinder::remove(const QStringList &paths) {
+    if (paths.isEmpty()) return;
+    const int generation = m_generation;
+    m_coord.start([this, paths, generation] {
+        if (m_canceled || generation != m_generation || generation != m_filesGeneration) return;
+        QHash<QString, int> pending;
+        for (const QString &path: paths) ++pending[path];
+        for (auto it = m_bySize.begin(); it != m_bySize.end();) {
+            it->removeIf([&](int i) {
+                const auto p = pending.find(m_files[i].path);
+                if (p == pending.end() || *p == 0) return false;
+                --*p;
+                return true;
+            });
+            it = it->isEmpty() ? m_bySize.erase(it) : std::next(it);
+        }
+    });
+}
+
+void DuplicateFinder::reset() {
+    ++m_generation;
+}
+
+// XXH64
+quint64 DuplicateFinder::hash(const void *data, qint64 len, quint64 seed) {
+    const auto *p = static_cast<const uchar *>(data);
+    const uchar *const end = p + len;
+    quint64 h;
+
+    if (len >= 32) {
+        quint64 v1 = seed + kPrime1 + kPrime2;
+        quint64 v2 = seed + kPrime2;
+        quint64 v3 = seed;
+        quint64 v4 = seed - kPrime1;
+        for (const uchar *limit = end - 32; p <= limit; p += 32) {
+            v1 = mixRound(v1, read64(p));
+            v2 = mixRound(v2, read64(p + 8));
+            v3 = mixRound(v3, read64(p + 16));
+            v4 = mixRound(v4, read64(p + 24));
+        }
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = mergeRound(h, v1);
+        h = mergeRound(h, v2);
+        h = mergeRound(h, v3);
+        h = mergeRound(h, v4);
+    } else {
+        h = seed + kPrime5;
+    }
+    h += static_cast<quint64>(len);
+
+    for (; p + 8 <= end; p += 8) h = rotl(h ^ mixRound(0, read64(p)), 27) * kPrime1 + kPrime4;
+    if (p + 4 <= end) {
+        h = rotl(h ^ (read32(p) * kPrime1), 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+    for (; p < end; ++p) h = rotl(h ^ (*p * kPrime5), 11) * kPrime1;
+
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+// 在 I/O 執行緒池上平行執行 fn(0..n-1)，做完才回傳
+template<typename F>
+void DuplicateFinder::parallelFor(qsizetype n, F &&fn) {
+    if (n <= 0) return;
+    std::atomic<qsizetype> next{0};
+    QSemaphore done;
+    const int workers = static_cast<int>(std::min<qsizetype>(n, m_io.maxThreadCount()));
+    for (int w = 0; w < workers; ++w) {
+        m_io.start([&] {
+            for (qsizetype i; !m_canceled && (i = next++) < n;) fn(i);
+            done.release();
+        });
+    }
+    done.acquire(workers);
+}
+
+void DuplicateFinder::process(const QStringList &paths, bool report, int generation) {
+    auto stale = [this, generation] { return m_canceled || generation != m_generation; };
+    if (stale()) return;
+    if (generation != m_filesGeneration) {
+        m_files.clear();
+        m_bySize.clear();
+        m_filesGeneration = generation;
+    }
+    loadCache();
+
+    // 1. 只 stat，大部分檔案到這裡就知道不可能重複
+    QVector<File> batch(paths.size());
+    parallelFor(paths.size(), [&](qsizetype i) {
+        const QFileInfo fi(paths[i]);
+        if (!fi.isFile() || fi.size() == 0) return;
+        File &f = batch[i];
+        f.path = paths[i];
+        f.size = fi.size();
+        f.mtime = fi.lastModified().toMSecsSinceEpoch();
+        f.report = report;
+    });
+    if (stale()) return;
+
+    const auto first = static_cast<int>(m_files.size());
+    QSet<qint64> sizes;
+    for (File &f: batch) {
+        if (f.path.isEmpty()) continue;
+        if (const auto it = m_cache.constFind(hashPath(f.path));
+            it != m_cache.cend() && it->size == f.size && it->mtime == f.mtime) {
+            f.partial = it->partial;
+            f.hasPartial = true;
+            f.full = it->full;
+            f.hasFull = it->full != 0;
+        }
+        m_bySize[f.size].push_back(static_cast<int>(m_files.size()));
+        if (report) sizes.insert(f.size);
+        m_files.push_back(std::move(f));
+    }
+    if (sizes.isEmpty()) return;
+
+    // 2. 同大小的：頭尾部分雜湊
+    QVector<int> need;
+    for (const qint64 size: sizes) {
+        const QVector<int> &bucket = m_bySize[size];
+        if (bucket.size() < 2) continue;
+        for (const int i: bucket) {
+            if (!m_files[i].hasPartial) need.push_back(i);
+        }
+    }
+    hashFiles(need, false);
+    if (stale()) return;
+
+    // 3. 部分雜湊也相同且含有新檔案的：完整雜湊
+    need.clear();
+    for (const qint64 size: sizes) {
+        const QVector<int> &bucket = m_bySize[size];
+        QHash<quint64, QVector<int>> groups;
+        for (const int i: bucket) {
+            if (m_files[i].hasPartial) groups[m_files[i].partial].push_back(i);
+        }
+        for (const QVector<int> &group: std::as_const(groups)) {
+            if (group.size() < 2 || group.back() < first) continue;
+            for (const int i: group) {
+                if (!m_files[i].hasFull) need.push_back(i);
+            }
+        }
+    }
+    hashFiles(need, true);
+    if (stale()) return;
+
+    // 4. 每個新檔案對應到最早加入的相同內容
+    QStringList dups;
+    QStringList originals;
+    for (const qint64 size: sizes) {
+        QHash<quint64, int> earliest;
+        for (const int i: m_bySize[size]) {
+            const File &f = m_files[i];
+            if (!f.hasFull) continue;
+            const auto it = earliest.constFind(f.full);
+            if (it == earliest.cend()) {
+                earliest.insert(f.full, i);
+            } else if (i >= first && f.report && m_files[*it].path != f.path) {
+                dups.push_back(f.path);
+                originals.push_back(m_files[*it].path);
+            }
+        }
+    }
+    if (!dups.isEmpty() && !stale()) emit duplicatesFound(dups, originals);
+}
+
+// 小檔案的部分雜湊就是完整雜湊
+void DuplicateFinder::hashFiles(const QVector<int> &indexes, bool full) {
+    if (indexes.isEmpty()) return;
+    parallelFor(indexes.size(), [&](qsizetype n) {
+        File &f = m_files[indexes[n]];
+        QFile file(f.path);
+        if (!file.open(QIODevice::ReadOnly)) return;
+        quint64 h = static_cast<quint64>(f.size);
+        if (!full && f.size > 2 * kBlock) {
+            if (hashRange(file, 0, kBlock, h) && hashRange(file, f.size - kBlock, kBlock, h)) {
+                f.partial = h;
+                f.hasPartial = true;
+            }
+            return;
+        }
+        for (qint64 off = 0; off < f.size; off += kChunk) {
+            if (m_canceled || !hashRange(file, off, std::min(kChunk, f.size - off), h)) return;
+        }
+        f.full = h;
+        f.hasFull = true;
+        if (!f.hasPartial) {
+            f.partial = h;
+            f.hasPartial = true;
+        }
+    });
+
+    for (const int i: indexes) {
+        const File &f = m_files[i];
+        if (!f.hasPartial) continue;
+        m_cache.insert(hashPath(f.path), Entry{hashPath(f.path), f.size, f.mtime, f.partial, f.hasFull ? f.full : 0});
+        m_cacheDirty = true;
+    }
+}
+
+void DuplicateFinder::loadCache() {
+    if (m_cacheLoaded) return;
+    m_cacheLoaded = true;
+
+    QFile file(defaultPath());
+    if (!file.open(QIODevice::ReadOnly)) return;
+    const QByteArray data = file.readAll();
+    Header h{};
+    if (data.size() < static_cast<qsizetype>(sizeof(Header))) return;
+    memcpy(&h, data.constData(), sizeof(Header));
+    if (memcmp(h.magic, kMagic, 4) != 0 || h.version != kVersion ||
+        sizeof(Header) + static_cast<qint64>(h.count) * sizeof(Entry) > data.size()) {
+        qWarning() << "hash cache invalid, ignoring:" << file.fileName();
+        return;
+    }
+    const auto *entries = reinterpret_cast<const Entry *>(data.constData() + sizeof(Header));
+    m_cache.reserve(h.count);
+    for (quint32 i = 0; i < h.count; ++i) {
+        Entry e;
+        memcpy(&e, entries + i, sizeof(Entry));
+        m_cache.insert(e.pathHash, e);
+    }
+}
+
+void DuplicateFinder::saveCache() {
+    QVector<Entry> entries(m_cache.cbegin(), m_cache.cend());
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return a.pathHash < b.pathHash; });
+
+    Header h{};
+    memcpy(h.magic, kMagic, 4);
+    h.version = kVersion;
+    h.count = static_cast<quint32>(entries.size());
+
+    QSaveFile out(defaultPath());
+    if (!out.open(QIODevice::WriteOnly)) return;
+    out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+    out.write(reinterpret_cast<const char *>(entries.constData()), entries.size() * qsizetype(sizeof(Entry)));
+    if (out.commit()) m_cacheDirty = false;
+}
+
+// FNV-1a（與 MetadataIndex 相同）
+quint64 DuplicateFinder::hashPath(const QString &path) {
+    quint64 h = 14695981039346656037ULL;
+    for (const QChar c: path) {
+        h ^= c.unicode();
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
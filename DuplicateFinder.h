@@ -0,0 +1,96 @@
+#pragma once
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+#include <atomic>
+
+// 背景找出內容完全相同的檔案（不同路徑的同一份拷貝）
+//
+// 先依檔案大小分組，只有同大小的才讀檔：先雜湊頭尾各一塊，相同的才雜湊整個檔案（XXH64，記憶體映射）。
+// 雜湊以路徑 + 大小 + 修改時間快取並持久化，重新匯入同一個音樂庫不必再讀檔。
+//
+// 快取檔格式 (little-endian)：
+//   Header  { magic "MPHS", version, count, reserved }
+//   Entry[count]  { pathHash, size, mtime, partial, full }（full = 0 表示尚未計算）
+class DuplicateFinder final : public QObject {
+    Q_OBJECT
+
+public:
+    explicit DuplicateFinder(QObject *parent = nullptr);
+
+    ~DuplicateFinder() override;
+
+    // 與先前加入的所有檔案比對；report 為 false 時只當作比對基準（例如清單中原有的曲目）
+    void add(const QStringList &paths, bool report = true);
+
+    // 從清單移除的檔案不再當作比對基準（同一路徑出現幾次就移除幾筆）
+    void remove(const QStringList &paths);
+
+    // 清單清空：忘掉已加入的檔案（雜湊快取保留）
+    void reset();
+
+    static quint64 hash(const void *data, qint64 len, quint64 seed = 0);
+
+    static QString defaultPath();
+
+signals:
+    // paths[i] 與 originals[i] 內容相同，originals[i] 較早加入
+    void duplicatesFound(const QStringList &paths, const QStringList &originals);
+
+private:
+    struct File {
+        QString path;
+        qint64 size = 0;
+        qint64 mtime = 0;
+        quint64 partial = 0;
+        quint64 full = 0;
+        bool hasPartial = false;
+        bool hasFull = false;
+        bool report = false;
+    };
+
+    struct Entry {
+        quint64 pathHash;
+        qint64 size;
+        qint64 mtime;
+        quint64 partial;
+        quint64 full;
+    };
+
+    struct Header {
+        char magic[4];
+        quint32 version;
+        quint32 count;
+        quint32 reserved;
+    };
+
+    // 以下都在協調執行緒上執行
+    void process(const QStringList &paths, bool report, int generation);
+
+    template<typename F>
+    void parallelFor(qsizetype n, F &&fn);
+
+    void hashFiles(const QVector<int> &indexes, bool full);
+
+    void loadCache();
+
+    void saveCache();
+
+    static quint64 hashPath(const QString &path);
+
+    QThreadPool m_coord; // 單一執行緒：依序處理每一批，擁有下面的狀態
+    QThreadPool m_io; // 平行讀檔，多個請求同時在磁碟佇列中
+    std::atomic<bool> m_canceled{false};
+    std::atomic<int> m_generation{0};
+    std::atomic<int> m_queued{0};
+
+    QVector<File> m_files;
+    QHash<qint64, QVector<int>> m_bySize;
+    int m_filesGeneration = 0;
+
+    QHash<quint64, Entry> m_cache;
+    bool m_cacheLoaded = false;
+    bool m_cacheDirty = false;
+};
@@ -0,0 +1,162 @@
+#include "EqualizerDialog.h"
+
+#include <QBoxLayout>
+#include <QCheckBox>
+#include <QComboBox>
+#include <QLabel>
+#include <QSettings>
+#include <QSlider>
+#include <algorithm>
+
+namespace {
+    constexpr int kRangeDb = 12;
+
+    QString bandName(float hz) {
+        return hz >= 1000 ? QString("%1k").arg(hz / 1000) : QString::number(hz);
+    }
+
+    QSlider *makeBandSlider(QWidget *parent) {
+        auto *s = new QSlider(Qt::Vertical, parent);
+        s->setRange(-kRangeDb, kRangeDb);
+        s->setTickPosition(QSlider::TicksBothSides);
+        s->setTickInterval(6);
+        s->setMinimumHeight(140);
+        return s;
+    }
+}
+
+EqualizerDialog::EqualizerDialog(const char *kernelName, QWidget *parent)
+    : QDialog(parent) {
+    setWindowTitle("Equalizer");
+
+    m_enabled = new QCheckBox("Enable equalizer", this);
+    m_preset = new QComboBox(this);
+    for (const DspChain::Preset &p: DspChain::presets()) m_preset->addItem(p.name);
+    m_preset->addItem("Custom");
+
+    const auto top = new QHBoxLayout();
+    top->addWidget(m_enabled);
+    top->addStretch(1);
+    top->addWidget(new QLabel("Preset:", this));
+    top->addWidget(m_preset);
+
+    // 前級 + 10 段
+    const auto sliders = new QHBoxLayout();
+    auto addColumn = [&](QSlider *s, QLabel *value, const QString &name) {
+        const auto col = new QVBoxLayout();
+        value->setAlignment(Qt::AlignHCenter);
+        col->addWidget(value);
+        col->addWidget(s, 1, Qt::AlignHCenter);
+        auto *label = new QLabel(name, this);
+        label->setAlignment(Qt::AlignHCenter);
+        col->addWidget(label);
+        sliders->addLayout(col);
+    };
+
+    m_preamp = makeBandSlider(this);
+    auto *preampValue = new QLabel("0", this);
+    addColumn(m_preamp, preampValue, "Preamp");
+    sliders->addSpacing(12);
+    connect(m_preamp, &QSlider::valueChanged, this, [this, preampValue](int v) {
+        preampValue->setText(QString::number(v));
+        emitChanged();
+    });
+
+    for (int b = 0; b < DspChain::kBands; ++b) {
+        m_bands[b] = makeBandSlider(this);
+        m_bandValues[b] = new QLabel("0", this);
+        addColumn(m_bands[b], m_bandValues[b], bandName(DspChain::kBandHz[b]));
+        connect(m_bands[b], &QSlider::valueChanged, this, [this, b](int v) {
+            m_bandValues[b]->setText(QString::number(v));
+            if (!m_updating) {
+                m_updating = true;
+                m_preset->setCurrentIndex(m_preset->count() - 1); // 手動調整 → Custom
+                m_updating = false;
+            }
+            emitChanged();
+        });
+    }
+
+    m_limiter = new QCheckBox("Limiter (prevents clipping)", this);
+    auto *kernel = new QLabel(QString("DSP kernels: %1").arg(kernelName), this);
+    kernel->setStyleSheet("color: #888888;");
+
+    const auto bottom = new QHBoxLayout();
+    bottom->addWidget(m_limiter);
+    bottom->addStretch(1);
+    bottom->addWidget(kernel);
+
+    const auto root = new QVBoxLayout(this);
+    root->addLayout(top);
+    root->addLayout(sliders, 1);
+    root->addLayout(bottom);
+
+    connect(m_enabled, &QCheckBox::toggled, this, &EqualizerDialog::emitChanged);
+    connect(m_limiter, &QCheckBox::toggled, this, &EqualizerDialog::emitChanged);
+    connect(m_preset, &QComboBox::activated, this, &EqualizerDialog::applyPreset);
+}
+
+void EqualizerDialog::setParams(const DspChain::Params &params) {
+    m_updating = true;
+    m_enabled->setChecked(params.eqEnabled);
+    m_preamp->setValue(qRound(params.preampDb));
+    for (int b = 0; b < DspChain::kBands; ++b) m_bands[b]->setValue(qRound(params.bandDb[b]));
+    m_limiter->setChecked(params.limiter);
+
+    // 符合某個預設就選它
+    int match = m_preset->count() - 1;
+    const auto presets = DspChain::presets();
+    for (int i = 0; i < static_cast<int>(presets.size()); ++i) {
+        if (std::equal(std::begin(presets[i].bandDb), std::end(presets[i].bandDb), std::begin(params.bandDb))) {
+            match = i;
+            break;
+        }
+    }
+    m_preset->setCurrentIndex(match);
+    m_updating = false;
+}
+
+DspChain::Params EqualizerDialog::params() const {
+    DspChain::Params p;
+    p.eqEnabled = m_enabled->isChecked();
+    p.preampDb = static_cast<float>(m_preamp->value());
+    for (int b = 0; b < DspChain::kBands; ++b) p.bandDb[b] = static_cast<float>(m_bands[b]->value());
+    p.limiter = m_limiter->isChecked();
+    return p;
+}
+
+void EqualizerDialog::applyPreset(int index) {
+    const auto presets = DspChain::presets();
+    if (index < 0 || index >= static_cast<int>(presets.size())) return;
+    m_updating = true;
+    for (int b = 0; b < DspChain::kBands; ++b) m_bands[b]->setValue(qRound(presets[index].bandDb[b]));
+    m_updating = false;
+    if (!m_enabled->isChecked()) m_enabled->setChecked(true);
+    emitChanged();
+}
+
+void EqualizerDialog::emitChanged() {
+    if (m_updating) return;
+    emit paramsChanged(params());
+}
+
+DspChain::Params EqualizerDialog::loadSettings() {
+    QSettings s;
+    DspChain::Params p;
+    p.eqEnabled = s.value("dsp/eq", false).toBool();
+    p.preampDb = s.value("dsp/preamp", 0.0).toFloat();
+    const QVariantList bands = s.value("dsp/bands").toList();
+    for (int b = 0; b < DspChain::kBands && b < bands.size(); ++b) p.bandDb[b] = bands[b].toFloat();
+    p.limiter = s.value("dsp/limiter", true).toBool();
+    return p;
+}
+
+void EqualizerDialog::saveSettings(const DspChain::Params &params) {
+    QSettings s;
+    s.setValue("dsp/eq", params.eqEnabled);
+    s.setValue("dsp/preamp", params.preampDb);
+    QVariantList bands;
+    for (const float db: params.bandDb) bands.push_back(db);
+    s.setValue("dsp/bands", bands);
+    s.setValue("dsp/limiter", params.limiter);
+}
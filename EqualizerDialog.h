@@ -0,0 +1,41 @@
+#pragma once
+#include <QDialog>
+#include "DspChain.h"
+
+class QCheckBox;
+class QComboBox;
+class QLabel;
+class QSlider;
+
+// 等化器視窗：10 段、前級、預設組合與限幅器
+class EqualizerDialog final : public QDialog {
+    Q_OBJECT
+
+public:
+    explicit EqualizerDialog(const char *kernelName, QWidget *parent = nullptr);
+
+    void setParams(const DspChain::Params &params);
+
+    DspChain::Params params() const;
+
+    // QSettings 讀寫
+    static DspChain::Params loadSettings();
+
+    static void saveSettings(const DspChain::Params &params);
+
+signals:
+    void paramsChanged(const DspChain::Params &params);
+
+private:
+    void applyPreset(int index);
+
+    void emitChanged();
+
+    QCheckBox *m_enabled{};
+    QComboBox *m_preset{};
+    QSlider *m_preamp{};
+    QSlider *m_bands[DspChain::kBands]{};
+    QLabel *m_bandValues[DspChain::kBands]{};
+    QCheckBox *m_limiter{};
+    bool m_updating = false;
+};
@@ -0,0 +1,178 @@
+#include "FormatSniffer.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QVector>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    constexpr char kMagic[4] = {'M', 'P', 'F', 'S'};
+    constexpr quint32 kVersion = 1;
+    constexpr int kMaxTags = 4; // 連續的 ID3 標籤
+
+    bool startsWith(QByteArrayView head, qsizetype off, const char *magic) {
+        const auto n = static_cast<qsizetype>(strlen(magic));
+        return head.size() >= off + n && memcmp(head.data() + off, magic, n) == 0;
+    }
+
+    // MPEG 音訊幀頭：11 位同步、layer 不為保留值、位元率與取樣率不為無效值
+    bool isMpegFrame(const uchar *p) {
+        return p[0] == 0xFF && (p[1] & 0xE0) == 0xE0 && (p[1] & 0x18) != 0x08 && (p[1] & 0x06) != 0
+               && (p[2] & 0xF0) != 0xF0 && (p[2] & 0x0C) != 0x0C;
+    }
+
+    // ADTS（AAC）：12 位同步、layer = 0、取樣率索引有效
+    bool isAdtsFrame(const uchar *p) {
+        return p[0] == 0xFF && (p[1] & 0xF6) == 0xF0 && ((p[2] >> 2) & 0x0F) < 13;
+    }
+
+    // ID3v2 標籤總長度（含檔頭與 footer）；不是 ID3 時回傳 0
+    qint64 id3Size(QByteArrayView head) {
+        if (head.size() < 10 || !startsWith(head, 0, "ID3")) return 0;
+        const auto *p = reinterpret_cast<const uchar *>(head.data());
+        if ((p[6] | p[7] | p[8] | p[9]) & 0x80) return 0; // synchsafe 整數每個位元組只有 7 位
+        const qint64 size = (qint64(p[6]) << 21) | (qint64(p[7]) << 14) | (qint64(p[8]) << 7) | p[9];
+        return 10 + size + ((p[5] & 0x10) ? 10 : 0);
+    }
+}
+
+FormatSniffer::~FormatSniffer() {
+    save();
+}
+
+QString FormatSniffer::defaultPath() {
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dir);
+    return dir + "/formats.idx";
+}
+
+// 讀鎖查表；未命中才開檔，寫鎖只在插入時持有
+FormatSniffer::Format FormatSniffer::format(const QString &path, qint64 size, qint64 mtime) {
+    const quint64 key = hashPath(path);
+    {
+        QReadLocker lock(&m_lock);
+        if (m_loaded) {
+            if (const auto it = m_cache.constFind(key); it != m_cache.cend() && it->size == size && it->mtime == mtime)
+                return static_cast<Format>(it->format);
+        }
+    }
+    {
+        QWriteLocker lock(&m_lock);
+        if (!m_loaded) load();
+        if (const auto it = m_cache.constFind(key); it != m_cache.cend() && it->size == size && it->mtime == mtime)
+            return static_cast<Format>(it->format);
+    }
+
+    const Format f = sniffFile(path);
+    QWriteLocker lock(&m_lock);
+    m_cache.insert(key, Entry{key, size, mtime, f, 0});
+    m_dirty = true;
+    return f;
+}
+
+// 容器格式的魔術字從檔頭固定位置開始（ISO-BMFF 的 box 大小本身就以 0 開頭），先比對；
+// 幀串流（MP3、AAC）在 ID3 標籤之後可能有補零，跳過後再找同步字
+FormatSniffer::Format FormatSniffer::sniff(QByteArrayView head) {
+    if (head.size() < 4) return Unreadable;
+    if (startsWith(head, 0, "fLaC")) return Flac;
+    if (startsWith(head, 0, "OggS")) return Ogg;
+    if ((startsWith(head, 0, "RIFF") || startsWith(head, 0, "RF64")) && startsWith(head, 8, "WAVE")) return Wave;
+    if (startsWith(head, 4, "ftyp")) return Mp4;
+
+    qsizetype off = 0;
+    while (off < head.size() && head[off] == '\0') ++off;
+    head = head.sliced(off);
+    if (head.size() < 4) return Unreadable;
+    const auto *p = reinterpret_cast<const uchar *>(head.data());
+    if (isAdtsFrame(p)) return Adts;
+    if (isMpegFrame(p)) return Mpeg;
+    return Unsupported;
+}
+
+FormatSniffer::Format FormatSniffer::sniffFile(const QString &path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return Unreadable;
+    QByteArray head = file.read(kHeadBytes);
+    for (int i = 0; i < kMaxTags; ++i) {
+        const qint64 tag = id3Size(head);
+        if (tag == 0) break;
+        if (tag >= file.size()) return Unreadable; // 只有標籤，沒有音訊
+        if (!file.seek(tag)) return Unreadable;
+        head = file.read(kHeadBytes);
+    }
+    return sniff(head);
+}
+
+QString FormatSniffer::describe(Format f) {
+    switch (f) {
+        case Mpeg: return "MPEG audio";
+        case Adts: return "AAC (ADTS)";
+        case Wave: return "WAVE";
+        case Flac: return "FLAC";
+        case Ogg: return "Ogg";
+        case Mp4: return "MP4/M4A";
+        case Unsupported: return "Unsupported format";
+        case Unreadable: return "Unreadable or truncated file";
+        default: return "Unknown";
+    }
+}
+
+void FormatSniffer::save() {
+    QVector<Entry> entries;
+    {
+        QReadLocker lock(&m_lock);
+        if (!m_dirty) return;
+        entries = QVector<Entry>(m_cache.cbegin(), m_cache.cend());
+    }
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return a.pathHash < b.pathHash; });
+
+    Header h{};
+    memcpy(h.magic, kMagic, 4);
+    h.version = kVersion;
+    h.count = static_cast<quint32>(entries.size());
+
+    QSaveFile out(defaultPath());
+    if (!out.open(QIODevice::WriteOnly)) return;
+    out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+    out.write(reinterpret_cast<const char *>(entries.constData()), entries.size() * qsizetype(sizeof(Entry)));
+    if (out.commit()) {
+        QWriteLocker lock(&m_lock);
+        m_dirty = false;
+    }
+}
+
+void FormatSniffer::load() {
+    m_loaded = true;
+    QFile file(defaultPath());
+    if (!file.open(QIODevice::ReadOnly)) return;
+    const QByteArray data = file.readAll();
+    Header h{};
+    if (data.size() < static_cast<qsizetype>(sizeof(Header))) return;
+    memcpy(&h, data.constData(), sizeof(Header));
+    if (memcmp(h.magic, kMagic, 4) != 0 || h.version != kVersion ||
+        sizeof(Header) + static_cast<qint64>(h.count) * sizeof(Entry) > data.size()) {
+        qWarning() << "format cache invalid, ignoring:" << file.fileName();
+        return;
+    }
+    const auto *entries = reinterpret_cast<const Entry *>(data.constData() + sizeof(Header));
+    m_cache.reserve(h.count);
+    for (quint32 i = 0; i < h.count; ++i) {
+        Entry e;
+        memcpy(&e, entries + i, sizeof(Entry));
+        m_cache.insert(e.pathHash, e);
+    }
+}
+
+// FNV-1a（與 MetadataIndex 相同）
+quint64 FormatSniffer::hashPath(const QString &path) {
+    quint64 h = 14695981039346656037ULL;
+    for (const QChar c: path) {
+        h ^= c.unicode();
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
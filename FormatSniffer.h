@@ -0,0 +1,79 @@
+#pragma once
+#include <QByteArrayView>
+#include <QHash>
+#include <QReadWriteLock>
+#include <QString>
+
+// 依檔頭判斷音訊格式，不看副檔名：ID3（跳過標籤）/MPEG 同步字、ADTS、RIFF/WAVE、fLaC、OggS、ftyp
+//
+// 結果以路徑 + 大小 + 修改時間快取並持久化，重新匯入同一個音樂庫時只查表、不開檔。
+// format() 可以同時從多個執行緒呼叫。
+//
+// 快取檔格式 (little-endian)：
+//   Header  { magic "MPFS", version, count, reserved }
+//   Entry[count]  { pathHash, size, mtime, format, reserved }
+class FormatSniffer final {
+public:
+    enum Format : quint8 {
+        Unknown, // 尚未判斷
+        Mpeg,
+        Adts,
+        Wave,
+        Flac,
+        Ogg,
+        Mp4,
+        Unsupported, // 讀得到，但不是認得的音訊格式
+        Unreadable // 打不開、讀不到或太短
+    };
+
+    static constexpr int kHeadBytes = 512;
+
+    FormatSniffer() = default;
+
+    ~FormatSniffer();
+
+    FormatSniffer(const FormatSniffer &) = delete;
+
+    FormatSniffer &operator=(const FormatSniffer &) = delete;
+
+    // 快取命中時不碰檔案
+    Format format(const QString &path, qint64 size, qint64 mtime);
+
+    // 有新結果時寫回
+    void save();
+
+    static Format sniff(QByteArrayView head);
+
+    static Format sniffFile(const QString &path);
+
+    static bool isAudio(Format f) { return f >= Mpeg && f <= Mp4; }
+
+    static QString describe(Format f);
+
+    static QString defaultPath();
+
+private:
+    struct Entry {
+        quint64 pathHash;
+        qint64 size;
+        qint64 mtime;
+        quint32 format;
+        quint32 reserved;
+    };
+
+    struct Header {
+        char magic[4];
+        quint32 version;
+        quint32 count;
+        quint32 reserved;
+    };
+
+    void load(); // 呼叫端持有寫入鎖
+
+    static quint64 hashPath(const QString &path);
+
+    QReadWriteLock m_lock;
+    QHash<quint64, Entry> m_cache;
+    bool m_loaded = false;
+    bool m_dirty = false;
+};
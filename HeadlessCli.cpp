@@ -0,0 +1,285 @@
+#include "HeadlessCli.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+#include <QThreadPool>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include "LibraryImporter.h"
+#include "M3UPlaylist.h"
+#include "MetadataIndex.h"
+
+namespace {
+    const char *const kCommands[] = {"scan", "validate", "info"};
+
+    bool isPlaylist(const QString &path) {
+        return path.endsWith(".m3u", Qt::CaseInsensitive) || path.endsWith(".m3u8", Qt::CaseInsensitive);
+    }
+
+    QString absolute(const QString &path) {
+        return QDir::cleanPath(QFileInfo(path).absoluteFilePath());
+    }
+
+    void fail(const QString &message) {
+        std::fprintf(stderr, "MusicPlayer: %s\n", qPrintable(message));
+    }
+
+    void print(const QJsonObject &result, bool pretty) {
+        const QByteArray json = QJsonDocument(result).toJson(pretty ? QJsonDocument::Indented
+                                                                    : QJsonDocument::Compact);
+        std::fwrite(json.constData(), 1, json.size(), stdout);
+        if (!pretty) std::fputc('\n', stdout);
+        std::fflush(stdout);
+    }
+
+    QJsonArray toJson(const QStringList &list) {
+        return QJsonArray::fromStringList(list);
+    }
+
+    // 與 GUI 共用的索引；--no-index 時直接讀檔，不動使用者的索引
+    std::unique_ptr<MetadataIndex> openIndex(const QCommandLineParser &cli) {
+        if (cli.isSet("no-index")) return nullptr;
+        auto index = std::make_unique<MetadataIndex>();
+        index->open(cli.value("index"));
+        return index;
+    }
+
+    // 讀取標籤：有索引時只處理變更過的檔案，否則平行直接解析
+    QVector<std::optional<TrackInfo>> readInfos(const QStringList &paths, MetadataIndex *index) {
+        QVector<std::optional<TrackInfo>> infos(paths.size());
+        if (index) {
+            index->scan(paths);
+            index->waitForDone();
+            for (qsizetype i = 0; i < paths.size(); ++i) infos[i] = index->find(paths.at(i));
+            return infos;
+        }
+
+        std::optional<TrackInfo> *out = infos.data(); // 每個工作只寫自己的格子
+        QThreadPool pool;
+        pool.setMaxThreadCount(std::max(2, QThread::idealThreadCount()));
+        constexpr qsizetype kChunk = 64;
+        for (qsizetype i = 0; i < paths.size(); i += kChunk) {
+            pool.start([&, i] {
+                const qsizetype last = std::min(i + kChunk, paths.size());
+                for (qsizetype j = i; j < last; ++j) {
+                    TrackInfo info;
+                    if (TagReader::read(paths.at(j), info)) out[j] = info;
+                }
+            });
+        }
+        pool.waitForDone();
+        return infos;
+    }
+
+    QString playlistTitle(const TrackInfo &info) {
+        return info.artist.isEmpty() ? info.title : info.artist + " – " + info.title;
+    }
+
+    // scan：遞迴匯入資料夾（與拖放相同的 LibraryImporter），可更新索引並寫成清單
+    int scan(const QCommandLineParser &cli, const QStringList &inputs) {
+        if (inputs.isEmpty()) {
+            fail("scan: no folders given");
+            return HeadlessCli::Usage;
+        }
+        QList<QUrl> urls;
+        QStringList missing;
+        for (const QString &in: inputs) {
+            if (QFileInfo::exists(in)) urls.push_back(QUrl::fromLocalFile(absolute(in)));
+            else missing.push_back(in);
+        }
+
+        LibraryImporter importer;
+        QList<QUrl> found;
+        int scanned = 0;
+        bool canceled = false;
+        QEventLoop loop;
+        QObject::connect(&importer, &LibraryImporter::batchReady, [&](const QList<QUrl> &batch) {
+            found.append(batch);
+        });
+        QObject::connect(&importer, &LibraryImporter::progress, [&](int s, int) { scanned = s; });
+        QObject::connect(&importer, &LibraryImporter::finished, [&](bool c) {
+            canceled = c;
+            loop.quit();
+        });
+        importer.start(urls);
+        loop.exec();
+
+        QStringList paths;
+        paths.reserve(found.size());
+        for (const QUrl &u: std::as_const(found)) {
+            if (u.isLocalFile()) paths.push_back(u.toLocalFile());
+        }
+
+        const auto index = openIndex(cli);
+        QJsonObject result{{"command", "scan"}, {"scanned", scanned}, {"accepted", qint64(found.size())},
+                           {"missing", toJson(missing)}};
+
+        const QString output = cli.value("output");
+        if (index || !output.isEmpty()) {
+            const auto infos = readInfos(paths, index.get());
+            result["indexed"] = index ? index->count() : 0;
+            if (!output.isEmpty()) {
+                QVector<PlaylistEntry> entries;
+                entries.reserve(paths.size());
+                for (qsizetype i = 0; i < paths.size(); ++i) {
+                    PlaylistEntry e{QUrl::fromLocalFile(paths.at(i)), {}, -1};
+                    if (const auto &info = infos.at(i)) {
+                        e.title = playlistTitle(*info);
+                        if (info->durationMs > 0) e.durationMs = info->durationMs;
+                    }
+                    entries.push_back(std::move(e));
+                }
+                QString error;
+                if (!M3UPlaylist::save(output, entries, QFileInfo(output).absolutePath(), &error)) {
+                    fail(output + ": " + error);
+                    return HeadlessCli::IoError;
+                }
+                result["output"] = absolute(output);
+            }
+        }
+        if (cli.isSet("list")) result["files"] = toJson(paths);
+        print(result, cli.isSet("pretty"));
+        return canceled || !missing.isEmpty() ? HeadlessCli::Problems : HeadlessCli::Ok;
+    }
+
+    // validate：列出清單中找不到的項目；--rewrite 去掉遺失項目並重新寫出
+    int validate(const QCommandLineParser &cli, const QStringList &inputs) {
+        const QString output = cli.value("output");
+        if (inputs.isEmpty() || (!output.isEmpty() && inputs.size() != 1)) {
+            fail("validate: give one or more playlists (-o needs exactly one)");
+            return HeadlessCli::Usage;
+        }
+        const QStringList searchDirs = cli.values("search-dir");
+        const bool rewrite = cli.isSet("rewrite") || !output.isEmpty();
+
+        QJsonArray playlists;
+        int exit = HeadlessCli::Ok;
+        for (const QString &file: inputs) {
+            QString error;
+            QStringList missing;
+            const QVector<PlaylistEntry> entries = M3UPlaylist::load(file, searchDirs, &error, &missing);
+            QJsonObject item{{"playlist", absolute(file)}};
+            if (!error.isEmpty()) {
+                item["error"] = error;
+                playlists.push_back(item);
+                exit = HeadlessCli::IoError;
+                continue;
+            }
+            item["entries"] = qint64(entries.size() + missing.size());
+            item["valid"] = qint64(entries.size());
+            item["missing"] = toJson(missing);
+
+            if (rewrite) {
+                const QString target = output.isEmpty() ? file : output;
+                if (M3UPlaylist::save(target, entries, QFileInfo(target).absolutePath(), &error)) {
+                    item["rewritten"] = absolute(target);
+                } else {
+                    item["error"] = error;
+                    exit = HeadlessCli::IoError;
+                }
+            }
+            if (!missing.isEmpty() && exit == HeadlessCli::Ok) exit = HeadlessCli::Problems;
+            playlists.push_back(item);
+        }
+        print({{"command", "validate"}, {"playlists", playlists}}, cli.isSet("pretty"));
+        return exit;
+    }
+
+    // info：輸出每首的標籤與長度（清單會先展開）
+    int info(const QCommandLineParser &cli, const QStringList &inputs) {
+        if (inputs.isEmpty()) {
+            fail("info: no files given");
+            return HeadlessCli::Usage;
+        }
+        QStringList paths;
+        QStringList unreadable;
+        for (const QString &in: inputs) {
+            if (!isPlaylist(in)) {
+                paths.push_back(absolute(in));
+                continue;
+            }
+            QString error;
+            QStringList missing;
+            for (const PlaylistEntry &e: M3UPlaylist::load(in, cli.values("search-dir"), &error, &missing)) {
+                if (e.url.isLocalFile()) paths.push_back(e.url.toLocalFile());
+            }
+            if (!error.isEmpty()) unreadable.push_back(in);
+            unreadable.append(missing);
+        }
+
+        const auto index = openIndex(cli);
+        const auto infos = readInfos(paths, index.get());
+        QJsonArray tracks;
+        qint64 totalMs = 0;
+        for (qsizetype i = 0; i < paths.size(); ++i) {
+            const auto &info = infos.at(i);
+            if (!info) {
+                unreadable.push_back(paths.at(i));
+                continue;
+            }
+            totalMs += info->durationMs;
+            tracks.push_back(QJsonObject{
+                {"path", paths.at(i)}, {"title", info->title}, {"artist", info->artist},
+                {"album", info->album}, {"durationMs", info->durationMs}, {"bitrate", info->bitrate},
+                {"sampleRate", info->sampleRate}
+            });
+        }
+        print({{"command", "info"}, {"tracks", tracks}, {"totalMs", totalMs}, {"unreadable", toJson(unreadable)}},
+              cli.isSet("pretty"));
+        return unreadable.isEmpty() ? HeadlessCli::Ok : HeadlessCli::Problems;
+    }
+}
+
+bool HeadlessCli::isCommand(const char *arg) {
+    if (!arg) return false;
+    if (std::strcmp(arg, "help") == 0) return true;
+    for (const char *cmd: kCommands) {
+        if (std::strcmp(arg, cmd) == 0) return true;
+    }
+    return false;
+}
+
+int HeadlessCli::run(const QStringList &arguments) {
+    QCommandLineParser cli;
+    cli.setApplicationDescription("Batch operations on the music library (JSON on stdout).\n"
+                                  "Exit codes: 0 ok, 1 missing/unreadable items, 2 usage, 3 I/O error.\n"
+                                  "Without a command the player opens its window, or hands files and\n"
+                                  "--play --pause --toggle --stop --next --prev --show --seek <ms> --volume <0-100>\n"
+                                  "--send <line> to the instance already running (--new-instance opens another).");
+    cli.addHelpOption();
+    cli.addPositionalArgument("command", "scan | validate | info");
+    cli.addPositionalArgument("paths", "Folders, audio files or playlists.", "<paths...>");
+    cli.addOptions({
+        {{"o", "output"}, "scan: write the result as M3U. validate: write the cleaned playlist here.", "file"},
+        {"rewrite", "validate: drop missing entries and rewrite each playlist in place."},
+        {"search-dir", "Extra folder for resolving relative playlist entries (repeatable).", "dir"},
+        {"list", "scan: include every accepted file in the output."},
+        {"index", "Metadata index file (defaults to the one the player uses).", "file"},
+        {"no-index", "Read tags directly and leave the metadata index untouched."},
+        {"pretty", "Indent the JSON output."},
+    });
+    if (!cli.parse(arguments)) {
+        fail(cli.errorText());
+        return Usage;
+    }
+
+    QStringList args = cli.positionalArguments();
+    const QString command = args.isEmpty() ? QString() : args.takeFirst();
+    if (cli.isSet("help") || command == "help") {
+        std::fputs(qPrintable(cli.helpText()), stdout);
+        return Ok;
+    }
+    if (command == "scan") return scan(cli, args);
+    if (command == "validate") return validate(cli, args);
+    if (command == "info") return info(cli, args);
+    fail("unknown command: " + command);
+    return Usage;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <QStringList>
+
+// 無介面的批次模式（QCoreApplication，不需要顯示器），輸出 JSON 供排程工作使用
+//
+//   MusicPlayer scan <資料夾或檔案>... [-o out.m3u] [--list] [--no-index]
+//   MusicPlayer validate <清單.m3u>... [--search-dir 資料夾] [--rewrite | -o out.m3u]
+//   MusicPlayer info <檔案或清單>...
+class HeadlessCli final {
+public:
+    // 結束碼
+    enum ExitCode {
+        Ok = 0,
+        Problems = 1, // 完成，但有遺失或無法讀取的項目
+        Usage = 2,
+        IoError = 3,
+    };
+
+    // argv[1] 是否為子命令（在建立 QApplication 之前判斷）
+    static bool isCommand(const char *arg);
+
+    // 需要已建立的 QCoreApplication
+    static int run(const QStringList &arguments);
+};
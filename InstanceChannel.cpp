@@ -0,0 +1,106 @@
+#include "InstanceChannel.h"
+
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QLocalSocket>
+#include <cstdio>
+
+InstanceChannel::InstanceChannel(QObject *parent)
+    : QObject(parent) {
+    m_server.setSocketOptions(QLocalServer::UserAccessOption); // 只有同一個使用者能連線
+    connect(&m_server, &QLocalServer::newConnection, this, &InstanceChannel::onNewConnection);
+}
+
+// 每個使用者一個
+QString InstanceChannel::serverName() {
+    QString user = qEnvironmentVariable("USER");
+    if (user.isEmpty()) user = qEnvironmentVariable("USERNAME");
+    return QCoreApplication::applicationName() + '-' + user;
+}
+
+bool InstanceChannel::listen() {
+    const QString name = serverName();
+    if (m_server.listen(name)) return true;
+    if (m_server.serverError() != QAbstractSocket::AddressInUseError) return false;
+
+    // 名稱被佔用：有人回應就是另一個執行個體，否則是上次異常結束留下的 socket 檔
+    QLocalSocket probe;
+    probe.connectToServer(name);
+    if (probe.waitForConnected(200)) return false;
+    QLocalServer::removeServer(name);
+    return m_server.listen(name);
+}
+
+QString InstanceChannel::execute(const QString &line) const {
+    const QString trimmed = line.trimmed();
+    if (trimmed.isEmpty()) return "ERR empty command";
+    const qsizetype space = trimmed.indexOf(u' ');
+    const QString verb = space < 0 ? trimmed : trimmed.left(space);
+    const QString arg = space < 0 ? QString() : trimmed.mid(space + 1).trimmed();
+    if (verb == "ping") return "OK";
+    return m_handler ? m_handler(verb.toLower(), arg) : QString("ERR not ready");
+}
+
+// 每行依序執行並回覆；連線斷掉時自行釋放
+void InstanceChannel::onNewConnection() {
+    while (QLocalSocket *socket = m_server.nextPendingConnection()) {
+        connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket] {
+            while (socket->canReadLine()) {
+                const QString line = QString::fromUtf8(socket->readLine());
+                socket->write(execute(line).toUtf8() + '\n');
+            }
+            if (socket->bytesAvailable() > kMaxLine) {
+                socket->write("ERR line too long\n");
+                socket->disconnectFromServer();
+            }
+        });
+    }
+}
+
+// 等到每一行都有回覆才結束，確保命令已經送達（不只是寫進緩衝區）
+bool InstanceChannel::send(const QStringList &lines, bool echo, int timeoutMs) {
+    QLocalSocket socket;
+    socket.connectToServer(serverName());
+    if (!socket.waitForConnected(timeoutMs)) return false;
+
+    QByteArray data;
+    for (const QString &line: lines) data += line.toUtf8() + '\n';
+    socket.write(data);
+    if (!socket.waitForBytesWritten(timeoutMs)) return false;
+
+    qsizetype replies = 0;
+    while (replies < lines.size()) {
+        while (replies < lines.size() && socket.canReadLine()) {
+            const QByteArray reply = socket.readLine();
+            if (echo) std::fwrite(reply.constData(), 1, reply.size(), stdout);
+            ++replies;
+        }
+        if (replies < lines.size() && !socket.waitForReadyRead(timeoutMs)) break;
+    }
+    std::fflush(stdout);
+    socket.disconnectFromServer();
+    return true;
+}
+
+QStringList InstanceChannel::commandsFromArguments(const QStringList &arguments) {
+    QStringList commands;
+    for (qsizetype i = 1; i < arguments.size(); ++i) {
+        const QString &a = arguments[i];
+        if (a == "--play" || a == "--pause" || a == "--toggle" || a == "--stop" || a == "--next"
+            || a == "--prev" || a == "--show") {
+            commands.push_back(a.mid(2));
+        } else if ((a == "--seek" || a == "--volume") && i + 1 < arguments.size()) {
+            commands.push_back(a.mid(2) + ' ' + arguments[++i]);
+        } else if (a == "--send" && i + 1 < arguments.size()) {
+            commands.push_back(arguments[++i]);
+        } else if (a.startsWith("--")) {
+            continue; // 其他選項（例如 --new-instance）由 main 處理
+        } else if (a.contains("://")) {
+            commands.push_back("enqueue " + a);
+        } else {
+            commands.push_back("enqueue " + QFileInfo(a).absoluteFilePath()); // 以送出端的工作目錄解析
+        }
+    }
+    return commands;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <QLocalServer>
+#include <QObject>
+#include <QStringList>
+#include <functional>
+
+// 單一執行個體：第一個啟動的播放器在本機 socket（QLocalServer）上接收命令，
+// 之後的啟動只用 QCoreApplication 把參數轉成命令送過去就結束，不建立視窗也不載入多媒體。
+//
+// 命令協定：UTF-8，一行一個命令（\n 結尾），第一個空白之前為命令，之後整段為參數（可含空白）。
+// 每個命令依序回覆一行「OK」、「OK <值>」或「ERR <原因>」；可以一次送出多行再依序讀回覆（管線）。
+//   ping                  OK
+//   play [列]             繼續播放；有列號（從 0 起）時播放該列
+//   pause                 暫停（已暫停或停止時不動）
+//   toggle                播放/暫停切換
+//   stop
+//   next | prev
+//   seek <毫秒>           絕對位置；+毫秒、-毫秒 為相對目前位置
+//   volume <0-100>
+//   enqueue <路徑或 URL>  加到清單尾端（與拖放相同的背景匯入，資料夾遞迴；還沒有目前曲目時開始播放第一首）
+//   status                OK <playing|paused|stopped> <列> <位置毫秒> <長度毫秒> <清單列數>
+//   show                  視窗移到最前面
+//
+// socket 名稱為 serverName()：Linux/macOS 上是暫存資料夾（通常為 /tmp）中的 Unix socket，Windows 上是具名管道。
+//   printf 'enqueue /music/a.flac\nplay\nstatus\n' | socat - UNIX-CONNECT:/tmp/MusicPlayer-$USER
+class InstanceChannel final : public QObject {
+    Q_OBJECT
+
+public:
+    // 回傳回覆行（不含換行）
+    using Handler = std::function<QString(const QString &verb, const QString &arg)>;
+
+    explicit InstanceChannel(QObject *parent = nullptr);
+
+    // 成為主要執行個體；已有其他執行個體在接收時回傳 false（殘留的 socket 檔會清掉）
+    bool listen();
+
+    void setHandler(Handler handler) { m_handler = std::move(handler); }
+
+    // 執行一行命令，回傳回覆
+    QString execute(const QString &line) const;
+
+    // 送給執行中的執行個體（echo 時把回覆印到 stdout）；沒有執行個體時回傳 false
+    static bool send(const QStringList &lines, bool echo = true, int timeoutMs = 2000);
+
+    // 啟動參數沒有命令時只把既有視窗叫到前面
+    static bool forward(const QStringList &commands) {
+        return commands.isEmpty() ? send({"show"}, false) : send(commands);
+    }
+
+    // 命令列參數 → 命令：檔案、資料夾與 URL 變成 enqueue；
+    // --play --pause --toggle --stop --next --prev --show、--seek <毫秒>、--volume <0-100>、--send <命令>
+    static QStringList commandsFromArguments(const QStringList &arguments);
+
+    static QString serverName();
+
+    static constexpr qint64 kMaxLine = 64 * 1024;
+
+private:
+    void onNewConnection();
+
+    QLocalServer m_server;
+    Handler m_handler;
+};
@@ -0,0 +1,177 @@
+#include "LibraryImporter.h"
+
+#include <QDateTime>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QThread>
+
+namespace {
+    constexpr int kStatChunk = 512; // 每個工作 stat 的檔案數
+}
+
+LibraryImporter::LibraryImporter(QObject *parent)
+    : QObject(parent) {
+    m_pool.setMaxThreadCount(std::max(2, QThread::idealThreadCount()));
+    m_drainTimer.setInterval(16);
+    connect(&m_drainTimer, &QTimer::timeout, this, &LibraryImporter::drain);
+}
+
+LibraryImporter::~LibraryImporter() {
+    ++m_generation;
+    m_pool.waitForDone();
+}
+
+// 開始匯入
+void LibraryImporter::start(const QList<QUrl> &urls) {
+    if (!isRunning()) {
+        m_canceled = false;
+        m_scanned = 0;
+        m_delivered = 0;
+    }
+
+    QStringList local;
+    QList<QUrl> remote;
+    for (const QUrl &url: urls) {
+        if (url.isLocalFile()) local.push_back(url.toLocalFile());
+        else if (isAudioPath(url.fileName())) remote.push_back(url);
+    }
+    if (!remote.isEmpty()) {
+        QMutexLocker lock(&m_mutex);
+        m_ready.append(remote);
+    }
+
+    // stat 也放到背景，GUI 執行緒不碰檔案系統
+    const int generation = m_generation;
+    for (qsizetype i = 0; i < local.size(); i += kStatChunk) {
+        QStringList chunk = local.mid(i, kStatChunk);
+        schedule(generation, [this, chunk, generation] { statPaths(chunk, generation); });
+    }
+
+    if (!m_drainTimer.isActive()) m_drainTimer.start();
+}
+
+// 取消
+void LibraryImporter::cancel() {
+    if (!m_drainTimer.isActive()) return;
+    m_canceled = true;
+    ++m_generation;
+    QMutexLocker lock(&m_mutex);
+    m_ready.clear();
+    m_bad.clear();
+    m_badReasons.clear();
+}
+
+bool LibraryImporter::isAudioPath(const QString &fileName) {
+    static const QStringList exts = {".mp3", ".wav", ".flac", ".m4a", ".aac", ".ogg", ".opus"};
+    for (const QString &ext: exts) {
+        if (fileName.endsWith(ext, Qt::CaseInsensitive)) return true;
+    }
+    return false;
+}
+
+// 排入執行緒池（計數歸零代表全部完成）
+void LibraryImporter::schedule(int generation, std::function<void()> job) {
+    m_pending.fetch_add(1, std::memory_order_relaxed);
+    m_pool.start([this, generation, job = std::move(job)] {
+        if (!stale(generation)) job();
+        m_pending.fetch_sub(1, std::memory_order_release);
+    });
+}
+
+// 檢查直接拖入的路徑：資料夾往下掃，檔案直接過濾
+void LibraryImporter::statPaths(const QStringList &paths, int generation) {
+    QStringList files, bad, reasons;
+    for (const QString &path: paths) {
+        const QFileInfo fi(path);
+        if (fi.isDir()) {
+            schedule(generation, [this, dir = fi.absoluteFilePath(), generation] { walkDir(dir, generation); });
+        } else if (fi.isFile()) {
+            classify(QFileInfo(fi.absoluteFilePath()), files, bad, reasons);
+        }
+    }
+    if (stale(generation)) return;
+    m_scanned.fetch_add(static_cast<int>(paths.size()), std::memory_order_relaxed);
+    push(files, bad, reasons, generation);
+}
+
+// 掃描單一資料夾，子資料夾各自成為新的工作
+void LibraryImporter::walkDir(const QString &dir, int generation) {
+    QStringList files, bad, reasons;
+    int scanned = 0;
+    QDirIterator it(dir, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot | QDir::Readable);
+    while (it.hasNext()) {
+        if (stale(generation)) return;
+        it.next();
+        const QFileInfo fi = it.fileInfo();
+        if (fi.isDir()) {
+            if (!fi.isSymLink()) schedule(generation, [this, sub = fi.filePath(), generation] { walkDir(sub, generation); });
+            continue;
+        }
+        ++scanned;
+        if (fi.size() > 0) classify(fi, files, bad, reasons);
+    }
+    m_scanned.fetch_add(scanned, std::memory_order_relaxed);
+
+    files.sort(Qt::CaseInsensitive); // 同一資料夾內依檔名排序
+    push(files, bad, reasons, generation);
+}
+
+// 只讀音訊副檔名與沒有副檔名的檔案；快取命中時只用已經 stat 過的大小與修改時間
+void LibraryImporter::classify(const QFileInfo &fi, QStringList &files, QStringList &bad, QStringList &reasons) {
+    const bool audioName = isAudioPath(fi.fileName());
+    if (!audioName && !fi.suffix().isEmpty()) return;
+    const auto format = m_sniffer.format(fi.filePath(), fi.size(), fi.lastModified().toMSecsSinceEpoch());
+    if (FormatSniffer::isAudio(format)) {
+        files.push_back(fi.filePath());
+    } else if (audioName) {
+        files.push_back(fi.filePath());
+        bad.push_back(fi.filePath());
+        reasons.push_back(FormatSniffer::describe(format));
+    }
+}
+
+// 放入待送佇列
+void LibraryImporter::push(const QStringList &paths, const QStringList &bad, const QStringList &reasons,
+                           int generation) {
+    if (paths.isEmpty()) return;
+    QList<QUrl> urls;
+    urls.reserve(paths.size());
+    for (const QString &p: paths) urls.push_back(QUrl::fromLocalFile(p));
+
+    QMutexLocker lock(&m_mutex);
+    if (stale(generation)) return; // 與 cancel 清空佇列互斥：取消後不會再放入
+    m_ready.append(urls);
+    m_bad.append(bad);
+    m_badReasons.append(reasons);
+}
+
+// GUI 執行緒：每個畫面最多送出一批，避免卡住事件迴圈
+void LibraryImporter::drain() {
+    // 先讀計數：歸零時所有 push 都已完成
+    const bool idle = m_pending.load(std::memory_order_acquire) == 0;
+    QList<QUrl> batch;
+    QStringList bad, reasons;
+    bool empty;
+    {
+        QMutexLocker lock(&m_mutex);
+        const qsizetype n = std::min<qsizetype>(m_ready.size(), kBatchSize);
+        batch = m_ready.first(n);
+        m_ready.remove(0, n);
+        empty = m_ready.isEmpty();
+        bad.swap(m_bad); // 標記以路徑為準，比列先送到也沒關係
+        reasons.swap(m_badReasons);
+    }
+
+    if (!batch.isEmpty()) {
+        m_delivered += static_cast<int>(batch.size());
+        emit batchReady(batch);
+    }
+    if (!bad.isEmpty()) emit unplayable(bad, reasons);
+    emit progress(m_scanned.load(std::memory_order_relaxed), m_delivered);
+
+    if (idle && empty) {
+        m_drainTimer.stop();
+        m_pool.start([this] { m_sniffer.save(); });
+        emit finished(m_canceled);
+    }
+}
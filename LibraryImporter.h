@@ -0,0 +1,81 @@
+#pragma once
+#include <QObject>
+#include <QList>
+#include <QMutex>
+#include <QThreadPool>
+#include <QTimer>
+#include <QUrl>
+#include <atomic>
+#include <functional>
+#include "FormatSniffer.h"
+
+// 背景匯入：多執行緒遞迴掃描資料夾，分批送回 GUI
+//
+// 本機檔案在掃描的工作中一併讀檔頭判斷格式（結果快取）：音訊副檔名但內容不是音訊的照樣加入並另外回報，
+// 沒有副檔名但內容是音訊的也加入。
+class QFileInfo;
+
+class LibraryImporter final : public QObject {
+    Q_OBJECT
+
+public:
+    explicit LibraryImporter(QObject *parent = nullptr);
+
+    ~LibraryImporter() override;
+
+    // 加入要匯入的檔案或資料夾（執行中也可再加入）
+    void start(const QList<QUrl> &urls);
+
+    void cancel();
+
+    // 取消後就不算執行中（剩下的工作在背景收尾），之後的 start 是新的一次匯入
+    bool isRunning() const { return m_drainTimer.isActive() && !m_canceled; }
+
+    // 依副檔名判斷是否為音訊檔案
+    static bool isAudioPath(const QString &fileName);
+
+    static constexpr int kBatchSize = 2000; // 每個畫面最多送回的列數
+
+signals:
+    void batchReady(const QList<QUrl> &urls);
+
+    // 已送出（或同一批）的檔案中無法播放的；reasons[i] 為 paths[i] 的原因
+    void unplayable(const QStringList &paths, const QStringList &reasons);
+
+    void progress(int scanned, int accepted);
+
+    void finished(bool canceled);
+
+private:
+    // 以下的 generation 為工作排入時的匯入代數；取消後舊代數的工作直接結束
+    void schedule(int generation, std::function<void()> job);
+
+    void statPaths(const QStringList &paths, int generation);
+
+    void walkDir(const QString &dir, int generation);
+
+    bool stale(int generation) const { return generation != m_generation.load(std::memory_order_relaxed); }
+
+    // 依檔頭決定是否加入；bad 收集音訊副檔名但無法播放的
+    void classify(const QFileInfo &fi, QStringList &files, QStringList &bad, QStringList &reasons);
+
+    void push(const QStringList &paths, const QStringList &bad, const QStringList &reasons, int generation);
+
+    void drain();
+
+    QThreadPool m_pool;
+    QTimer m_drainTimer; // GUI 執行緒上每個畫面取一批
+
+    FormatSniffer m_sniffer;
+
+    QMutex m_mutex;
+    QList<QUrl> m_ready;
+    QStringList m_bad;
+    QStringList m_badReasons;
+
+    std::atomic<int> m_pending{0};
+    std::atomic<int> m_scanned{0};
+    std::atomic<int> m_generation{0}; // 每次取消遞增
+    bool m_canceled = false; // GUI 執行緒：目前這次匯入已取消
+    int m_delivered = 0;
+};
@@ -0,0 +1,314 @@
+#include "LibraryWatcher.h"
+#include "LibraryImporter.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThread>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    constexpr char kMagic[4] = {'M', 'P', 'L', 'B'};
+    constexpr quint32 kVersion = 1;
+    constexpr int kQuietMs = 300; // 最後一個事件之後再等這麼久
+    constexpr int kMaxDelayMs = 2000; // 事件持續不斷時最多延遲這麼久
+
+    bool isUnder(const QString &path, const QStringList &roots) {
+        return std::ranges::any_of(roots, [&path](const QString &root) {
+            return path == root || (path.startsWith(root) && (root.endsWith(u'/') || path.at(root.size()) == u'/'));
+        });
+    }
+
+    QString childPath(const QString &dir, const QString &name) {
+        return dir.endsWith(u'/') ? dir + name : dir + u'/' + name;
+    }
+}
+
+LibraryWatcher::LibraryWatcher(QObject *parent)
+    : QObject(parent) {
+    m_pool.setMaxThreadCount(1);
+    m_pool.setThreadPriority(QThread::LowPriority);
+    m_quietTimer.setSingleShot(true);
+    m_quietTimer.setInterval(kQuietMs);
+    connect(&m_quietTimer, &QTimer::timeout, this, &LibraryWatcher::flush);
+    connect(&m_fs, &QFileSystemWatcher::directoryChanged, this, &LibraryWatcher::onDirectoryChanged);
+}
+
+LibraryWatcher::~LibraryWatcher() {
+    m_canceled = true;
+    m_pool.clear();
+    m_pool.waitForDone();
+    if (m_dirty) save();
+}
+
+QString LibraryWatcher::defaultPath() {
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dir);
+    return dir + "/library.idx";
+}
+
+void LibraryWatcher::setRoots(const QStringList &roots) {
+    QStringList clean;
+    for (const QString &root: roots) {
+        const QString path = QDir::cleanPath(QFileInfo(root).absoluteFilePath());
+        if (!path.isEmpty() && !clean.contains(path)) clean.push_back(path);
+    }
+    m_roots = clean;
+    m_pending.clear();
+    m_quietTimer.stop();
+    schedule([this, clean] { applyRoots(clean); });
+}
+
+// 同一個資料夾的多次事件只記一次
+void LibraryWatcher::onDirectoryChanged(const QString &path) {
+    if (m_pending.isEmpty()) m_firstPending.start();
+    m_pending.insert(path);
+    if (m_firstPending.elapsed() >= kMaxDelayMs) flush();
+    else m_quietTimer.start();
+}
+
+void LibraryWatcher::flush() {
+    m_quietTimer.stop();
+    if (m_pending.isEmpty()) return;
+    const QStringList dirs(m_pending.cbegin(), m_pending.cend());
+    m_pending.clear();
+    schedule([this, dirs, roots = m_roots] {
+        Delta delta;
+        for (const QString &dir: dirs) {
+            if (isUnder(dir, roots)) rescanDir(dir, delta);
+        }
+        publish(delta, false);
+    });
+}
+
+// 佇列清空時才寫狀態檔，事件不斷時不會每批都寫一次
+void LibraryWatcher::schedule(std::function<void()> job) {
+    ++m_queued;
+    m_pool.start([this, job = std::move(job)] {
+        if (!m_canceled) job();
+        if (--m_queued == 0 && m_dirty && !m_canceled) save();
+    });
+}
+
+// 啟動比對：從根目錄往下只 stat 已知的資料夾，修改時間不同的才重新列出
+void LibraryWatcher::applyRoots(const QStringList &roots) {
+    load();
+    // 不再監看的資料夾直接忘掉（清單中的曲目保留）
+    for (auto it = m_dirs.begin(); it != m_dirs.end();) {
+        if (isUnder(it.key(), roots)) {
+            ++it;
+        } else {
+            it = m_dirs.erase(it);
+            m_dirty = true;
+        }
+    }
+
+    Delta delta;
+    for (const QString &root: roots) {
+        // 根目錄不在（例如外接磁碟沒接上）：保留狀態，不當作全部刪除
+        if (!QFileInfo(root).isDir()) continue;
+        QStringList stack{root};
+        while (!stack.isEmpty() && !m_canceled) {
+            const QString dir = stack.takeLast();
+            const auto it = m_dirs.constFind(dir);
+            if (it == m_dirs.cend() || it->mtime != mtimeOf(dir)) rescanDir(dir, delta);
+            if (const auto after = m_dirs.constFind(dir); after != m_dirs.cend()) stack.append(after->subdirs);
+        }
+    }
+    publish(delta, true);
+}
+
+// 重新列出一個資料夾並與上次比對；新的子資料夾整個掃描，不見的整個移除
+void LibraryWatcher::rescanDir(const QString &path, Delta &delta) {
+    if (m_canceled) return;
+    const QFileInfo info(path);
+    if (!info.isDir()) {
+        removeTree(path, delta);
+        return;
+    }
+
+    DirState fresh;
+    fresh.mtime = info.lastModified().toMSecsSinceEpoch();
+    QDirIterator it(path, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot | QDir::Readable);
+    while (it.hasNext()) {
+        it.next();
+        const QFileInfo fi = it.fileInfo();
+        if (fi.isDir()) {
+            if (!fi.isSymLink()) fresh.subdirs.push_back(fi.filePath());
+        } else if (LibraryImporter::isAudioPath(fi.fileName()) && fi.size() > 0) {
+            fresh.files.insert(fi.fileName(), {fi.size(), fi.lastModified().toMSecsSinceEpoch()});
+        }
+    }
+
+    const auto old = m_dirs.constFind(path);
+    const bool known = old != m_dirs.cend();
+    const DirState previous = known ? *old : DirState();
+    for (auto f = fresh.files.cbegin(); f != fresh.files.cend(); ++f) {
+        if (!previous.files.contains(f.key())) delta.added.insert(childPath(path, f.key()), *f);
+    }
+    for (auto f = previous.files.cbegin(); f != previous.files.cend(); ++f) {
+        if (!fresh.files.contains(f.key())) delta.removed.insert(childPath(path, f.key()), *f);
+    }
+    QStringList newSubdirs;
+    for (const QString &sub: fresh.subdirs) {
+        if (!previous.subdirs.contains(sub)) newSubdirs.push_back(sub);
+    }
+    QStringList goneSubdirs;
+    for (const QString &sub: previous.subdirs) {
+        if (!fresh.subdirs.contains(sub)) goneSubdirs.push_back(sub);
+    }
+
+    m_dirs.insert(path, std::move(fresh));
+    m_dirty = true;
+    if (!known) delta.newDirs.push_back(path);
+    for (const QString &sub: goneSubdirs) removeTree(sub, delta);
+    for (const QString &sub: newSubdirs) rescanDir(sub, delta);
+}
+
+void LibraryWatcher::removeTree(const QString &path, Delta &delta) {
+    const auto it = m_dirs.constFind(path);
+    if (it == m_dirs.cend()) return;
+    const DirState state = *it;
+    m_dirs.erase(it);
+    m_dirty = true;
+    delta.goneDirs.push_back(path);
+    for (auto f = state.files.cbegin(); f != state.files.cend(); ++f) delta.removed.insert(childPath(path, f.key()), *f);
+    for (const QString &sub: state.subdirs) removeTree(sub, delta);
+}
+
+// 改名不會改變檔案的大小與修改時間
+void LibraryWatcher::publish(Delta &delta, bool rewatch) {
+    Renames renamed;
+    QHash<QPair<qint64, qint64>, QString> gone;
+    for (auto it = delta.removed.cbegin(); it != delta.removed.cend(); ++it) gone.insert({it->size, it->mtime}, it.key());
+    QStringList added;
+    for (auto it = delta.added.cbegin(); it != delta.added.cend(); ++it) {
+        if (const auto g = gone.constFind({it->size, it->mtime}); g != gone.cend()) {
+            renamed.push_back({*g, it.key()});
+            delta.removed.remove(*g);
+            gone.erase(g);
+        } else {
+            added.push_back(it.key());
+        }
+    }
+    added.sort(Qt::CaseInsensitive); // 同一資料夾內依檔名排序
+    QStringList removed = delta.removed.keys();
+
+    const QStringList watch = rewatch ? m_dirs.keys() : QStringList();
+    const QStringList newDirs = delta.newDirs;
+    const QStringList goneDirs = delta.goneDirs;
+    if (m_canceled) return;
+    QMetaObject::invokeMethod(this, [this, added, removed, renamed, rewatch, watch, newDirs, goneDirs] {
+        if (rewatch) {
+            if (const QStringList old = m_fs.directories(); !old.isEmpty()) m_fs.removePaths(old);
+            if (!watch.isEmpty()) m_fs.addPaths(watch);
+        } else {
+            if (!goneDirs.isEmpty()) m_fs.removePaths(goneDirs);
+            if (!newDirs.isEmpty()) m_fs.addPaths(newDirs);
+        }
+        if (!added.isEmpty() || !removed.isEmpty() || !renamed.isEmpty()) emit changed(added, removed, renamed);
+    }, Qt::QueuedConnection);
+}
+
+void LibraryWatcher::load() {
+    if (m_loaded) return;
+    m_loaded = true;
+
+    QFile file(defaultPath());
+    if (!file.open(QIODevice::ReadOnly)) return;
+    const QByteArray data = file.readAll();
+    Header h{};
+    if (data.size() < static_cast<qsizetype>(sizeof(Header))) return;
+    memcpy(&h, data.constData(), sizeof(Header));
+    const qint64 stringsOff = sizeof(Header) + static_cast<qint64>(h.count) * sizeof(DirEntry) +
+                              static_cast<qint64>(h.fileCount) * sizeof(FileEntry);
+    if (memcmp(h.magic, kMagic, 4) != 0 || h.version != kVersion || stringsOff > data.size()) {
+        qWarning() << "library state invalid, ignoring:" << file.fileName();
+        return;
+    }
+
+    auto stringAt = [&data, stringsOff](quint32 off, quint32 len) {
+        if (stringsOff + off + len > data.size()) return QString();
+        return QString::fromUtf8(data.constData() + stringsOff + off, len);
+    };
+    const char *dirs = data.constData() + sizeof(Header);
+    const char *files = dirs + h.count * sizeof(DirEntry);
+    for (quint32 i = 0; i < h.count; ++i) {
+        DirEntry d;
+        memcpy(&d, dirs + i * sizeof(DirEntry), sizeof(DirEntry));
+        if (static_cast<quint64>(d.firstFile) + d.fileCount > h.fileCount) continue;
+        DirState state;
+        state.mtime = d.mtime;
+        state.files.reserve(d.fileCount);
+        for (quint32 j = d.firstFile; j < d.firstFile + d.fileCount; ++j) {
+            FileEntry f;
+            memcpy(&f, files + j * sizeof(FileEntry), sizeof(FileEntry));
+            state.files.insert(stringAt(f.off, f.len), {f.size, f.mtime});
+        }
+        m_dirs.insert(stringAt(d.off, d.len), std::move(state));
+    }
+
+    // 子資料夾由路徑推回
+    const QStringList paths = m_dirs.keys();
+    for (const QString &path: paths) {
+        const qsizetype slash = path.lastIndexOf(u'/');
+        if (slash <= 0) continue;
+        if (const auto parent = m_dirs.find(path.left(slash)); parent != m_dirs.end()) parent->subdirs.push_back(path);
+    }
+}
+
+void LibraryWatcher::save() {
+    QVector<DirEntry> dirs;
+    QVector<FileEntry> files;
+    QByteArray strings;
+    dirs.reserve(m_dirs.size());
+
+    auto addString = [&strings](const QString &s, quint32 &off, quint32 &len) {
+        const QByteArray utf8 = s.toUtf8();
+        off = static_cast<quint32>(strings.size());
+        len = static_cast<quint32>(utf8.size());
+        strings.append(utf8);
+    };
+
+    for (auto it = m_dirs.cbegin(); it != m_dirs.cend(); ++it) {
+        DirEntry d{};
+        d.mtime = it->mtime;
+        addString(it.key(), d.off, d.len);
+        d.firstFile = static_cast<quint32>(files.size());
+        d.fileCount = static_cast<quint32>(it->files.size());
+        for (auto f = it->files.cbegin(); f != it->files.cend(); ++f) {
+            FileEntry e{};
+            e.size = f->size;
+            e.mtime = f->mtime;
+            addString(f.key(), e.off, e.len);
+            files.push_back(e);
+        }
+        dirs.push_back(d);
+    }
+    if (strings.size() > 0xFFFFFFFFLL) return;
+
+    Header h{};
+    memcpy(h.magic, kMagic, 4);
+    h.version = kVersion;
+    h.count = static_cast<quint32>(dirs.size());
+    h.fileCount = static_cast<quint32>(files.size());
+
+    QSaveFile out(defaultPath());
+    if (!out.open(QIODevice::WriteOnly)) return;
+    out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+    out.write(reinterpret_cast<const char *>(dirs.constData()), dirs.size() * qsizetype(sizeof(DirEntry)));
+    out.write(reinterpret_cast<const char *>(files.constData()), files.size() * qsizetype(sizeof(FileEntry)));
+    out.write(strings);
+    if (out.commit()) m_dirty = false;
+}
+
+qint64 LibraryWatcher::mtimeOf(const QString &path) {
+    const QFileInfo info(path);
+    return info.exists() ? info.lastModified().toMSecsSinceEpoch() : -1;
+}
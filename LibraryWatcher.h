@@ -0,0 +1,121 @@
+#pragma once
+#include <QElapsedTimer>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QObject>
+#include <QPair>
+#include <QSet>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTimer>
+#include <atomic>
+#include <functional>
+
+// 監看音樂庫資料夾（QFileSystemWatcher，Linux 上為 inotify），增量回報新增、刪除與改名的音訊檔案
+//
+// 事件只標記變更的資料夾，合併一段時間後在背景只重新列出那些資料夾；大量複製時也是一批一批處理。
+// 每個資料夾的修改時間與檔案清單持久化，啟動時只 stat 每個資料夾，修改時間不同的才重新列出。
+//
+// 狀態檔格式 (little-endian)：
+//   Header  { magic "MPLB", version, count, fileCount }
+//   Dir[dirCount]    { mtime, off, len, firstFile, fileCount }   絕對路徑
+//   File[fileCount]  { size, mtime, off, len }                   檔名
+//   字串區：UTF-8，不含結尾
+class LibraryWatcher final : public QObject {
+    Q_OBJECT
+
+public:
+    using Renames = QList<QPair<QString, QString>>;
+
+    explicit LibraryWatcher(QObject *parent = nullptr);
+
+    ~LibraryWatcher() override;
+
+    // 設定監看的根目錄：已知的只比對變更，新的整個掃描（全部回報為新增）
+    void setRoots(const QStringList &roots);
+
+    QStringList roots() const { return m_roots; }
+
+    static QString defaultPath();
+
+signals:
+    // 一批合併後的變更（只含音訊檔案）；renamed 為 (舊路徑, 新路徑)
+    void changed(const QStringList &added, const QStringList &removed, const LibraryWatcher::Renames &renamed);
+
+private:
+    struct Stamp {
+        qint64 size = 0;
+        qint64 mtime = 0;
+    };
+
+    struct DirState {
+        qint64 mtime = 0;
+        QHash<QString, Stamp> files; // 檔名 → 大小與修改時間
+        QStringList subdirs; // 絕對路徑
+    };
+
+    struct Delta {
+        QHash<QString, Stamp> added;
+        QHash<QString, Stamp> removed;
+        QStringList newDirs;
+        QStringList goneDirs;
+    };
+
+    struct Header {
+        char magic[4];
+        quint32 version;
+        quint32 count;
+        quint32 fileCount;
+    };
+
+    struct DirEntry {
+        qint64 mtime;
+        quint32 off;
+        quint32 len;
+        quint32 firstFile;
+        quint32 fileCount;
+    };
+
+    struct FileEntry {
+        qint64 size;
+        qint64 mtime;
+        quint32 off;
+        quint32 len;
+    };
+
+    // GUI 執行緒：收集事件，安靜一段時間或累積太久時送出
+    void onDirectoryChanged(const QString &path);
+
+    void flush();
+
+    void schedule(std::function<void()> job);
+
+    // 以下在背景執行緒（單一執行緒，擁有 m_dirs）
+    void applyRoots(const QStringList &roots);
+
+    void rescanDir(const QString &path, Delta &delta);
+
+    void removeTree(const QString &path, Delta &delta);
+
+    // 同大小、同修改時間的刪除 + 新增視為改名；送回 GUI 執行緒
+    void publish(Delta &delta, bool rewatch);
+
+    void load();
+
+    void save();
+
+    static qint64 mtimeOf(const QString &path);
+
+    QFileSystemWatcher m_fs;
+    QStringList m_roots;
+    QSet<QString> m_pending; // 變更過、還沒重新列出的資料夾
+    QTimer m_quietTimer;
+    QElapsedTimer m_firstPending;
+
+    QThreadPool m_pool;
+    std::atomic<bool> m_canceled{false};
+    std::atomic<int> m_queued{0};
+    QHash<QString, DirState> m_dirs;
+    bool m_loaded = false;
+    bool m_dirty = false;
+};
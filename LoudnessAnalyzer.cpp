@@ -0,0 +1,240 @@
+#include "LoudnessAnalyzer.h"
+#include "AudioFileDecoder.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThread>
+#include <cstring>
+
+namespace {
+    constexpr char kMagic[4] = {'M', 'P', 'L', 'N'};
+    constexpr quint32 kVersion = 1;
+    constexpr int kSaveDelayMs = 3000;
+    constexpr double kPeakCeilingDb = -1.0;
+}
+
+LoudnessAnalyzer::LoudnessAnalyzer(QObject *parent)
+    : QObject(parent) {
+    // 一個檔案一個工作，隨核心數線性擴展；低優先權，不影響播放
+    m_pool.setMaxThreadCount(QThread::idealThreadCount());
+    m_pool.setThreadPriority(QThread::LowPriority);
+
+    m_saveTimer.setSingleShot(true);
+    m_saveTimer.setInterval(kSaveDelayMs);
+    connect(&m_saveTimer, &QTimer::timeout, this, [this] { m_pool.start([this] { save(); }, 2); }); // 排在分析工作之前
+    connect(this, &LoudnessAnalyzer::analyzed, this, [this] { m_saveTimer.start(); });
+}
+
+LoudnessAnalyzer::~LoudnessAnalyzer() {
+    m_abort = true;
+    m_pool.clear();
+    m_pool.waitForDone();
+    save();
+    unmap();
+}
+
+QString LoudnessAnalyzer::defaultPath() {
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dir);
+    return dir + "/loudness.idx";
+}
+
+bool LoudnessAnalyzer::open(const QString &path) {
+    QWriteLocker lock(&m_lock);
+    return mapFile(path.isEmpty() ? defaultPath() : path);
+}
+
+// 呼叫端需持有寫鎖
+bool LoudnessAnalyzer::mapFile(const QString &path) {
+    unmap();
+    m_path = path;
+
+    m_file.setFileName(m_path);
+    if (!m_file.open(QIODevice::ReadOnly)) return false;
+    const qint64 size = m_file.size();
+    const uchar *map = size >= static_cast<qint64>(sizeof(Header)) ? m_file.map(0, size) : nullptr;
+    if (!map) {
+        m_file.close();
+        return false;
+    }
+
+    Header h{};
+    memcpy(&h, map, sizeof(Header));
+    if (memcmp(h.magic, kMagic, 4) != 0 || h.version != kVersion ||
+        sizeof(Header) + static_cast<qint64>(h.count) * sizeof(Entry) > size) {
+        qWarning() << "loudness index invalid, ignoring:" << m_path;
+        m_file.unmap(const_cast<uchar *>(map));
+        m_file.close();
+        return false;
+    }
+
+    m_map = map;
+    m_count = h.count;
+    m_entries = reinterpret_cast<const Entry *>(map + sizeof(Header));
+    return true;
+}
+
+void LoudnessAnalyzer::unmap() {
+    if (m_map) m_file.unmap(const_cast<uchar *>(m_map));
+    m_file.close();
+    m_map = nullptr;
+    m_entries = nullptr;
+    m_count = 0;
+}
+
+// FNV-1a（與 MetadataIndex 相同）
+quint64 LoudnessAnalyzer::hashPath(const QString &path) {
+    quint64 h = 14695981039346656037ULL;
+    for (const QChar c: path) {
+        h ^= c.unicode();
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+const LoudnessAnalyzer::Entry *LoudnessAnalyzer::findEntry(quint64 hash) const {
+    if (const auto it = m_fresh.constFind(hash); it != m_fresh.cend()) return &*it;
+    if (!m_entries) return nullptr;
+    const Entry *end = m_entries + m_count;
+    const Entry *it = std::lower_bound(m_entries, end, hash, [](const Entry &e, quint64 v) { return e.pathHash < v; });
+    return it != end && it->pathHash == hash ? it : nullptr;
+}
+
+std::optional<LoudnessInfo> LoudnessAnalyzer::find(const QString &path) const {
+    const QFileInfo fi(path);
+    if (!fi.isFile()) return std::nullopt;
+    const qint64 size = fi.size();
+    const qint64 mtime = fi.lastModified().toMSecsSinceEpoch();
+
+    QReadLocker lock(&m_lock);
+    const Entry *e = findEntry(hashPath(path));
+    if (!e || e->size != size || e->mtime != mtime) return std::nullopt;
+
+    LoudnessInfo info;
+    info.integratedLufs = e->integratedLufs;
+    info.rangeLu = e->rangeLu;
+    info.truePeakDb = e->truePeakDb;
+    info.gatedEnergy = e->gatedEnergy;
+    info.gatedBlocks = e->gatedBlocks;
+    return info;
+}
+
+double LoudnessAnalyzer::gainDb(const LoudnessInfo &info) {
+    if (!info.isValid()) return 0.0;
+    return std::min(kReferenceLufs - info.integratedLufs, kPeakCeilingDb - info.truePeakDb);
+}
+
+void LoudnessAnalyzer::analyze(const QStringList &paths, bool urgent) {
+    m_abort = false;
+    int added = 0;
+    {
+        QMutexLocker lock(&m_queueLock);
+        for (const QString &path: paths) {
+            if (path.isEmpty() || (m_queued.contains(path) && !urgent)) continue;
+            m_queued.insert(path);
+            m_pool.start([this, path] { run(path); }, urgent ? 1 : 0);
+            ++added;
+        }
+    }
+    if (added > 0) emit progress(m_pending += added);
+}
+
+void LoudnessAnalyzer::cancel() {
+    m_pool.clear();
+    {
+        QMutexLocker lock(&m_queueLock);
+        m_queued.clear();
+    }
+    m_pending = m_pool.activeThreadCount();
+    emit progress(m_pending);
+}
+
+// 工作執行緒：已分析且未變更的檔案只花一次 stat
+void LoudnessAnalyzer::run(const QString &path) {
+    if (!m_abort && !find(path)) {
+        const QFileInfo fi(path);
+        if (const auto info = measure(path, &m_abort); info && !m_abort) {
+            Entry e{};
+            e.pathHash = hashPath(path);
+            e.size = fi.size();
+            e.mtime = fi.lastModified().toMSecsSinceEpoch();
+            e.gatedEnergy = info->gatedEnergy;
+            e.integratedLufs = static_cast<float>(info->integratedLufs);
+            e.rangeLu = static_cast<float>(info->rangeLu);
+            e.truePeakDb = static_cast<float>(info->truePeakDb);
+            e.gatedBlocks = info->gatedBlocks;
+            {
+                QWriteLocker lock(&m_lock);
+                m_fresh.insert(e.pathHash, e);
+            }
+            emit analyzed(path);
+        }
+    }
+    {
+        QMutexLocker lock(&m_queueLock);
+        m_queued.remove(path);
+    }
+    emit progress(std::max(0, --m_pending));
+}
+
+// 逐塊送進量測器；記憶體用量與曲長無關
+std::optional<LoudnessInfo> LoudnessAnalyzer::measure(const QString &path, const std::atomic<bool> *abort) {
+    std::optional<LoudnessMeter> meter;
+    const bool ok = AudioFileDecoder::decode(path, [&](const float *samples, qint64 frames, const QAudioFormat &format) {
+        if (!meter) meter.emplace(format.sampleRate(), format.channelCount());
+        meter->addFrames(samples, frames);
+    }, abort);
+    if (!ok || !meter) return std::nullopt;
+    return meter->result();
+}
+
+// 寫回：舊資料 + 新資料重新排序後寫成新檔，再重新映射
+bool LoudnessAnalyzer::save() {
+    static QMutex saveMutex;
+    QMutexLocker saveLock(&saveMutex);
+
+    QHash<quint64, Entry> fresh;
+    QVector<Entry> entries;
+    {
+        QReadLocker lock(&m_lock);
+        if (m_fresh.isEmpty()) return true;
+        fresh = m_fresh;
+        if (m_path.isEmpty()) m_path = defaultPath();
+
+        entries.reserve(m_count + fresh.size());
+        for (quint32 i = 0; i < m_count; ++i) {
+            if (!fresh.contains(m_entries[i].pathHash)) entries.push_back(m_entries[i]);
+        }
+    }
+    for (const Entry &e: std::as_const(fresh)) entries.push_back(e);
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return a.pathHash < b.pathHash; });
+
+    Header h{};
+    memcpy(h.magic, kMagic, 4);
+    h.version = kVersion;
+    h.count = static_cast<quint32>(entries.size());
+
+    QSaveFile out(m_path);
+    if (!out.open(QIODevice::WriteOnly)) return false;
+    out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+    out.write(reinterpret_cast<const char *>(entries.constData()), entries.size() * qsizetype(sizeof(Entry)));
+
+    // 換檔時才需要寫鎖（Windows 無法覆蓋已映射的檔案）
+    QWriteLocker lock(&m_lock);
+    const QString path = m_path;
+    unmap();
+    const bool ok = out.commit();
+    mapFile(path);
+    if (!ok) return false;
+
+    for (auto it = fresh.cbegin(); it != fresh.cend(); ++it) {
+        if (const auto cur = m_fresh.constFind(it.key());
+            cur != m_fresh.cend() && cur->size == it->size && cur->mtime == it->mtime)
+            m_fresh.remove(it.key());
+    }
+    return true;
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <QObject>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QSet>
+#include <QThreadPool>
+#include <QTimer>
+#include <atomic>
+#include <optional>
+#include "LoudnessMeter.h"
+
+// 背景響度分析（EBU R128）與持久化結果，每個檔案只分析一次
+//
+// 檔案格式 (little-endian)：
+//   Header  { magic "MPLN", version, count, reserved }
+//   Entry[count]，依 pathHash 排序，可直接二分搜尋（不存路徑字串）
+class LoudnessAnalyzer final : public QObject {
+    Q_OBJECT
+
+public:
+    // ReplayGain 2.0 的參考響度
+    static constexpr double kReferenceLufs = -18.0;
+
+    explicit LoudnessAnalyzer(QObject *parent = nullptr);
+
+    ~LoudnessAnalyzer() override;
+
+    // 載入（映射）結果檔；path 為空時使用預設位置
+    bool open(const QString &path = QString());
+
+    bool save();
+
+    // 已分析且檔案未變更時回傳結果，執行緒安全
+    std::optional<LoudnessInfo> find(const QString &path) const;
+
+    // 排入背景分析；urgent 的排在最前面（例如正要播放的曲目）
+    void analyze(const QStringList &paths, bool urgent = false);
+
+    // 清除佇列中尚未開始的工作
+    void cancel();
+
+    int pending() const { return m_pending.load(std::memory_order_relaxed); }
+
+    // 同步解碼並量測（呼叫端執行緒需能執行事件迴圈）
+    static std::optional<LoudnessInfo> measure(const QString &path, const std::atomic<bool> *abort = nullptr);
+
+    // 正規化到參考響度所需的增益（dB），並讓真峰值不超過 -1 dBTP
+    static double gainDb(const LoudnessInfo &info);
+
+    static QString defaultPath();
+
+signals:
+    void analyzed(const QString &path);
+
+    void progress(int pending);
+
+private:
+    struct Entry {
+        quint64 pathHash;
+        qint64 size;
+        qint64 mtime;
+        double gatedEnergy;
+        float integratedLufs;
+        float rangeLu;
+        float truePeakDb;
+        quint32 gatedBlocks;
+    };
+
+    struct Header {
+        char magic[4];
+        quint32 version;
+        quint32 count;
+        quint32 reserved;
+    };
+
+    static quint64 hashPath(const QString &path);
+
+    bool mapFile(const QString &path);
+
+    void unmap();
+
+    const Entry *findEntry(quint64 hash) const;
+
+    void run(const QString &path);
+
+    QString m_path;
+    QFile m_file;
+    const uchar *m_map = nullptr;
+    const Entry *m_entries = nullptr;
+    quint32 m_count = 0;
+
+    mutable QReadWriteLock m_lock;
+    QHash<quint64, Entry> m_fresh; // 尚未寫回的新結果
+
+    QMutex m_queueLock;
+    QSet<QString> m_queued; // 避免同一檔案重複排入
+
+    QThreadPool m_pool;
+    QTimer m_saveTimer;
+    std::atomic<bool> m_abort{false};
+    std::atomic<int> m_pending{0};
+};
@@ -0,0 +1,188 @@
+#include "LoudnessMeter.h"
+
+#include <algorithm>
+#include <numbers>
+
+namespace {
+    constexpr double kAbsoluteGate = -70.0;
+    constexpr double kBinLow = -70.0;
+    constexpr double kBinWidth = 0.1;
+
+    double toLufs(double z) {
+        return z > 0.0 ? -0.691 + 10.0 * std::log10(z) : -std::numeric_limits<double>::infinity();
+    }
+
+    double processBiquad(const Biquad &k, double s[2], double x) {
+        const double y = k.b0 * x + s[0];
+        s[0] = k.b1 * x - k.a1 * y + s[1];
+        s[1] = k.b2 * x - k.a2 * y;
+        return y;
+    }
+}
+
+void LoudnessMeter::Histogram::add(double z) {
+    const double l = toLufs(z);
+    if (l < kAbsoluteGate) return;
+    const int bin = std::clamp(static_cast<int>((l - kBinLow) / kBinWidth), 0, kBins - 1);
+    ++count[bin];
+    energy[bin] += z;
+    ++total;
+    totalEnergy += z;
+}
+
+// K 加權係數依取樣率以雙線性轉換求得（48 kHz 時與 BS.1770 表列值相同）
+LoudnessMeter::LoudnessMeter(int sampleRate, int channels)
+    : m_rate(std::max(8000, sampleRate)),
+      m_channels(std::max(1, channels)),
+      m_stepFrames(std::max<std::int64_t>(1, m_rate / 10)),
+      m_oversample(m_rate < 96000) {
+    for (int ch = 0; ch < m_channels; ++ch) {
+        double w = 1.0;
+        if (m_channels > 3) {
+            if (ch == 3) w = 0.0; // LFE
+            else if (ch >= 4) w = 1.41;
+        }
+        m_weights.push_back(w);
+    }
+    m_state.resize(static_cast<size_t>(m_channels));
+
+    {
+        const double f0 = 1681.974450955533;
+        const double g = 3.999843853973347;
+        const double q = 0.7071752369554196;
+        const double k = std::tan(std::numbers::pi * f0 / m_rate);
+        const double vh = std::pow(10.0, g / 20.0);
+        const double vb = std::pow(vh, 0.4996667741545416);
+        const double a0 = 1.0 + k / q + k * k;
+        m_shelf = {(vh + vb * k / q + k * k) / a0, 2.0 * (k * k - vh) / a0, (vh - vb * k / q + k * k) / a0,
+                   2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0};
+    }
+    {
+        const double f0 = 38.13547087602444;
+        const double q = 0.5003270373238773;
+        const double k = std::tan(std::numbers::pi * f0 / m_rate);
+        const double a0 = 1.0 + k / q + k * k;
+        m_highpass = {1.0, -2.0, 1.0, 2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0};
+    }
+
+    // 4 相位多相濾波器：48 階 Hann 視窗 sinc，每個相位的係數和約為 1
+    constexpr int n = kTaps * kPhases;
+    for (int i = 0; i < n; ++i) {
+        const double t = (i - (n - 1) / 2.0) / kPhases;
+        const double sinc = t == 0.0 ? 1.0 : std::sin(std::numbers::pi * t) / (std::numbers::pi * t);
+        const double window = 0.5 - 0.5 * std::cos(2.0 * std::numbers::pi * (i + 0.5) / n);
+        m_fir[i % kPhases][i / kPhases] = static_cast<float>(sinc * window);
+    }
+    m_history.assign(static_cast<size_t>(m_channels) * kTaps * 2, 0.0f);
+}
+
+void LoudnessMeter::addFrames(const float *in, std::int64_t frames) {
+    for (std::int64_t f = 0; f < frames; ++f) {
+        const float *x = in + f * m_channels;
+
+        // 真峰值：歷史寫兩份，讀取時不必取餘數
+        m_historyPos = m_historyPos == 0 ? kTaps - 1 : m_historyPos - 1;
+        for (int ch = 0; ch < m_channels; ++ch) {
+            const float v = x[ch];
+            m_peak = std::max(m_peak, std::fabs(v));
+            if (!m_oversample) continue;
+            float *h = m_history.data() + static_cast<size_t>(ch) * kTaps * 2;
+            h[m_historyPos] = h[m_historyPos + kTaps] = v;
+            const float *recent = h + m_historyPos; // recent[k] = 第 k 個之前的樣本
+            for (const auto &phase: m_fir) {
+                float acc = 0.0f;
+                for (int k = 0; k < kTaps; ++k) acc += phase[k] * recent[k];
+                m_peak = std::max(m_peak, std::fabs(acc));
+            }
+        }
+
+        // K 加權後的加權平方和
+        double sum = 0.0;
+        for (int ch = 0; ch < m_channels; ++ch) {
+            if (m_weights[ch] == 0.0) continue;
+            auto &s = m_state[static_cast<size_t>(ch)];
+            const double y = processBiquad(m_highpass, &s[2], processBiquad(m_shelf, &s[0], x[ch]));
+            sum += m_weights[ch] * y * y;
+        }
+        m_stepSum += sum;
+        if (++m_stepFill == m_stepFrames) endStep();
+    }
+}
+
+// 每 100 ms：更新 400 ms 與 3 s 區塊（75% 與更高的重疊）
+void LoudnessMeter::endStep() {
+    m_steps[m_stepCount % m_steps.size()] = m_stepSum / static_cast<double>(m_stepFrames);
+    ++m_stepCount;
+    m_stepSum = 0.0;
+    m_stepFill = 0;
+
+    auto meanOfLast = [this](std::int64_t n) {
+        double z = 0.0;
+        for (std::int64_t i = 0; i < n; ++i) z += m_steps[(m_stepCount - 1 - i) % m_steps.size()];
+        return z / static_cast<double>(n);
+    };
+    if (m_stepCount >= 4) m_momentary.add(meanOfLast(4));
+    if (m_stepCount >= 30) m_shortTerm.add(meanOfLast(30));
+}
+
+LoudnessInfo LoudnessMeter::result() const {
+    LoudnessInfo r;
+    r.truePeakDb = m_peak > 0.0f ? 20.0 * std::log10(m_peak) : -std::numeric_limits<double>::infinity();
+
+    // 整合響度：絕對閘門 → 相對閘門 (-10 LU)
+    if (m_momentary.total > 0) {
+        const double gate = toLufs(m_momentary.totalEnergy / static_cast<double>(m_momentary.total)) - 10.0;
+        double energy = 0.0;
+        std::uint64_t blocks = 0;
+        for (int b = 0; b < kBins; ++b) {
+            if (m_momentary.count[b] == 0 || toLufs(m_momentary.energy[b] / m_momentary.count[b]) < gate) continue;
+            energy += m_momentary.energy[b];
+            blocks += m_momentary.count[b];
+        }
+        if (blocks > 0) {
+            r.gatedEnergy = energy / static_cast<double>(blocks);
+            r.gatedBlocks = static_cast<std::uint32_t>(blocks);
+            r.integratedLufs = toLufs(r.gatedEnergy);
+        }
+    }
+
+    // 響度範圍：短期響度經相對閘門 (-20 LU) 後的 10% 與 95% 百分位差
+    if (m_shortTerm.total > 0) {
+        const double gate = toLufs(m_shortTerm.totalEnergy / static_cast<double>(m_shortTerm.total)) - 20.0;
+        const int first = std::clamp(static_cast<int>(std::ceil((gate - kBinLow) / kBinWidth)), 0, kBins);
+        std::uint64_t n = 0;
+        for (int b = first; b < kBins; ++b) n += m_shortTerm.count[b];
+        if (n > 0) {
+            auto percentile = [&](double p) {
+                const auto target = static_cast<std::uint64_t>(p * static_cast<double>(n - 1));
+                std::uint64_t seen = 0;
+                for (int b = first; b < kBins; ++b) {
+                    seen += m_shortTerm.count[b];
+                    if (seen > target) return kBinLow + (b + 0.5) * kBinWidth;
+                }
+                return kBinLow + kBins * kBinWidth;
+            };
+            r.rangeLu = std::max(0.0, percentile(0.95) - percentile(0.10));
+        }
+    }
+    return r;
+}
+
+LoudnessInfo LoudnessInfo::combine(const std::vector<LoudnessInfo> &tracks) {
+    LoudnessInfo r;
+    double energy = 0.0;
+    std::uint64_t blocks = 0;
+    for (const LoudnessInfo &t: tracks) {
+        if (!t.isValid()) continue;
+        energy += t.gatedEnergy * t.gatedBlocks;
+        blocks += t.gatedBlocks;
+        r.truePeakDb = std::max(r.truePeakDb, t.truePeakDb);
+        r.rangeLu = std::max(r.rangeLu, t.rangeLu);
+    }
+    if (blocks > 0) {
+        r.gatedBlocks = static_cast<std::uint32_t>(blocks);
+        r.gatedEnergy = energy / static_cast<double>(blocks);
+        r.integratedLufs = toLufs(r.gatedEnergy);
+    }
+    return r;
+}
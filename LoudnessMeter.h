@@ -0,0 +1,71 @@
+#pragma once
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "DspKernels.h"
+
+// 響度量測結果（EBU R128 / ITU-R BS.1770）
+struct LoudnessInfo {
+    double integratedLufs = -70.0; // 整合響度
+    double rangeLu = 0.0; // 響度範圍 (LRA)
+    double truePeakDb = -std::numeric_limits<double>::infinity(); // dBTP
+    double gatedEnergy = 0.0; // 通過閘門區塊的平均能量（計算專輯響度用）
+    std::uint32_t gatedBlocks = 0;
+
+    bool isValid() const { return gatedBlocks > 0; }
+
+    // 多首合併（專輯）：以區塊數加權能量，峰值取最大
+    static LoudnessInfo combine(const std::vector<LoudnessInfo> &tracks);
+};
+
+// 逐段餵入交錯 float PCM，最後取結果；記憶體用量固定（以直方圖取代保存所有區塊）
+class LoudnessMeter final {
+public:
+    LoudnessMeter(int sampleRate, int channels);
+
+    void addFrames(const float *interleaved, std::int64_t frames);
+
+    LoudnessInfo result() const;
+
+private:
+    static constexpr int kBins = 800; // -70 .. +10 LUFS，每格 0.1 LU
+    static constexpr int kTaps = 12; // 真峰值：每個相位的 FIR 長度
+    static constexpr int kPhases = 4; // 4 倍超取樣
+
+    struct Histogram {
+        std::array<std::uint32_t, kBins> count{};
+        std::array<double, kBins> energy{};
+        std::uint64_t total = 0;
+        double totalEnergy = 0.0;
+
+        void add(double z);
+    };
+
+    void endStep();
+
+    const int m_rate;
+    const int m_channels;
+    std::vector<double> m_weights; // 聲道權重（環繞 1.41，LFE 0）
+    Biquad m_shelf; // K 加權第一級
+    Biquad m_highpass; // K 加權第二級 (RLB)
+    std::vector<std::array<double, 4>> m_state; // 每聲道兩級的 TDF-II 狀態
+
+    // 100 ms 步進；400 ms 區塊 = 最近 4 步，3 s 短期 = 最近 30 步
+    const std::int64_t m_stepFrames;
+    std::int64_t m_stepFill = 0;
+    double m_stepSum = 0.0;
+    std::array<double, 30> m_steps{};
+    std::int64_t m_stepCount = 0;
+
+    Histogram m_momentary; // 整合響度
+    Histogram m_shortTerm; // 響度範圍
+
+    // 真峰值
+    bool m_oversample;
+    std::array<std::array<float, kTaps>, kPhases> m_fir{};
+    std::vector<float> m_history; // 每聲道最近 kTaps 個樣本（環形，存兩份）
+    int m_historyPos = 0;
+    float m_peak = 0.0f;
+};
@@ -0,0 +1,228 @@
+#include "M3UPlaylist.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QSet>
+#include <QThread>
+#include <QThreadPool>
+#include <cstring>
+
+namespace {
+    constexpr int kListChunk = 16; // 每個工作列出的資料夾數
+
+    bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    // #EXTINF:<秒>[ 屬性...],<標題>（引號內的逗號不算分隔）
+    void parseExtinf(const char *p, const char *end, QString &title, qint64 &durationMs) {
+        const char *comma = nullptr;
+        bool quoted = false;
+        for (const char *c = p; c < end; ++c) {
+            if (*c == '"') quoted = !quoted;
+            else if (*c == ',' && !quoted) {
+                comma = c;
+                break;
+            }
+        }
+        const char *numEnd = p;
+        while (numEnd < (comma ? comma : end) && !isSpace(*numEnd)) ++numEnd;
+
+        bool ok = false;
+        const double secs = QByteArray::fromRawData(p, numEnd - p).toDouble(&ok);
+        durationMs = ok && secs >= 0 ? static_cast<qint64>(secs * 1000.0) : -1;
+        title = comma ? QString::fromUtf8(comma + 1, end - comma - 1).trimmed() : QString();
+    }
+
+    bool hasScheme(const QString &s) {
+        const qsizetype i = s.indexOf(QLatin1String("://"));
+        return i > 1; // 排除 Windows 磁碟代號 C:/
+    }
+
+    QString parentOf(const QString &path) {
+        const qsizetype slash = path.lastIndexOf('/');
+        return slash < 0 ? QString() : path.left(slash);
+    }
+}
+
+// 載入
+QVector<PlaylistEntry> M3UPlaylist::load(const QString &file, const QStringList &searchDirs, QString *error,
+                                         QStringList *missing) {
+    QFile f(file);
+    if (!f.open(QIODevice::ReadOnly)) {
+        if (error) *error = f.errorString();
+        return {};
+    }
+
+    const qint64 size = f.size();
+    QByteArray fallback;
+    const char *data = nullptr;
+    if (size > 0) {
+        if (const uchar *map = f.map(0, size)) data = reinterpret_cast<const char *>(map);
+        else {
+            fallback = f.readAll();
+            data = fallback.constData();
+        }
+    }
+
+    // 1. 逐行解析（不經過 QTextStream）
+    struct Raw {
+        QString path;
+        QString title;
+        qint64 durationMs;
+    };
+    QVector<Raw> raw;
+    raw.reserve(static_cast<qsizetype>(size / 48));
+
+    const char *p = data;
+    const char *end = data + size;
+    if (size >= 3 && memcmp(p, "\xEF\xBB\xBF", 3) == 0) p += 3; // UTF-8 BOM
+
+    QString pendingTitle;
+    qint64 pendingDuration = -1;
+    while (p < end) {
+        const char *nl = static_cast<const char *>(memchr(p, '\n', end - p));
+        const char *ls = p;
+        const char *le = nl ? nl : end;
+        p = nl ? nl + 1 : end;
+
+        while (ls < le && isSpace(*ls)) ++ls;
+        while (le > ls && isSpace(le[-1])) --le;
+        if (ls == le) continue;
+
+        if (*ls == '#') {
+            if (le - ls > 8 && memcmp(ls, "#EXTINF:", 8) == 0)
+                parseExtinf(ls + 8, le, pendingTitle, pendingDuration);
+            continue;
+        }
+        raw.push_back({QString::fromUtf8(ls, le - ls), pendingTitle, pendingDuration});
+        pendingTitle.clear();
+        pendingDuration = -1;
+    }
+
+    // 2. 收集要檢查的資料夾（同一資料夾只列一次，取代逐檔 exists）
+    QStringList dirs{QFileInfo(file).absolutePath()};
+    for (const QString &d: searchDirs) {
+        if (!dirs.contains(d)) dirs.push_back(d);
+    }
+
+    QHash<QString, int> dirIndex;
+    QStringList uniqueDirs;
+    auto want = [&](const QString &dir) {
+        if (!dirIndex.contains(dir)) {
+            dirIndex.insert(dir, static_cast<int>(uniqueDirs.size()));
+            uniqueDirs.push_back(dir);
+        }
+    };
+    const bool verify = missing != nullptr; // 只有要回報缺少的檔案時才檢查絕對路徑
+    for (const Raw &r: raw) {
+        if (hasScheme(r.path)) continue;
+        if (QDir::isAbsolutePath(r.path)) {
+            if (verify) want(parentOf(QDir::cleanPath(r.path)));
+        } else {
+            for (const QString &d: dirs) want(parentOf(QDir::cleanPath(d + '/' + r.path)));
+        }
+    }
+
+    // 3. 平行列出資料夾內容
+    QVector<QSet<QString>> listings(uniqueDirs.size());
+    QSet<QString> *out = listings.data(); // 每個工作只寫自己的格子，不需要鎖
+    QThreadPool pool;
+    pool.setMaxThreadCount(std::max(2, QThread::idealThreadCount()));
+    for (qsizetype i = 0; i < uniqueDirs.size(); i += kListChunk) {
+        pool.start([&, i] {
+            const qsizetype last = std::min<qsizetype>(i + kListChunk, uniqueDirs.size());
+            for (qsizetype j = i; j < last; ++j) {
+                QDirIterator it(uniqueDirs.at(j), QDir::Files | QDir::Hidden | QDir::System);
+                while (it.hasNext()) {
+                    it.next();
+                    out[j].insert(it.fileName());
+                }
+            }
+        });
+    }
+    pool.waitForDone();
+
+    auto listed = [&](const QString &path) {
+        const auto it = dirIndex.constFind(parentOf(path));
+        return it != dirIndex.cend() && listings[*it].contains(path.mid(path.lastIndexOf('/') + 1));
+    };
+    // 列表比對失敗（不分大小寫的檔案系統）：驗證時才逐檔問作業系統，
+    // 否則照單全收，存在與否留到預載/播放時再判斷
+    auto exists = [&](const QString &path) {
+        return listed(path) || (verify && QFile::exists(path));
+    };
+
+    // 4. 解析路徑
+    QVector<PlaylistEntry> entries;
+    entries.reserve(raw.size());
+    for (Raw &r: raw) {
+        QUrl url;
+        if (hasScheme(r.path)) {
+            url = QUrl(r.path);
+        } else if (QDir::isAbsolutePath(r.path)) {
+            const QString full = QDir::cleanPath(r.path);
+            if (!verify || exists(full)) url = QUrl::fromLocalFile(full);
+        } else {
+            for (const QString &d: dirs) {
+                if (const QString full = QDir::cleanPath(d + '/' + r.path); listed(full)) {
+                    url = QUrl::fromLocalFile(full);
+                    break;
+                }
+            }
+            if (url.isEmpty()) {
+                // 都不在列表中：以清單所在資料夾為準
+                const QString full = QDir::cleanPath(dirs.front() + '/' + r.path);
+                if (exists(full)) url = QUrl::fromLocalFile(full);
+            }
+        }
+        if (url.isValid() && !url.isEmpty())
+            entries.push_back({url, std::move(r.title), r.durationMs});
+        else if (missing)
+            missing->push_back(r.path);
+    }
+    return entries;
+}
+
+// 儲存
+bool M3UPlaylist::save(const QString &file, const QVector<PlaylistEntry> &entries, const QString &relativeTo,
+                       QString *error) {
+    QSaveFile f(file);
+    if (!f.open(QIODevice::WriteOnly)) {
+        if (error) *error = f.errorString();
+        return false;
+    }
+
+    const QDir base(relativeTo);
+    QByteArray buf;
+    buf.reserve(1 << 20);
+    buf.append("#EXTM3U\n");
+
+    for (const PlaylistEntry &e: entries) {
+        if (!e.title.isEmpty() || e.durationMs >= 0) {
+            buf.append("#EXTINF:");
+            buf.append(QByteArray::number(e.durationMs >= 0 ? (e.durationMs + 500) / 1000 : -1));
+            buf.append(',');
+            buf.append(e.title.toUtf8());
+            buf.append('\n');
+        }
+        buf.append((e.url.isLocalFile() ? base.relativeFilePath(e.url.toLocalFile()) : e.url.toString()).toUtf8());
+        buf.append('\n');
+
+        if (buf.size() >= (1 << 20)) {
+            f.write(buf);
+            buf.truncate(0);
+        }
+    }
+    f.write(buf);
+
+    if (!f.commit()) {
+        if (error) *error = f.errorString();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QUrl>
+#include <QVector>
+
+// 播放清單項目（#EXTINF 的標題與長度可省去探測媒體）
+struct PlaylistEntry {
+    QUrl url;
+    QString title;
+    qint64 durationMs = -1;
+};
+
+// M3U/M3U8 讀寫
+class M3UPlaylist final {
+public:
+    // 以記憶體映射逐行解析；相對路徑依序在清單所在資料夾與 searchDirs 中尋找
+    // 有 missing 時不存在的檔案會被略過（原始路徑記錄在 missing）；
+    // 沒有時不逐檔檢查，相對路徑找不到就當作在清單所在資料夾
+    static QVector<PlaylistEntry> load(const QString &file, const QStringList &searchDirs,
+                                       QString *error = nullptr, QStringList *missing = nullptr);
+
+    // 寫出 Extended M3U，本機檔案以 relativeTo 為基準的相對路徑儲存
+    static bool save(const QString &file, const QVector<PlaylistEntry> &entries, const QString &relativeTo,
+                     QString *error = nullptr);
+};
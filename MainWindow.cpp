@@ -3,7 +3,7 @@
 #include <QtMultimedia/QMediaPlayer>
 #include <QtMultimedia/QAudioOutput>
 #include <QtMultimedia/QMediaMetaData>
-#include <QListWidget>
+#include <QListView>
 #include <QPushButton>
 #include <QSlider>
 #include <QLabel>
@@ -17,28 +17,157 @@
 #include <QShortcut>
 #include <QKeySequence>
 #include <QFileInfo>
-#include <QTextStream>
 #include <QMessageBox>
 #include <QtMultimedia/QMediaDevices>
 #include <QtMultimedia/QAudioDevice>
 #include <QIcon>
+#include <QSettings>
+#include <QProgressBar>
+#include <QTimer>
+#include <QLineEdit>
+#include <QActionGroup>
+#include <QPainter>
+#include <QBuffer>
+#include <QSet>
+#include <QGuiApplication>
+#include <QUndoStack>
+#include <limits>
+#include <numeric>
+#include "PlaylistCommands.h"
+#include "Prefetcher.h"
+#include "SessionSnapshot.h"
+#include "Trace.h"
+#include "TraceOverlay.h"
+#if QT_VERSION >= QT_VERSION_CHECK(6, 8, 0)
+#include <QtMultimedia/QAudioBufferOutput>
+#endif
 
 QString exeDir = QCoreApplication::applicationDirPath();
 
+void SeekSlider::setPeaks(const std::optional<WaveformPeaks> &peaks) {
+    if (!peaks && !m_peaks) return;
+    m_peaks = peaks;
+    renderWaveform();
+    update();
+}
+
+void SeekSlider::resizeEvent(QResizeEvent *e) {
+    QSlider::resizeEvent(e);
+    renderWaveform();
+}
+
+// 只在換曲或改變大小時重畫；播放中的更新只貼兩張圖
+void SeekSlider::renderWaveform() {
+    m_wavePlayed = QPixmap();
+    m_waveRest = QPixmap();
+    if (!m_peaks || m_peaks->isEmpty() || width() <= 2 * kHandleHalf) return;
+
+    const qreal dpr = devicePixelRatioF();
+    const int w = static_cast<int>((width() - 2 * kHandleHalf) * dpr);
+    const int h = static_cast<int>(height() * dpr);
+    const int level = WaveformPeaks::levelFor(w);
+    const int buckets = WaveformPeaks::levelSize(level);
+    const qint8 *peaks = m_peaks->level(level);
+
+    auto render = [&](const QColor &color) {
+        QPixmap pm(w, h);
+        pm.fill(Qt::transparent);
+        QPainter p(&pm);
+        p.setPen(color);
+        const double mid = h / 2.0;
+        const double scale = (h / 2.0 - 1.0) / 127.0;
+        for (int x = 0; x < w; ++x) {
+            const int b0 = static_cast<int>(static_cast<qint64>(x) * buckets / w);
+            const int b1 = std::max(b0 + 1, static_cast<int>(static_cast<qint64>(x + 1) * buckets / w));
+            int lo = 0;
+            int hi = 0;
+            for (int b = b0; b < b1; ++b) {
+                lo = std::min<int>(lo, peaks[2 * b]);
+                hi = std::max<int>(hi, peaks[2 * b + 1]);
+            }
+            p.drawLine(QPointF(x + 0.5, mid - hi * scale), QPointF(x + 0.5, mid - lo * scale + 1.0));
+        }
+        pm.setDevicePixelRatio(dpr);
+        return pm;
+    };
+    m_wavePlayed = render(QColor(0x5C, 0xC8, 0xFF));
+    m_waveRest = render(QColor(255, 255, 255, 70));
+}
+
+void PlaylistView::dragEnterEvent(QDragEnterEvent *e) {
+    if (e->source() == this) e->acceptProposedAction();
+    else e->ignore(); // 外部檔案：交給主視窗匯入
+}
+
+void PlaylistView::dragMoveEvent(QDragMoveEvent *e) {
+    if (e->source() != this) {
+        e->ignore();
+        return;
+    }
+    QListView::dragMoveEvent(e); // 靠近邊緣時自動捲動
+    e->acceptProposedAction();
+}
+
+// 自己處理移動；回報 CopyAction，拖曳結束後檢視不會再去移除來源列
+void PlaylistView::dropEvent(QDropEvent *e) {
+    if (e->source() != this) {
+        e->ignore();
+        return;
+    }
+    emit moveRequested(dropRow(e->position().toPoint()));
+    e->setDropAction(Qt::CopyAction);
+    e->accept();
+    stopAutoScroll();
+    setState(NoState);
+    viewport()->update();
+}
+
+int PlaylistView::dropRow(const QPoint &pos) const {
+    const QModelIndex index = indexAt(pos);
+    if (!index.isValid()) return model()->rowCount();
+    return pos.y() < visualRect(index).center().y() ? index.row() : index.row() + 1;
+}
+
+void SeekSlider::paintEvent(QPaintEvent *e) {
+    if (m_wavePlayed.isNull()) {
+        QSlider::paintEvent(e);
+        return;
+    }
+    QPainter p(this);
+    const double span = maximum() > minimum() ? maximum() - minimum() : 1;
+    const double ratio = std::clamp((value() - minimum()) / span, 0.0, 1.0);
+    const double waveWidth = width() - 2 * kHandleHalf;
+    const double x = ratio * waveWidth;
+    const double dpr = m_wavePlayed.devicePixelRatio();
+
+    p.drawPixmap(QRectF(kHandleHalf, 0, x, height()), m_wavePlayed, QRectF(0, 0, x * dpr, height() * dpr));
+    p.drawPixmap(QRectF(kHandleHalf + x, 0, waveWidth - x, height()), m_waveRest,
+                 QRectF(x * dpr, 0, (waveWidth - x) * dpr, height() * dpr));
+    p.fillRect(QRectF(kHandleHalf + x - 1.0, 0, 2.0, height()), Qt::white);
+}
+
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent),
       m_player(new QMediaPlayer(this)), // 播放器物件
       m_audio(new QAudioOutput(this)) {
     // 音訊輸出物件
+    const Trace::Scope trace(Trace::WindowSetup);
     m_player->setAudioOutput(m_audio); // 連接
+    m_nextPlayer = new QMediaPlayer(this); // 無縫播放用的第二個播放器
+    m_nextAudio = new QAudioOutput(this);
+    m_nextPlayer->setAudioOutput(m_nextAudio);
     m_devices = new QMediaDevices(this); // 媒體裝置物件
+    m_pcm = new PcmPlayer(this);
+    m_pcm->setDspParams(EqualizerDialog::loadSettings());
 
     auto applyDefaultOutput = [this] {
-        const bool wasMuted = m_audio->isMuted();
-        const float vol = m_audio->volume();
-        m_audio->setDevice(QMediaDevices::defaultAudioOutput());
-        m_audio->setVolume(vol);
-        m_audio->setMuted(wasMuted);
+        for (auto *out: {m_audio, m_nextAudio}) {
+            const bool wasMuted = out->isMuted();
+            const float vol = out->volume();
+            out->setDevice(QMediaDevices::defaultAudioOutput());
+            out->setVolume(vol);
+            out->setMuted(wasMuted);
+        }
     };
 
     applyDefaultOutput(); // 初始設定
@@ -49,32 +178,515 @@ MainWindow::MainWindow(QWidget *parent)
     setupMenu();
     setupShortcuts();
 
+#if QT_VERSION >= QT_VERSION_CHECK(6, 8, 0)
+    QAudioFormat tapFormat;
+    tapFormat.setSampleFormat(QAudioFormat::Float);
+    tapFormat.setChannelCount(2);
+    tapFormat.setSampleRate(48000);
+    m_bufferOutput = new QAudioBufferOutput(tapFormat, this);
+    connect(m_bufferOutput, &QAudioBufferOutput::audioBufferReceived, m_spectrum, &SpectrumView::pushBuffer);
+#endif
+
+    attachPlayer();
+    connect(m_pcm, &PcmPlayer::positionChanged, this, &MainWindow::onPositionChanged);
+    connect(m_pcm, &PcmPlayer::durationChanged, this, &MainWindow::onDurationChanged);
+    connect(m_pcm, &PcmPlayer::playbackStateChanged, this, &MainWindow::onStateChanged);
+    connect(m_pcm, &PcmPlayer::errorOccurred, this, &MainWindow::onErrorChanged);
+    connect(m_pcm, &PcmPlayer::mediaStatusChanged, this, &MainWindow::onMediaStatusChanged);
+    connect(m_pcm, &PcmPlayer::trackAdvanced, this, &MainWindow::onTrackAdvanced);
+    m_actGapless->setChecked(QSettings().value("playback/gapless", true).toBool());
+    m_actPcmEngine->setChecked(QSettings().value("playback/pcmEngine", false).toBool());
+    const int rg = std::clamp(QSettings().value("playback/replayGain", RgOff).toInt(), 0, 2);
+    m_actReplayGain[rg]->setChecked(true);
+    m_prefetchDepth = std::clamp(QSettings().value("playback/prefetchDepth", 3).toInt(), 1, 16);
+    m_prefetch->setBudget(qint64(std::max(0, QSettings().value("playback/prefetchMB", 256).toInt())) << 20);
+    m_crossfadeMs = std::clamp(QSettings().value("playback/crossfadeMs", 0).toInt(), 0, 12000);
+    m_pcm->setCrossfade(m_crossfadeMs, static_cast<FadeCurve>(
+                            std::clamp(QSettings().value("playback/crossfadeCurve", 1).toInt(), 0, 2)));
+    m_pcm->setSkipFade(QSettings().value("playback/skipFade", true).toBool() ? kSkipFadeMs : 0);
+    m_actVisualizer->setChecked(QSettings().value("view/visualizer", true).toBool());
+    m_actTraceOverlay->setChecked(QSettings().value("view/latencyOverlay", false).toBool());
+    m_actTraceRecord->setChecked(Trace::isEnabled());
+
+    // 播放順序與搜尋索引跟著清單的增刪重新編號
+    connect(m_model, &QAbstractItemModel::rowsInserted, this, [this](const QModelIndex &, int first, int last) {
+        m_order.insertRows(first, last - first + 1);
+        QStringList paths;
+        paths.reserve(last - first + 1);
+        for (int row = first; row <= last; ++row) paths.push_back(m_model->path(row));
+        if (m_search->size() == first) {
+            m_search->append(paths, m_meta); // 鍵值與 posting 在背景建立
+        } else {
+            m_search->invalidate(); // 還原後索引還沒建立：之後整個重建
+            m_reindexTimer->start();
+        }
+        if (m_filterModel->isFiltered()) m_filterTimer->start();
+    });
+    connect(m_model, &PlaylistModel::rowsRemapped, this, [this](const QVector<int> &newRowOf, int count) {
+        m_order.remapRows(newRowOf, count);
+        QVector<bool> kept(count, false);
+        for (const int n: newRowOf) {
+            if (n >= 0) kept[n] = true;
+        }
+        QStringList paths; // 插入的列（復原移除）
+        QStringList local;
+        for (int row = 0; row < count; ++row) {
+            if (kept[row]) continue;
+            paths.push_back(m_model->path(row));
+            if (const QString file = m_model->localFile(row); !file.isEmpty()) local.push_back(file);
+        }
+        if (m_search->size() == newRowOf.size()) {
+            m_search->remapRows(newRowOf, count, paths, m_meta);
+        } else {
+            m_search->invalidate();
+            m_reindexTimer->start();
+        }
+        if (!paths.isEmpty() && m_filterModel->isFiltered()) m_filterTimer->start();
+        if (m_dupSeeded) m_dupes->add(local, false); // 放回的列重新當作重複比對的基準
+
+        if (m_currentIndex >= 0) {
+            m_currentIndex = m_currentIndex < newRowOf.size() ? newRowOf[m_currentIndex] : -1;
+            if (m_currentIndex < 0) stop();
+        }
+        m_sessionDirty = true;
+        scheduleTotalDuration();
+    });
+    // 不論是移除、復原加入還是檔案消失，移走的列都不再當作重複比對的基準
+    connect(m_model, &PlaylistModel::rowsAboutToBeRemapped, this, [this](const QVector<int> &newRowOf, int count) {
+        if (!m_dupSeeded) return;
+        if (count == 0) {
+            m_dupes->reset(); // 整份清單都移除了
+            m_dupSeeded = false;
+            return;
+        }
+        QStringList gone;
+        for (int row = 0; row < newRowOf.size(); ++row) {
+            if (newRowOf[row] >= 0) continue;
+            if (const QString path = m_model->localFile(row); !path.isEmpty()) gone.push_back(path);
+        }
+        m_dupes->remove(gone);
+    });
+    connect(m_model, &QAbstractItemModel::rowsRemoved, this, [this](const QModelIndex &, int first, int last) {
+        QVector<int> rows(last - first + 1);
+        std::iota(rows.begin(), rows.end(), first);
+        m_order.removeRows(rows);
+    });
+    connect(m_model, &QAbstractItemModel::modelReset, this, [this] { m_order.reset(m_model->count()); });
+    m_order.setShuffle(QSettings().value("playback/shuffle", false).toBool());
+    m_order.setRepeat(static_cast<PlayOrder::Repeat>(
+        std::clamp(QSettings().value("playback/repeat", PlayOrder::RepeatAll).toInt(), 0, 2)));
+
+    m_sessionPool.setMaxThreadCount(1);
+    restoreSession();
+    connect(m_model, &QAbstractItemModel::rowsInserted, this, [this] { m_sessionDirty = true; });
+    connect(m_model, &QAbstractItemModel::rowsRemoved, this, [this] { m_sessionDirty = true; });
+    connect(m_model, &QAbstractItemModel::rowsMoved, this, [this] { m_sessionDirty = true; });
+    connect(m_model, &QAbstractItemModel::modelReset, this, [this] { m_sessionDirty = true; });
+    m_sessionTimer = new QTimer(this);
+    m_sessionTimer->setInterval(15000);
+    connect(m_sessionTimer, &QTimer::timeout, this, [this] { saveSession(false); });
+    m_sessionTimer->start();
+
+    // 音樂庫監看：在還原清單之後，啟動比對的結果才能對應到現有的列
+    m_library = new LibraryWatcher(this);
+    connect(m_library, &LibraryWatcher::changed, this, &MainWindow::onLibraryChanged);
+    QSettings settings;
+    if (settings.contains("library/roots")) {
+        m_library->setRoots(settings.value("library/roots").toStringList());
+    } else if (const QString mp3 = mp3BasePath(); QFileInfo(mp3).isDir()) {
+        m_library->setRoots({mp3}); // 預設監看 ../mp3
+    }
+
+    setAcceptDrops(true);
+    statusBar()->showMessage("Ready"); // 就緒
+}
+
+MainWindow::~MainWindow() {
+    saveSession(true);
+    delete m_spectrum; // 視覺化執行緒使用 m_pcm 的 tap，要比 m_pcm 先停
+}
+
+// 還原上次的清單、目前曲目、位置與音量；不自動播放，按下播放才開啟檔案
+void MainWindow::restoreSession() {
+    const auto snapshot = SessionSnapshot::open();
+    if (!snapshot) return;
+    const SessionSnapshot::State st = snapshot->state();
+    m_model->restore(snapshot); // 只映射，不逐列建立 QUrl
+    m_undo->clear();
+    m_sessionDirty = false;
+
+    m_volume->setValue(st.volume);
+    if (st.muted != m_audio->isMuted()) toggleMute();
+    if (st.currentIndex >= 0) {
+        m_currentIndex = st.currentIndex;
+        m_order.setCurrent(m_currentIndex);
+        m_model->setNowPlaying(m_currentIndex);
+        const QModelIndex idx = m_filterModel->mapFromSource(m_model->index(m_currentIndex));
+        m_list->setCurrentIndex(idx);
+        m_list->scrollTo(idx, QAbstractItemView::PositionAtCenter);
+        m_resumeMs = st.positionMs;
+        updateTimeLabels(st.positionMs, 0);
+    }
+
+    // 搜尋索引與總長度需要整份清單：等視窗可操作後再建立
+    m_reindexTimer->start();
+    QTimer::singleShot(m_reindexTimer->interval(), this, &MainWindow::scheduleTotalDuration);
+}
+
+// 結束時與定期寫出；清單沒變時只改寫檔頭
+void MainWindow::saveSession(bool wait) {
+    SessionSnapshot::State st;
+    st.currentIndex = m_currentIndex;
+    if (m_resumeMs >= 0) st.positionMs = m_resumeMs;
+    else if (m_currentIndex >= 0) st.positionMs = playerPosition();
+    st.volume = m_volume->value();
+    st.muted = m_audio->isMuted();
+
+    if (m_sessionDirty) {
+        m_sessionDirty = false;
+        m_sessionPool.start([tracks = m_model->tracks(), st] { SessionSnapshot::save(tracks, st); });
+    } else {
+        m_sessionPool.start([this, count = m_model->count(), st] {
+            // 快照不見了或與清單不符：下次寫整份
+            if (!SessionSnapshot::saveState(count, st))
+                QMetaObject::invokeMethod(this, [this] { m_sessionDirty = true; });
+        });
+    }
+    if (wait) m_sessionPool.waitForDone();
+}
+
+// 連接目前播放器的訊號
+void MainWindow::attachPlayer() {
     connect(m_player, &QMediaPlayer::positionChanged, this, &MainWindow::onPositionChanged);
     connect(m_player, &QMediaPlayer::durationChanged, this, &MainWindow::onDurationChanged);
     connect(m_player, &QMediaPlayer::playbackStateChanged, this, &MainWindow::onStateChanged);
     connect(m_player, &QMediaPlayer::errorOccurred, this, &MainWindow::onErrorChanged);
     connect(m_player, &QMediaPlayer::mediaStatusChanged, this, &MainWindow::onMediaStatusChanged);
     connect(m_audio, &QAudioOutput::volumeChanged, this, &MainWindow::onVolumeChanged);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 8, 0)
+    m_player->setAudioBufferOutput(m_bufferOutput); // 預載中的播放器不送樣本
+#endif
+}
 
-    setAcceptDrops(true);
-    statusBar()->showMessage("Ready"); // 就緒
+// 中斷目前播放器的訊號
+void MainWindow::detachPlayer() {
+    disconnect(m_player, nullptr, this, nullptr);
+    disconnect(m_audio, nullptr, this, nullptr);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 8, 0)
+    m_player->setAudioBufferOutput(nullptr);
+#endif
+}
+
+// 預載下一首：先開啟並解碼開頭，等 EndOfMedia 再交接
+void MainWindow::preloadNext() {
+    updatePrefetch();
+    const bool chain = m_gapless || (m_usePcm && m_crossfadeMs > 0); // 交叉淡化也要先接上下一首
+    int nextIdx = chain && m_currentIndex >= 0 ? nextRow() : -1;
+    if (nextIdx >= 0 && !unplayableReason(nextIdx).isEmpty()) nextIdx = -1; // 交給 playIndex 跳過
+    if (m_usePcm) {
+        m_pcm->setNextSource(nextIdx >= 0 ? m_model->url(nextIdx) : QUrl()); // 解碼器直接接續，取樣不中斷
+        return;
+    }
+    if (nextIdx < 0) {
+        clearPreload();
+        return;
+    }
+    const QUrl url = m_model->url(nextIdx);
+    if (url == m_preloadUrl) return;
+
+    m_preloadUrl = url;
+    m_nextPlayer->setSource(url);
+}
+
+// 預讀命中時從記憶體開啟；緩衝在播放器下次換來源後釋放
+void MainWindow::setPlayerSource(const QUrl &url) const {
+    const QByteArray data = m_prefetch->acquire(url);
+    if (data.isEmpty()) {
+        m_player->setSource(url);
+        return;
+    }
+    auto *buffer = new QBuffer(m_player);
+    buffer->setData(data);
+    buffer->open(QIODevice::ReadOnly);
+    m_player->setSourceDevice(buffer, url); // url 提供格式提示
+    connect(m_player, &QMediaPlayer::sourceChanged, buffer, &QObject::deleteLater, Qt::SingleShotConnection);
+}
+
+// 接下來的幾首與上一首：跟著 next()、previous() 與點選重新排序
+void MainWindow::updatePrefetch() {
+    if (m_prefetch->budget() <= 0) return;
+    QList<QUrl> upcoming;
+    if (m_currentIndex >= 0) {
+        for (const int row: m_order.upcoming(m_prefetchDepth)) {
+            if (row != m_currentIndex) upcoming.push_back(m_model->url(row));
+        }
+        if (const int prev = m_order.peekPrevious(); prev >= 0 && prev != m_currentIndex)
+            upcoming.push_back(m_model->url(prev));
+    }
+    m_prefetch->setUpcoming(upcoming);
+}
+
+// 取消預載
+void MainWindow::clearPreload() {
+    if (m_preloadUrl.isEmpty()) return;
+    m_preloadUrl.clear();
+    m_nextPlayer->setSource(QUrl());
+}
+
+// 若 idx 已預載完成，直接切換到第二個播放器
+bool MainWindow::takePreloaded(int idx) {
+    if (m_usePcm || !m_gapless || m_preloadUrl.isEmpty() || m_model->url(idx) != m_preloadUrl) return false;
+
+    using MS = QMediaPlayer::MediaStatus;
+    if (const auto st = m_nextPlayer->mediaStatus(); st != MS::LoadedMedia && st != MS::BufferedMedia)
+        return false;
+
+    m_nextAudio->setVolume(m_audio->volume());
+    m_nextAudio->setMuted(m_audio->isMuted());
+    m_nextPlayer->play(); // 先開始下一首，再停掉舊的
+
+    detachPlayer();
+    m_player->stop();
+    std::swap(m_player, m_nextPlayer);
+    std::swap(m_audio, m_nextAudio);
+    attachPlayer();
+
+    m_preloadUrl.clear();
+    m_nextPlayer->setSource(QUrl());
+
+    onDurationChanged(m_player->duration());
+    onStateChanged();
+    return true;
+}
+
+// 無縫播放開關
+void MainWindow::setGapless(bool on) {
+    m_gapless = on;
+    QSettings().setValue("playback/gapless", on);
+    if (on || m_usePcm) preloadNext();
+    else clearPreload();
+}
+
+// 切換播放引擎：從目前位置接著播
+void MainWindow::setPcmEngine(bool on) {
+    QSettings().setValue("playback/pcmEngine", on);
+    if (on == m_usePcm) return;
+
+    const bool playing = playerState() == QMediaPlayer::PlayingState;
+    const qint64 pos = playerPosition();
+    if (m_usePcm) m_pcm->setSource(QUrl());
+    else {
+        m_player->stop();
+        clearPreload();
+    }
+    m_usePcm = on;
+    m_lblEngine->setVisible(on);
+    if (on) m_engineTimer->start();
+    else m_engineTimer->stop();
+
+    if (m_currentIndex >= 0 && playing) {
+        playIndex(m_currentIndex);
+        setPlayerPosition(pos);
+    } else {
+        stop();
+    }
+    statusBar()->showMessage(on ? "Engine: direct PCM" : "Engine: Qt Multimedia", 3000);
+}
+
+// 等化器（只作用在 PCM 引擎）
+void MainWindow::showEqualizer() {
+    if (!m_eqDialog) {
+        m_eqDialog = new EqualizerDialog(m_pcm->dspKernel(), this);
+        m_eqDialog->setParams(EqualizerDialog::loadSettings());
+        connect(m_eqDialog, &EqualizerDialog::paramsChanged, this, [this](const DspChain::Params &p) {
+            m_pcm->setDspParams(p);
+            EqualizerDialog::saveSettings(p);
+            if (!m_usePcm) statusBar()->showMessage("Equalizer applies to the direct PCM engine", 3000);
+        });
+    }
+    m_eqDialog->show();
+    m_eqDialog->raise();
+    m_eqDialog->activateWindow();
+}
+
+// PCM 引擎已無縫接到下一首
+void MainWindow::onTrackAdvanced(const QUrl &url) {
+    int idx = m_order.next(false);
+    if (idx < 0 || m_model->url(idx) != url) {
+        idx = m_model->indexOf(url);
+        if (idx < 0) return;
+        m_order.setCurrent(idx);
+    }
+
+    m_currentIndex = idx;
+    m_model->setNowPlaying(idx);
+    m_list->setCurrentIndex(m_filterModel->mapFromSource(m_model->index(idx)));
+    preloadNext();
+    applyReplayGain();
+    updateWaveform();
+    statusBar()->showMessage("Track transition: 0 ms (sample-accurate)", 3000);
 }
 
-MainWindow::~MainWindow() = default;
+// ReplayGain 模式：關閉 / 曲目 / 專輯
+void MainWindow::setReplayGainMode(int mode) {
+    m_replayGain = mode;
+    QSettings().setValue("playback/replayGain", mode);
+    if (mode == RgOff) m_loudness->cancel();
+    applyReplayGain();
+}
+
+// 背景分析整個清單（已分析且未變更的只 stat）
+void MainWindow::analyzePlaylistLoudness() {
+    QStringList paths;
+    paths.reserve(m_model->count());
+    const TrackStore &tracks = m_model->tracks();
+    for (int row = 0; row < tracks.count(); ++row) {
+        if (tracks.isLocalFile(row)) paths.push_back(tracks.localFile(row));
+    }
+    m_loudness->analyze(paths);
+}
+
+// 同資料夾且專輯標籤相同的相鄰曲目視為同一張專輯
+std::optional<LoudnessInfo> MainWindow::albumLoudness(int idx) const {
+    constexpr int kMaxAlbumSpan = 100;
+    auto albumKey = [this](int row) {
+        const QString path = m_model->localFile(row);
+        const auto info = m_meta->find(path);
+        return QFileInfo(path).path() + '\n' + (info ? info->album : QString());
+    };
+    const QString key = albumKey(idx);
+    int first = idx;
+    int last = idx;
+    while (first > 0 && idx - first < kMaxAlbumSpan && albumKey(first - 1) == key) --first;
+    while (last + 1 < m_model->count() && last - idx < kMaxAlbumSpan && albumKey(last + 1) == key) ++last;
+
+    std::vector<LoudnessInfo> tracks;
+    QStringList missing;
+    for (int row = first; row <= last; ++row) {
+        const QString path = m_model->localFile(row);
+        if (const auto info = m_loudness->find(path)) tracks.push_back(*info);
+        else missing.push_back(path);
+    }
+    if (!missing.isEmpty()) m_loudness->analyze(missing, true);
+    if (tracks.empty()) return std::nullopt;
+    return LoudnessInfo::combine(tracks);
+}
+
+// 套用目前曲目的增益；尚未分析的先以 0 dB 播放，分析完成後再套用
+void MainWindow::applyReplayGain() {
+    double db = 0.0;
+    const QString path = m_currentIndex >= 0 ? m_model->localFile(m_currentIndex) : QString();
+    if (m_replayGain != RgOff && !path.isEmpty()) {
+        const auto info = m_replayGain == RgAlbum ? albumLoudness(m_currentIndex) : m_loudness->find(path);
+        if (!info) m_loudness->analyze({path}, true);
+        else if (info->isValid()) {
+            db = LoudnessAnalyzer::gainDb(*info);
+            statusBar()->showMessage(QString("ReplayGain %1 dB (%2 LUFS, LRA %3 LU)")
+                                     .arg(db, 0, 'f', 1)
+                                     .arg(info->integratedLufs, 0, 'f', 1)
+                                     .arg(info->rangeLu, 0, 'f', 1), 3000);
+        }
+    }
+    m_pcm->setReplayGain(static_cast<float>(db)); // 在限幅器之前，提升也不會削波
+    m_qtGain = std::min(1.0f, static_cast<float>(std::pow(10.0, db / 20.0)));
+    updateOutputVolume();
+}
+
+// 快取裡有就立即顯示，否則背景解碼後由 ready 觸發
+void MainWindow::updateWaveform() {
+    const QUrl url = m_currentIndex >= 0 ? m_model->url(m_currentIndex) : QUrl();
+    m_seek->setPeaks(url.isLocalFile() ? m_waveforms->request(url.toLocalFile()) : std::nullopt);
+}
+
+// 音量條 × ReplayGain
+void MainWindow::updateOutputVolume() const {
+    const float scaled = std::clamp(static_cast<float>(m_volume->value()) / 100.0f, 0.0f, 1.0f);
+    m_audio->setVolume(scaled * m_qtGain);
+    m_pcm->setVolume(scaled);
+}
+
+qint64 MainWindow::playerPosition() const {
+    return m_usePcm ? m_pcm->position() : m_player->position();
+}
+
+QMediaPlayer::PlaybackState MainWindow::playerState() const {
+    return m_usePcm ? m_pcm->playbackState() : m_player->playbackState();
+}
+
+void MainWindow::setPlayerPosition(qint64 ms) const {
+    if (playerState() == QMediaPlayer::PlayingState) {
+        m_seekTraceMs = ms;
+        Trace::begin(Trace::Seek);
+    }
+    if (m_usePcm) m_pcm->setPosition(ms);
+    else m_player->setPosition(ms);
+}
+
+// 緩衝深度、解碼領先量與 underrun 次數
+void MainWindow::updateEngineStats() const {
+    const PcmPlayer::Metrics m = m_pcm->metrics();
+    m_lblEngine->setText(QString("PCM %1/%2 ms · ahead %3 ms · underruns %4")
+        .arg(m.bufferedMs).arg(m.capacityMs).arg(m.decodeAheadMs).arg(m.underruns));
+}
 
 // UI 設定
 void MainWindow::setupUi() {
-    m_list = new QListWidget(this);
+    m_search = new SearchIndex(this); // 先建立：解構時先等背景重建結束，才釋放 m_meta
+    m_meta = new MetadataIndex(this);
+    m_meta->open();
+
+    m_model = new PlaylistModel(this);
+    m_model->setMetadataIndex(m_meta);
+    m_filterModel = new PlaylistFilterModel(this);
+    m_filterModel->setSourceModel(m_model);
+    m_undo = new QUndoStack(this);
+    m_undo->setUndoLimit(100);
+    m_list = new PlaylistView(this);
+    m_list->setModel(m_filterModel);
+    m_list->setItemDelegate(new PlaylistDelegate(m_list));
+    m_list->setUniformItemSizes(true); // 固定列高，只繪製可見列
+    m_list->setMouseTracking(true);
 
     // highlight always blue (even when sliders are clicked)
     m_list->setSelectionBehavior(QAbstractItemView::SelectItems);
-    m_list->setSelectionMode(QAbstractItemView::SingleSelection);
+    m_list->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    m_list->setDragDropMode(QAbstractItemView::InternalMove);
+    m_list->setDefaultDropAction(Qt::MoveAction);
     m_list->setFocusPolicy(Qt::NoFocus);
-    m_list->setStyleSheet("QListWidget::item:selected { color: #5CC8FF; background: transparent; font-weight: bold; }");
 
-    connect(m_list, &QListWidget::itemClicked, this, [this](QListWidgetItem *) {
-        playSelected(m_list->currentRow());
+    connect(m_list, &QListView::clicked, this, [this](const QModelIndex &index) {
+        // Ctrl/Shift 點選只是改變選取
+        if (QGuiApplication::keyboardModifiers() & (Qt::ControlModifier | Qt::ShiftModifier)) return;
+        playSelected(rowAt(index));
     });
+    connect(m_list, &PlaylistView::moveRequested, this, [this](int viewRow) {
+        const QVector<int> &visible = m_filterModel->sourceRows();
+        int dest;
+        if (viewRow < m_filterModel->rowCount()) dest = rowAt(m_filterModel->index(viewRow, 0));
+        else dest = m_filterModel->isFiltered() && !visible.isEmpty() ? visible.back() + 1 : m_model->count();
+        moveRows(selectedRows(), dest);
+    });
+
+    // 過濾列
+    m_filter = new QLineEdit(this);
+    m_filter->setPlaceholderText("Filter…");
+    m_filter->setClearButtonEnabled(true);
+    m_filterTimer = new QTimer(this);
+    m_filterTimer->setSingleShot(true);
+    m_filterTimer->setInterval(0);
+    connect(m_filterTimer, &QTimer::timeout, this, &MainWindow::applyFilter);
+    connect(m_filter, &QLineEdit::textChanged, this, &MainWindow::applyFilter);
+    connect(m_search, &SearchIndex::ready, this, [this] {
+        if (m_filterModel->isFiltered()) m_filterTimer->start();
+        // 處理的事件可能又加入列（索引再度不完整）：剩下的等下一次
+        while (!m_afterIndex.isEmpty() && m_search->isComplete(m_model->count())) m_afterIndex.takeFirst()();
+    });
+
+    // 標籤更新後在背景重建索引（合併短時間內的多次更新）
+    m_reindexTimer = new QTimer(this);
+    m_reindexTimer->setSingleShot(true);
+    m_reindexTimer->setInterval(2000);
+    connect(m_reindexTimer, &QTimer::timeout, this, [this] { m_search->rebuild(m_model->paths(), m_meta); });
 
     m_btnPrev = new QPushButton(this);
     m_btnPlayPause = new QPushButton(this);
@@ -108,8 +720,14 @@ void MainWindow::setupUi() {
     connect(m_btnMute, &QPushButton::clicked, this, &MainWindow::toggleMute);
 
     m_seek = new SeekSlider(Qt::Horizontal, this);
-    m_seek->setRange(0, 1000);
+    m_seek->setRange(0, 0); // 單位為毫秒，範圍隨曲長設定
     m_seek->setTracking(true);
+    m_seek->setMinimumHeight(28); // 波形需要的高度
+
+    m_waveforms = new WaveformCache(this);
+    connect(m_waveforms, &WaveformCache::ready, this, [this](const QString &path) {
+        if (m_currentIndex >= 0 && m_model->localFile(m_currentIndex) == path) updateWaveform();
+    });
 
     connect(m_seek, &QSlider::valueChanged, this, &MainWindow::onSeek);
 
@@ -125,10 +743,7 @@ void MainWindow::setupUi() {
     m_volume->setValue(100); // default 100%
     m_audio->setVolume(1.0f); // 100% = 1.0
 
-    connect(m_volume, &QSlider::valueChanged, this, [this](int v) {
-        const float scaled = std::clamp(static_cast<float>(v) / 100.0f, 0.0f, 1.0f);
-        m_audio->setVolume(scaled);
-    });
+    connect(m_volume, &QSlider::valueChanged, this, &MainWindow::updateOutputVolume);
 
     m_seek->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
     m_seek->setMinimumWidth(100); // optional floor
@@ -162,7 +777,12 @@ void MainWindow::setupUi() {
     const auto rootV = new QVBoxLayout(central);
     rootV->setContentsMargins(0, 0, 0, 0);
     rootV->setSpacing(0);
+    rootV->addWidget(m_filter, 0);
     rootV->addWidget(m_list, 1);
+    m_traceOverlay = new TraceOverlay(m_list->viewport());
+    m_spectrum = new SpectrumView(m_pcm->tap(), this);
+    m_spectrum->hide(); // 由 View 選單依設定顯示
+    rootV->addWidget(m_spectrum, 0);
     rootV->addWidget(bottom, 0);
     setCentralWidget(central);
 
@@ -171,6 +791,103 @@ void MainWindow::setupUi() {
     tb->addAction("Clear", this, &MainWindow::clearList);
     tb->addAction("Remove", this, &MainWindow::removeSelected);
 
+    // 匯入進度（平時隱藏）
+    m_importer = new LibraryImporter(this);
+    m_importLabel = new QLabel(this);
+    m_importBar = new QProgressBar(this);
+    m_importBar->setRange(0, 0); // 總數未知，顯示忙碌動畫
+    m_importBar->setFixedWidth(120);
+    m_importBar->setMaximumHeight(12);
+    m_importBar->setTextVisible(false);
+    m_importCancel = new QPushButton("Cancel", this);
+    statusBar()->addPermanentWidget(m_importLabel);
+    statusBar()->addPermanentWidget(m_importBar);
+    statusBar()->addPermanentWidget(m_importCancel);
+    for (QWidget *w: {static_cast<QWidget *>(m_importLabel), static_cast<QWidget *>(m_importBar),
+                      static_cast<QWidget *>(m_importCancel)})
+        w->hide();
+
+    connect(m_importCancel, &QPushButton::clicked, m_importer, &LibraryImporter::cancel);
+    // 匯入時已依檔頭過濾（沒有副檔名的音訊檔也在內），不再看副檔名
+    connect(m_importer, &LibraryImporter::batchReady, this, [this](const QList<QUrl> &urls) {
+        addTracks(urls, true, m_importBatch);
+    });
+    connect(m_importer, &LibraryImporter::unplayable, this, [this](const QStringList &paths, const QStringList &reasons) {
+        m_model->markUnplayable(paths, reasons);
+        statusBar()->showMessage(QString("%1 file(s) cannot be played").arg(paths.size()), 3000);
+    });
+    connect(m_importer, &LibraryImporter::progress, this, [this](int scanned, int accepted) {
+        m_importLabel->setText(QString("Importing… %1 scanned, %2 added").arg(scanned).arg(accepted));
+    });
+    connect(m_importer, &LibraryImporter::finished, this, [this](bool canceled) {
+        m_importLabel->hide();
+        m_importBar->hide();
+        m_importCancel->hide();
+        statusBar()->showMessage(canceled ? "Import canceled" : "Import finished", 3000);
+    });
+
+    // 清單總長度（背景加總，合併短時間內的多次更新）
+    m_lblTotal = new QLabel(this);
+    statusBar()->addPermanentWidget(m_lblTotal);
+    m_totalTimer = new QTimer(this);
+    m_totalTimer->setSingleShot(true);
+    m_totalTimer->setInterval(300);
+    connect(m_totalTimer, &QTimer::timeout, this, [this] { m_meta->requestTotalDuration(m_model->paths()); });
+    connect(m_meta, &MetadataIndex::totalDurationReady, this, [this](qint64 ms, int) {
+        m_lblTotal->setText(m_model->isEmpty()
+                                ? QString()
+                                : QString("%1 tracks · %2").arg(m_model->count()).arg(formatTime(ms)));
+    });
+    connect(m_meta, &MetadataIndex::updated, this, [this] {
+        m_model->refreshMetadata();
+        scheduleTotalDuration();
+        m_reindexTimer->start();
+    });
+
+    // 響度分析（結果持久化，每個檔案只分析一次）
+    m_loudness = new LoudnessAnalyzer(this);
+    m_loudness->open();
+    m_lblLoudness = new QLabel(this);
+    m_lblLoudness->setStyleSheet("color: #888888;");
+    m_lblLoudness->hide();
+    statusBar()->addPermanentWidget(m_lblLoudness);
+    connect(m_loudness, &LoudnessAnalyzer::progress, this, [this](int pending) {
+        m_lblLoudness->setText(QString("Analyzing loudness… %1 left").arg(pending));
+        m_lblLoudness->setVisible(pending > 0);
+    });
+    connect(m_loudness, &LoudnessAnalyzer::analyzed, this, [this](const QString &path) {
+        if (m_replayGain == RgOff || m_currentIndex < 0) return;
+        const QString current = m_model->localFile(m_currentIndex);
+        if (path == current || (m_replayGain == RgAlbum && QFileInfo(path).path() == QFileInfo(current).path()))
+            applyReplayGain();
+    });
+
+    // 重複檔案偵測（只在匯入時比對，雜湊結果持久化）
+    m_dupes = new DuplicateFinder(this);
+    connect(m_dupes, &DuplicateFinder::duplicatesFound, this, &MainWindow::onDuplicatesFound);
+
+    // PCM 引擎狀態
+    m_lblEngine = new QLabel(this);
+    m_lblEngine->setStyleSheet("color: #888888;");
+    m_lblEngine->hide();
+    statusBar()->addPermanentWidget(m_lblEngine);
+    m_engineTimer = new QTimer(this);
+    m_engineTimer->setInterval(500);
+    connect(m_engineTimer, &QTimer::timeout, this, &MainWindow::updateEngineStats);
+
+    m_prefetch = new Prefetcher(this);
+    m_lblPrefetch = new QLabel(this);
+    m_lblPrefetch->setStyleSheet("color: #888888;");
+    m_lblPrefetch->setToolTip("Read-ahead: tracks opened from memory / from disk, memory used / budget");
+    m_lblPrefetch->hide();
+    statusBar()->addPermanentWidget(m_lblPrefetch);
+    connect(m_prefetch, &Prefetcher::statsChanged, this, [this] {
+        const Prefetcher::Stats st = m_prefetch->stats();
+        m_lblPrefetch->setVisible(st.budgetBytes > 0);
+        m_lblPrefetch->setText(QString("Read-ahead %1 hit / %2 miss · %3/%4 MB")
+            .arg(st.hits).arg(st.misses).arg(st.usedBytes >> 20).arg(st.budgetBytes >> 20));
+    });
+
     auto *label = new QLabel("Made by Ethan");
     statusBar()->addPermanentWidget(label);
     label->setStyleSheet("color: #888888; font-size: 10pt;");
@@ -181,11 +898,16 @@ void MainWindow::setupUi() {
 void MainWindow::onMediaStatusChanged(QMediaPlayer::MediaStatus status) {
     using MS = QMediaPlayer::MediaStatus;
     if (status == MS::LoadedMedia || status == MS::BufferedMedia) {
-        qint64 d = m_player->duration();
+        qint64 d = m_usePcm ? m_pcm->duration() : m_player->duration();
         if (d > 0) {
             m_durationMs = d;
-            updateTimeLabels(m_player->position(), m_durationMs);
+            updateTimeLabels(playerPosition(), m_durationMs);
         }
+        if (m_pendingSeekMs > 0) setPlayerPosition(std::exchange(m_pendingSeekMs, 0));
+    } else if (status == MS::EndOfMedia) {
+        m_transitionTimer.start(); // 量測換曲延遲
+        if (const int row = m_order.next(false); row >= 0) playIndex(row);
+        else stop(); // 不重複：播完清單就停
     }
 }
 
@@ -193,14 +915,208 @@ void MainWindow::onMediaStatusChanged(QMediaPlayer::MediaStatus status) {
 void MainWindow::setupMenu() {
     const auto file = menuBar()->addMenu("&File");
     m_actOpen = file->addAction("Open…", QKeySequence::Open, this, &MainWindow::openFiles);
+    m_actOpenFolder = file->addAction("Open Folder…", this, &MainWindow::openFolder);
     m_actLoadM3U = file->addAction("Load M3U…", this, &MainWindow::loadM3U);
     m_actSaveM3U = file->addAction("Save M3U…", this, &MainWindow::saveM3U);
     file->addSeparator();
+    const auto library = file->addMenu("Library Folders");
+    library->setToolTipsVisible(true);
+    connect(library, &QMenu::aboutToShow, this, [this, library] {
+        library->clear();
+        library->addAction("Watch Folder…", this, [this] {
+            const QString dir = QFileDialog::getExistingDirectory(this, "Watch Folder", mp3BasePath());
+            if (!dir.isEmpty()) setLibraryRoots(m_library->roots() << dir);
+        });
+        if (!m_library->roots().isEmpty()) library->addSeparator();
+        for (const QString &root: m_library->roots()) {
+            auto *act = library->addAction(root);
+            act->setCheckable(true);
+            act->setChecked(true);
+            act->setToolTip("Uncheck to stop watching (tracks stay in the playlist)");
+            connect(act, &QAction::toggled, this, [this, root](bool on) {
+                if (on) return;
+                QStringList roots = m_library->roots();
+                roots.removeAll(root);
+                setLibraryRoots(roots);
+            });
+        }
+    });
+    file->addSeparator();
     file->addAction("E&xit", QKeySequence::Quit, this, &QWidget::close);
 
     const auto edit = menuBar()->addMenu("&Edit");
+    QAction *undo = m_undo->createUndoAction(this, "Undo");
+    undo->setShortcut(QKeySequence::Undo);
+    edit->addAction(undo);
+    QAction *redo = m_undo->createRedoAction(this, "Redo");
+    redo->setShortcut(QKeySequence::Redo);
+    edit->addAction(redo);
+    edit->addSeparator();
     m_actRemove = edit->addAction("Remove Selected", QKeySequence::Delete, this, &MainWindow::removeSelected);
     m_actClear = edit->addAction("Clear All", this, &MainWindow::clearList);
+    edit->addAction("Move to Top", QKeySequence(Qt::CTRL | Qt::Key_Home), this, [this] { moveSelected(true); });
+    edit->addAction("Move to Bottom", QKeySequence(Qt::CTRL | Qt::Key_End), this, [this] { moveSelected(false); });
+    edit->addSeparator();
+    edit->addAction("Play Next", QKeySequence(Qt::CTRL | Qt::SHIFT | Qt::Key_N), this, [this] { queueSelected(true); });
+    edit->addAction("Add to Queue", QKeySequence(Qt::CTRL | Qt::SHIFT | Qt::Key_Q), this, [this] { queueSelected(false); });
+    edit->addSeparator();
+    const auto duplicates = edit->addMenu("Duplicates on Import");
+    auto *dupGroup = new QActionGroup(this);
+    m_dupMode = std::clamp(QSettings().value("import/duplicates", DupKeep).toInt(), 0, 2);
+    const char *dupNames[] = {"Keep", "Mark", "Skip"};
+    for (int mode = DupKeep; mode <= DupSkip; ++mode) {
+        auto *act = duplicates->addAction(dupNames[mode]);
+        act->setCheckable(true);
+        act->setChecked(mode == m_dupMode);
+        dupGroup->addAction(act);
+        connect(act, &QAction::toggled, this, [this, mode](bool on) {
+            if (!on) return;
+            QSettings().setValue("import/duplicates", mode);
+            m_dupMode = mode;
+        });
+    }
+
+    const auto playback = menuBar()->addMenu("&Playback");
+    m_actGapless = playback->addAction("Gapless");
+    m_actGapless->setCheckable(true);
+    m_actGapless->setChecked(m_gapless);
+    connect(m_actGapless, &QAction::toggled, this, &MainWindow::setGapless);
+    m_actPcmEngine = playback->addAction("Direct PCM Engine");
+    m_actPcmEngine->setCheckable(true);
+    m_actPcmEngine->setToolTip("Decode into a lock-free ring buffer and feed the sound card directly");
+    connect(m_actPcmEngine, &QAction::toggled, this, &MainWindow::setPcmEngine);
+    m_actEqualizer = playback->addAction("Equalizer…", this, &MainWindow::showEqualizer);
+    playback->addSeparator();
+
+    auto *shuffle = playback->addAction("Shuffle");
+    shuffle->setCheckable(true);
+    shuffle->setChecked(QSettings().value("playback/shuffle", false).toBool());
+    connect(shuffle, &QAction::toggled, this, [this](bool on) {
+        QSettings().setValue("playback/shuffle", on);
+        m_order.setShuffle(on);
+        preloadNext();
+    });
+    const auto repeat = playback->addMenu("Repeat");
+    auto *repeatGroup = new QActionGroup(this);
+    const int savedRepeat = QSettings().value("playback/repeat", PlayOrder::RepeatAll).toInt();
+    const char *repeatNames[] = {"Off", "All", "One"};
+    for (int mode = PlayOrder::RepeatOff; mode <= PlayOrder::RepeatOne; ++mode) {
+        auto *act = repeat->addAction(repeatNames[mode]);
+        act->setCheckable(true);
+        act->setChecked(mode == savedRepeat);
+        repeatGroup->addAction(act);
+        connect(act, &QAction::toggled, this, [this, mode](bool on) {
+            if (!on) return;
+            QSettings().setValue("playback/repeat", mode);
+            m_order.setRepeat(static_cast<PlayOrder::Repeat>(mode));
+            preloadNext();
+        });
+    }
+    playback->addSeparator();
+
+    const auto crossfade = playback->addMenu("Crossfade");
+    crossfade->setToolTipsVisible(true);
+    auto *cfGroup = new QActionGroup(this);
+    const int savedCf = QSettings().value("playback/crossfadeMs", 0).toInt();
+    for (const int sec: {0, 2, 4, 6, 8, 12}) {
+        auto *act = crossfade->addAction(sec == 0 ? QString("Off") : QString("%1 s").arg(sec));
+        act->setCheckable(true);
+        act->setChecked(sec * 1000 == savedCf);
+        act->setToolTip("Requires the Direct PCM Engine");
+        cfGroup->addAction(act);
+        connect(act, &QAction::toggled, this, [this, sec](bool on) {
+            if (!on) return;
+            m_crossfadeMs = sec * 1000;
+            QSettings().setValue("playback/crossfadeMs", m_crossfadeMs);
+            m_pcm->setCrossfade(m_crossfadeMs, static_cast<FadeCurve>(
+                                    QSettings().value("playback/crossfadeCurve", 1).toInt()));
+            preloadNext();
+        });
+    }
+    crossfade->addSeparator();
+    auto *curveGroup = new QActionGroup(this);
+    const int savedCurve = QSettings().value("playback/crossfadeCurve", 1).toInt();
+    const char *curveNames[] = {"Linear", "Equal Power", "S-Curve"};
+    for (int curve = 0; curve < 3; ++curve) {
+        auto *act = crossfade->addAction(curveNames[curve]);
+        act->setCheckable(true);
+        act->setChecked(curve == savedCurve);
+        curveGroup->addAction(act);
+        connect(act, &QAction::toggled, this, [this, curve](bool on) {
+            if (!on) return;
+            QSettings().setValue("playback/crossfadeCurve", curve);
+            m_pcm->setCrossfade(m_crossfadeMs, static_cast<FadeCurve>(curve));
+        });
+    }
+    crossfade->addSeparator();
+    auto *skipFade = crossfade->addAction("Fade on Skip");
+    skipFade->setCheckable(true);
+    skipFade->setChecked(QSettings().value("playback/skipFade", true).toBool());
+    skipFade->setToolTip("Short fade when changing tracks by hand, to avoid clicks");
+    connect(skipFade, &QAction::toggled, this, [this](bool on) {
+        QSettings().setValue("playback/skipFade", on);
+        m_pcm->setSkipFade(on ? kSkipFadeMs : 0);
+    });
+
+    const auto replayGain = playback->addMenu("ReplayGain");
+    auto *rgGroup = new QActionGroup(this);
+    const char *rgNames[] = {"Off", "Track Gain", "Album Gain"};
+    for (int mode = RgOff; mode <= RgAlbum; ++mode) {
+        m_actReplayGain[mode] = replayGain->addAction(rgNames[mode]);
+        m_actReplayGain[mode]->setCheckable(true);
+        rgGroup->addAction(m_actReplayGain[mode]);
+        connect(m_actReplayGain[mode], &QAction::toggled, this, [this, mode](bool on) {
+            if (on && m_replayGain != mode) setReplayGainMode(mode);
+        });
+    }
+    replayGain->addSeparator();
+    replayGain->addAction("Analyze Playlist Loudness", this, &MainWindow::analyzePlaylistLoudness);
+
+    const auto readAhead = playback->addMenu("Read-Ahead");
+    auto *raGroup = new QActionGroup(this);
+    const int savedMb = QSettings().value("playback/prefetchMB", 256).toInt();
+    for (const int mb: {0, 64, 256, 1024}) {
+        auto *act = readAhead->addAction(mb == 0 ? QString("Off") : QString("%1 MB").arg(mb));
+        act->setCheckable(true);
+        act->setChecked(mb == savedMb);
+        raGroup->addAction(act);
+        connect(act, &QAction::toggled, this, [this, mb](bool on) {
+            if (!on) return;
+            QSettings().setValue("playback/prefetchMB", mb);
+            m_prefetch->setBudget(qint64(mb) << 20);
+            updatePrefetch();
+        });
+    }
+
+    const auto view = menuBar()->addMenu("&View");
+    m_actVisualizer = view->addAction("Visualizer");
+    m_actVisualizer->setCheckable(true);
+    connect(m_actVisualizer, &QAction::toggled, this, [this](bool on) {
+        m_spectrum->setVisible(on);
+        QSettings().setValue("view/visualizer", on);
+    });
+    view->addSeparator();
+    m_actTraceRecord = view->addAction("Record Latency Trace");
+    m_actTraceRecord->setCheckable(true);
+    connect(m_actTraceRecord, &QAction::toggled, this, [this](bool on) {
+        Trace::setEnabled(on);
+        if (!on) m_actTraceOverlay->setChecked(false);
+    });
+    m_actTraceOverlay = view->addAction("Latency Overlay");
+    m_actTraceOverlay->setCheckable(true);
+    connect(m_actTraceOverlay, &QAction::toggled, this, [this](bool on) {
+        if (on) m_actTraceRecord->setChecked(true); // 統計需要記錄
+        m_traceOverlay->setVisible(on);
+        QSettings().setValue("view/latencyOverlay", on);
+    });
+    view->addAction("Export Trace…", this, [this] {
+        const QString file = QFileDialog::getSaveFileName(this, "Export Trace", "musicplayer-trace.json",
+                                                          "Chrome Trace (*.json)");
+        if (file.isEmpty()) return;
+        if (QString error; !Trace::exportChrome(file, &error))
+            QMessageBox::warning(this, "Error", "Failed to write trace: " + error);
+        else statusBar()->showMessage("Trace exported (open in chrome://tracing or Perfetto).", 3000);
+    });
 
     const auto help = menuBar()->addMenu("&Help");
     help->addAction("About", this, [this] {
@@ -210,15 +1126,16 @@ void MainWindow::setupMenu() {
                            "• Enter/Double-click: Play selected\n"
                            "• Ctrl+Right/Left: Next/Prev\n"
                            "• +/-: Volume\n"
-                           "• Drag & drop audio files into the window");
+                           "• Drag & drop audio files or folders into the window");
     });
 }
 
 // 快捷鍵設定
 void MainWindow::setupShortcuts() {
     (void) new QShortcut(QKeySequence(Qt::Key_Space), this, SLOT(playPause()));
-    (void) new QShortcut(QKeySequence(Qt::Key_Return), this, [this] { playSelected(m_list->currentRow()); });
-    (void) new QShortcut(QKeySequence(Qt::Key_Enter), this, [this] { playSelected(m_list->currentRow()); });
+    (void) new QShortcut(QKeySequence(Qt::Key_Return), this, [this] { playSelected(rowAt(m_list->currentIndex())); });
+    (void) new QShortcut(QKeySequence(Qt::Key_Enter), this, [this] { playSelected(rowAt(m_list->currentIndex())); });
+    (void) new QShortcut(QKeySequence::Find, this, [this] { m_filter->setFocus(); m_filter->selectAll(); });
     (void) new QShortcut(QKeySequence(Qt::CTRL | Qt::Key_Right), this, SLOT(next()));
     (void) new QShortcut(QKeySequence(Qt::CTRL | Qt::Key_Left), this, SLOT(previous()));
     (void) new QShortcut(QKeySequence(Qt::Key_Plus), this,
@@ -263,9 +1180,79 @@ void MainWindow::setupShortcuts() {
 // 快進/快退
 void MainWindow::seekByMs(qint64 deltaMs) const {
     if (m_durationMs <= 0) return;
-    const qint64 cur = m_player->position();
+    const qint64 cur = playerPosition();
     const qint64 tgt = std::clamp(cur + deltaMs, 0LL, m_durationMs);
-    m_player->setPosition(tgt);
+    setPlayerPosition(tgt);
+}
+
+// 遠端命令：只轉給既有的動作，與按鍵、選單走同一條路
+QString MainWindow::remoteCommand(const QString &verb, const QString &arg) {
+    using S = QMediaPlayer::PlaybackState;
+    bool ok = true;
+    if (verb == "play") {
+        if (arg.isEmpty()) {
+            if (playerState() != S::PlayingState) playPause();
+            return "OK";
+        }
+        const int row = arg.toInt(&ok);
+        if (!ok || row < 0 || row >= m_model->count()) return "ERR row out of range";
+        playIndex(row);
+        return "OK";
+    }
+    if (verb == "pause") {
+        if (playerState() == S::PlayingState) playPause();
+        return "OK";
+    }
+    if (verb == "toggle") {
+        playPause();
+        return "OK";
+    }
+    if (verb == "stop") {
+        stop();
+        return "OK";
+    }
+    if (verb == "next") {
+        next();
+        return "OK";
+    }
+    if (verb == "prev") {
+        previous();
+        return "OK";
+    }
+    if (verb == "seek") {
+        const qint64 ms = arg.toLongLong(&ok);
+        if (!ok) return "ERR expected milliseconds";
+        if (m_currentIndex < 0) return "ERR nothing playing";
+        const bool relative = arg.startsWith(u'+') || arg.startsWith(u'-');
+        qint64 target = std::max<qint64>(0, relative ? playerPosition() + ms : ms);
+        if (m_durationMs > 0) target = std::min(target, m_durationMs);
+        setPlayerPosition(target);
+        return "OK";
+    }
+    if (verb == "volume") {
+        const int v = arg.toInt(&ok);
+        if (!ok || v < 0 || v > 100) return "ERR expected 0-100";
+        m_volume->setValue(v);
+        return "OK";
+    }
+    if (verb == "enqueue") {
+        if (arg.isEmpty()) return "ERR missing path";
+        importUrls({arg.contains("://") ? QUrl(arg) : QUrl::fromLocalFile(arg)});
+        return "OK";
+    }
+    if (verb == "status") {
+        const S st = playerState();
+        const char *state = st == S::PlayingState ? "playing" : st == S::PausedState ? "paused" : "stopped";
+        return QString("OK %1 %2 %3 %4 %5").arg(state).arg(m_currentIndex)
+                .arg(m_currentIndex < 0 ? 0 : playerPosition()).arg(m_durationMs).arg(m_model->count());
+    }
+    if (verb == "show") {
+        if (isMinimized()) showNormal();
+        raise();
+        activateWindow();
+        return "OK";
+    }
+    return "ERR unknown command: " + verb;
 }
 
 // 開啟檔案
@@ -275,7 +1262,23 @@ void MainWindow::openFiles() {
         "All Files (*)"
     };
     if (const auto urls = QFileDialog::getOpenFileUrls(this, "Open Audio Files", QUrl(), filters.join(";;")); !urls.
-        isEmpty()) enqueue(urls);
+        isEmpty()) importUrls(urls);
+}
+
+// 開啟資料夾（遞迴匯入）
+void MainWindow::openFolder() {
+    if (const QString dir = QFileDialog::getExistingDirectory(this, "Open Folder", mp3BasePath()); !dir.isEmpty())
+        importUrls({QUrl::fromLocalFile(dir)});
+}
+
+// 背景匯入檔案與資料夾
+void MainWindow::importUrls(const QList<QUrl> &urls) {
+    if (!m_importer->isRunning()) ++m_importBatch; // 執行中再加入的算同一次匯入
+    m_importer->start(urls);
+    m_importLabel->setText("Importing…");
+    m_importLabel->show();
+    m_importBar->show();
+    m_importCancel->show();
 }
 
 // 取得 mp3 資料夾路徑
@@ -290,64 +1293,233 @@ QString MainWindow::mp3BasePath() {
 }
 
 // 加入播放清單
-void MainWindow::enqueue(const QList<QUrl> &urls) {
-    int added = 0;
+void MainWindow::enqueue(const QList<QUrl> &urls, bool autoplay) {
+    QList<QUrl> accepted;
+    accepted.reserve(urls.size());
     for (const QUrl &url: urls) {
-        if (!isAudioUrl(url)) continue;
-        m_urls.push_back(url);
+        if (isAudioUrl(url)) accepted.push_back(url);
+    }
+    addTracks(accepted, autoplay);
+}
 
-        QString name = url.fileName();
-        if (!name.isEmpty()) {
-            QFileInfo fi(name);
-            name = fi.completeBaseName();
-        } else {
-            name = url.toString();
+void MainWindow::addTracks(const QList<QUrl> &accepted, bool autoplay, quint64 batch) {
+    const int added = static_cast<int>(accepted.size());
+    if (added > 0) m_undo->push(new AddRowsCommand(m_model, accepted, batch)); // 單次插入整批
+
+    QStringList paths;
+    paths.reserve(accepted.size());
+    for (const QUrl &url: accepted) {
+        if (url.isLocalFile()) paths.push_back(url.toLocalFile());
+    }
+    m_meta->scan(paths); // 背景擷取標籤（已索引且未變更的只 stat）
+    if (m_dupMode != DupKeep && !paths.isEmpty()) {
+        if (!m_dupSeeded) {
+            // 第一次比對：清單中原有的曲目只當基準（只 stat，雜湊有需要時才算）
+            QStringList existing;
+            const int before = m_model->count() - added;
+            existing.reserve(before);
+            for (int row = 0; row < before; ++row) {
+                if (const QString path = m_model->localFile(row); !path.isEmpty()) existing.push_back(path);
+            }
+            m_dupes->add(existing, false);
+            m_dupSeeded = true;
         }
-        m_list->addItem(name);
-        ++added;
+        m_dupes->add(paths);
     }
-    if (added > 0 && m_currentIndex < 0) playIndex(0);
+    if (m_replayGain != RgOff) m_loudness->analyze(paths); // 響度分析（低優先權）
+    scheduleTotalDuration();
+    if (added > 0 && m_currentIndex < 0 && autoplay) playIndex(0);
+    else if (added > 0) preloadNext();
     statusBar()->showMessage(QString("Added %1 item(s)").arg(added), 3000);
 }
 
+// 套用過濾（逐字輸入）
+void MainWindow::applyFilter() {
+    const QString text = m_filter->text().trimmed();
+    if (text.isEmpty()) {
+        m_filterModel->clearFilter();
+    } else {
+        m_filterModel->setRows(m_search->query(text));
+        statusBar()->showMessage(QString("%1 match(es)").arg(m_filterModel->rowCount()), 2000);
+    }
+    m_order.setFilter(m_filterModel->isFiltered() ? &m_filterModel->sourceRows() : nullptr);
+    if (m_currentIndex >= 0)
+        m_list->setCurrentIndex(m_filterModel->mapFromSource(m_model->index(m_currentIndex)));
+    preloadNext();
+}
+
+// 下一列（過濾中只在符合的列之間移動，單曲重複時為目前這一列）
+int MainWindow::nextRow() const {
+    return m_order.peekNext(false);
+}
+
+// 檢視索引 → 播放清單列號
+int MainWindow::rowAt(const QModelIndex &viewIndex) const {
+    return m_filterModel->mapToSource(viewIndex).row();
+}
+
+// 重新計算清單總長度
+void MainWindow::scheduleTotalDuration() {
+    m_totalTimer->start();
+}
+
 // 清空播放清單
 void MainWindow::clearList() {
-    m_player->stop();
-    m_urls.clear();
-    m_list->clear();
+    stop();
+    clearPreload();
+    if (!m_model->isEmpty()) {
+        QVector<int> rows(m_model->count());
+        std::iota(rows.begin(), rows.end(), 0);
+        m_list->selectionModel()->clear();
+        auto *cmd = new RemoveRowsCommand(m_model, rows);
+        cmd->setText("Clear Playlist");
+        m_undo->push(cmd);
+    }
+    m_search->clear();
+    m_loudness->cancel();
+    m_dupes->reset(); // 整份清單都移除了：基準清空，不必逐一移除
+    m_dupSeeded = false;
+    m_resumeMs = -1;
+    scheduleTotalDuration();
     m_currentIndex = -1;
     m_durationMs = 0;
     m_seek->setValue(0);
+    m_seek->setPeaks(std::nullopt);
     updateTimeLabels(0, 0);
+    updatePrefetch();
 }
 
 // 移除選取項目
 void MainWindow::removeSelected() {
-    auto rows = m_list->selectionModel()->selectedRows();
+    const QVector<int> rows = selectedRows();
     if (rows.isEmpty()) return;
+    m_list->selectionModel()->clear(); // 選取的列都會消失，不必逐一搬移選取範圍
+    removeRows(rows);
+}
+
+// 移除多列：一次壓縮，O(n)（略過重複檔案也走這裡，保留比對基準）
+void MainWindow::removeRows(const QVector<int> &rows, bool missing) {
+    if (rows.isEmpty()) return;
+    const bool wasPlaying = m_currentIndex >= 0;
+    m_undo->push(new RemoveRowsCommand(m_model, rows, missing));
+    if (wasPlaying && m_currentIndex < 0 && !m_model->isEmpty()) playIndex(0);
+    else preloadNext();
+}
 
-    std::ranges::sort(rows, [](const QModelIndex &a, const QModelIndex &b) { return a.row() > b.row(); });
-    for (const auto &idx: rows) {
-        if (const int r = idx.row(); r >= 0 && r < m_urls.size()) {
-            m_urls.remove(r);
-            delete m_list->takeItem(r);
-            if (r == m_currentIndex) {
-                stop();
-                m_currentIndex = -1;
-            } else if (r < m_currentIndex) m_currentIndex--;
+// 整塊移到 dest 之前，目前曲目與選取跟著移動
+void MainWindow::moveRows(const QVector<int> &rows, int dest) {
+    if (rows.isEmpty()) return;
+    m_undo->push(new MoveRowsCommand(m_model, rows, std::clamp(dest, 0, m_model->count())));
+    preloadNext();
+}
+
+void MainWindow::moveSelected(bool top) {
+    moveRows(selectedRows(), top ? 0 : m_model->count());
+    if (const QModelIndexList sel = m_list->selectionModel()->selectedRows(); !sel.isEmpty())
+        m_list->scrollTo(top ? sel.front() : sel.back());
+}
+
+QVector<int> MainWindow::selectedRows() const {
+    QVector<int> rows;
+    for (const auto &idx: m_list->selectionModel()->selectedRows()) {
+        if (const int r = rowAt(idx); r >= 0 && r < m_model->count()) rows.push_back(r);
+    }
+    std::ranges::sort(rows);
+    return rows;
+}
+
+QVector<int> MainWindow::rowsOf(const QString &path) const {
+    QVector<int> rows = m_search->rowsOf(path);
+    rows.removeIf([this, &path](int row) { return row >= m_model->count() || m_model->localFile(row) != path; });
+    return rows;
+}
+
+void MainWindow::whenIndexed(std::function<void()> fn) {
+    if (m_search->isComplete(m_model->count())) {
+        fn();
+        return;
+    }
+    m_afterIndex.push_back(std::move(fn));
+    // 只是批次還在背景建立時等 ready 即可；列數對不上（還原後）要整個重建
+    if (m_search->size() != m_model->count() && !m_reindexTimer->isActive()) m_reindexTimer->start();
+}
+
+// 重複檔案：依設定標記或從清單移除
+void MainWindow::onDuplicatesFound(const QStringList &paths, const QStringList &originals) {
+    if (m_dupMode == DupMark) {
+        m_model->markDuplicates(paths, originals);
+        statusBar()->showMessage(QString("Marked %1 duplicate(s)").arg(paths.size()), 3000);
+    } else if (m_dupMode == DupSkip) {
+        // 新加入的批次可能還沒併入索引
+        whenIndexed([this, paths] {
+            QVector<int> rows;
+            for (const QString &path: paths) rows += rowsOf(path);
+            std::ranges::sort(rows);
+            rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+            removeRows(rows);
+            statusBar()->showMessage(QString("Skipped %1 duplicate(s)").arg(rows.size()), 3000);
+        });
+    }
+}
+
+// 改名就地更新，刪除的移出清單，新增的加到最後（不自動播放）
+void MainWindow::onLibraryChanged(const QStringList &added, const QStringList &removed,
+                                  const LibraryWatcher::Renames &renamed) {
+    // 以路徑對應找列，不走訪整份清單；索引還沒涵蓋整份清單時等它建好
+    if (!m_search->isComplete(m_model->count())) {
+        whenIndexed([this, added, removed, renamed] { onLibraryChanged(added, removed, renamed); });
+        return;
+    }
+
+    QStringList movedFrom;
+    QStringList moved;
+    for (const auto &[from, to]: renamed) {
+        for (const int row: rowsOf(from)) {
+            m_model->setUrl(row, QUrl::fromLocalFile(to));
+            m_search->renameRow(row, from, to);
+            movedFrom.push_back(from);
+            moved.push_back(to);
         }
     }
-    if (m_currentIndex < 0 && !m_urls.isEmpty()) playIndex(0);
+    if (!moved.isEmpty()) {
+        m_sessionDirty = true;
+        m_meta->scan(moved);
+        m_reindexTimer->start(); // 搜尋鍵含檔名
+        if (m_dupSeeded) {
+            m_dupes->remove(movedFrom);
+            m_dupes->add(moved, false);
+        }
+    }
+
+    QVector<int> rows;
+    for (const QString &path: removed) rows += rowsOf(path);
+    std::ranges::sort(rows);
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    removeRows(rows, true);
+
+    const QSet<QString> present(moved.cbegin(), moved.cend());
+    QList<QUrl> fresh;
+    for (const QString &path: added) {
+        if (!present.contains(path) && rowsOf(path).isEmpty()) fresh.push_back(QUrl::fromLocalFile(path));
+    }
+    if (!fresh.isEmpty()) enqueue(fresh, false);
+    else if (!moved.isEmpty()) preloadNext();
+    statusBar()->showMessage(QString("Library: %1 added, %2 removed, %3 renamed")
+                             .arg(fresh.size()).arg(rows.size()).arg(moved.size()), 3000);
+}
+
+void MainWindow::setLibraryRoots(const QStringList &roots) {
+    QSettings().setValue("library/roots", roots);
+    m_library->setRoots(roots);
 }
 
 // 儲存播放清單
 void MainWindow::saveM3U() {
-    if (m_urls.isEmpty()) {
+    if (m_model->isEmpty()) {
         QMessageBox::information(this, "Save M3U", "Playlist is empty.");
         return;
     }
 
-    const QString binPath = QCoreApplication::applicationDirPath();
     const QString basePath = mp3BasePath();
     const QString file = QFileDialog::getSaveFileName(
         this, "Save M3U Playlist",
@@ -355,139 +1527,160 @@ void MainWindow::saveM3U() {
         "Playlists (*.m3u *.m3u8)");
     if (file.isEmpty()) return;
 
-    QFile f(file);
-    if (!f.open(QIODevice::WriteOnly | QIODevice::Text)) {
+    if (!writePlaylist(file)) {
         QMessageBox::warning(this, "Error", "Failed to write playlist.");
         return;
     }
 
-    QTextStream out(&f);
-    out << "#EXTM3U\n";
+    statusBar()->showMessage("Playlist saved (relative to /bin).", 3000);
+}
 
-    for (const QUrl &u: m_urls) {
-        QString absPath = u.toLocalFile();
-        QString relPath = QDir(binPath).relativeFilePath(absPath);
-        out << relPath << "\n";
+// 已知的標題與長度寫成 #EXTINF
+bool MainWindow::writePlaylist(const QString &file) const {
+    QVector<PlaylistEntry> entries;
+    entries.reserve(m_model->count());
+    const TrackStore &tracks = m_model->tracks();
+    for (int row = 0; row < tracks.count(); ++row) {
+        PlaylistEntry e{tracks.url(row), {}, -1};
+        if (const auto info = m_meta->find(tracks.localFile(row))) {
+            e.title = info->artist.isEmpty() ? info->title : info->artist + " – " + info->title;
+            if (info->durationMs > 0) e.durationMs = info->durationMs;
+        }
+        entries.push_back(std::move(e));
     }
-
-    statusBar()->showMessage("Playlist saved (relative to /bin).", 3000);
+    return M3UPlaylist::save(file, entries, QCoreApplication::applicationDirPath());
 }
 
 // 載入播放清單
 void MainWindow::loadM3U() {
-    const QString basePath = mp3BasePath();
-    const QString binPath = QCoreApplication::applicationDirPath();
-
     const auto file = QFileDialog::getOpenFileName(
-        this, "Load M3U Playlist", basePath,
+        this, "Load M3U Playlist", mp3BasePath(),
         "Playlists (*.m3u *.m3u8);;All Files (*)");
     if (file.isEmpty()) return;
 
-    QFile f(file);
-    if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    if (!readPlaylist(file)) {
         QMessageBox::warning(this, "Error", "Failed to open playlist.");
         return;
     }
+    statusBar()->showMessage("Playlist loaded (relative paths supported).", 3000);
+}
 
-    QList<QUrl> urls;
-    QTextStream in(&f);
-    const QString playlistDir = QFileInfo(file).absolutePath();
-
-    while (!in.atEnd()) {
-        QString line = in.readLine().trimmed();
-        if (line.isEmpty() || line.startsWith("#"))
-            continue;
-
-        QString fullPath;
-        QFileInfo fi(line);
+bool MainWindow::readPlaylist(const QString &file) {
+    // 相對路徑依序在清單所在資料夾、/bin、mp3 資料夾中尋找
+    QString error;
+    const QVector<PlaylistEntry> entries = M3UPlaylist::load(
+        file, {QCoreApplication::applicationDirPath(), mp3BasePath()}, &error);
+    if (!error.isEmpty()) return false;
 
-        if (fi.isAbsolute()) {
-            fullPath = line;
-        } else {
-            fullPath = QDir(playlistDir).absoluteFilePath(line);
-            if (!QFile::exists(fullPath))
-                fullPath = QDir(binPath).absoluteFilePath(line);
-            if (!QFile::exists(fullPath))
-                fullPath = QDir(basePath).absoluteFilePath(line);
+    QList<QUrl> urls;
+    urls.reserve(entries.size());
+    for (const PlaylistEntry &e: entries) {
+        urls.push_back(e.url);
+        if (e.url.isLocalFile() && (!e.title.isEmpty() || e.durationMs > 0)) {
+            TrackInfo info;
+            info.title = e.title;
+            info.durationMs = std::max<qint64>(0, e.durationMs);
+            m_meta->hint(e.url.toLocalFile(), info); // 不必探測媒體即可顯示
         }
-
-        if (QFile::exists(fullPath))
-            urls.push_back(QUrl::fromLocalFile(fullPath));
     }
 
     enqueue(urls);
-    statusBar()->showMessage("Playlist loaded (relative paths supported).", 3000);
+    return true;
 }
 
 // 播放選取項目
 void MainWindow::playSelected(int row) {
-    if (row < 0 || row >= m_urls.size()) return;
+    if (row < 0 || row >= m_model->count()) return;
     playIndex(row);
 }
 
 // 播放 | 暫停
 void MainWindow::playPause() {
     using S = QMediaPlayer::PlaybackState;
-    if (m_player->playbackState() == S::PlayingState) {
-        m_player->pause();
-    } else if (m_player->playbackState() == S::PausedState) {
-        m_player->play();
+    if (playerState() == S::PlayingState) {
+        if (m_usePcm) m_pcm->pause();
+        else m_player->pause();
+    } else if (playerState() == S::PausedState) {
+        if (m_usePcm) m_pcm->play();
+        else m_player->play();
     } else {
-        if (m_currentIndex < 0 && !m_urls.isEmpty()) playIndex(0);
+        if (m_currentIndex < 0 && !m_model->isEmpty()) playIndex(0);
+        else if (m_resumeMs >= 0) playIndex(m_currentIndex, m_resumeMs); // 還原的工作階段
+        else if (m_usePcm) m_pcm->play();
         else m_player->play();
     }
 }
 
 // 停
 void MainWindow::stop() const {
+    Trace::cancel(Trace::TrackSwitch);
+    Trace::cancel(Trace::Seek);
     m_player->stop();
+    m_pcm->stop();
     m_btnPlayPause->setIcon(QIcon(":/icons/play.svg"));
 }
 
 // 下一個
 void MainWindow::next() {
-    if (m_urls.isEmpty()) return;
-    const qsizetype nextIdx = (m_currentIndex + 1) % m_urls.size();
-    playIndex(static_cast<int>(nextIdx));
+    if (const int row = m_order.next(true); row >= 0) playIndex(row);
 }
 
 // 上一個
 void MainWindow::previous() {
-    if (m_urls.isEmpty()) return;
-    const qsizetype prevIdx = (m_currentIndex - 1 + m_urls.size()) % m_urls.size();
-    playIndex(static_cast<int>(prevIdx));
+    if (const int row = m_order.previous(); row >= 0) playIndex(row);
+}
+
+// 依清單順序加入佇列
+void MainWindow::queueSelected(bool front) {
+    const QVector<int> rows = selectedRows();
+    if (rows.isEmpty()) return;
+    m_order.enqueue(rows, front);
+    preloadNext();
+    statusBar()->showMessage(QString("Queued %1 track(s) · %2 up next").arg(rows.size()).arg(m_order.queued()), 3000);
 }
 
 // 播放位置變更
 void MainWindow::onPositionChanged(qint64 pos) {
-    if (m_durationMs > 0) {
-        const int v = static_cast<int>((pos * 1000) / m_durationMs);
-        if (!m_seek->isSliderDown()) {
-            m_syncingFromPlayer = true;
-            m_seek->setValue(std::clamp(v, 0, 1000));
-            m_syncingFromPlayer = false;
-        }
+    if (m_durationMs > 0 && !m_seek->isSliderDown()) {
+        m_syncingFromPlayer = true;
+        m_seek->setValue(static_cast<int>(std::clamp(pos, 0LL, m_durationMs)));
+        m_syncingFromPlayer = false;
     }
     updateTimeLabels(pos, m_durationMs);
 
-    if (m_durationMs > 0 && pos >= m_durationMs - 10) {
-        if (m_player->playbackState() == QMediaPlayer::PlayingState) next();
+    // 位置前進代表已經聽得到
+    if (pos > 0) Trace::end(Trace::TrackSwitch);
+    if (pos > m_seekTraceMs && Trace::isOpen(Trace::Seek)) Trace::end(Trace::Seek);
+
+    if (m_transitionTimer.isValid() && pos > 0) {
+        m_lastTransitionMs = m_transitionTimer.elapsed();
+        m_transitionTimer.invalidate();
+        statusBar()->showMessage(QString("Track transition: %1 ms%2")
+                                 .arg(m_lastTransitionMs)
+                                 .arg(m_gapless ? " (gapless)" : ""), 3000);
     }
 }
 
 // 總長度變更
 void MainWindow::onDurationChanged(const qint64 dur) {
     m_durationMs = dur;
-    updateTimeLabels(m_player->position(), dur);
+    // 一格一毫秒：解析度不隨曲長變粗；方向鍵與 PageUp/PageDown 仍是全長的 0.1% 與 1%
+    const int range = static_cast<int>(std::clamp<qint64>(dur, 0, std::numeric_limits<int>::max()));
+    m_syncingFromPlayer = true; // 縮小範圍會改到值，不是使用者的跳轉
+    m_seek->setRange(0, range);
+    m_seek->setSingleStep(std::max(1, range / 1000));
+    m_seek->setPageStep(std::max(1, range / 100));
+    m_syncingFromPlayer = false;
+    updateTimeLabels(playerPosition(), dur);
 }
 
 // 播放狀態變更
 void MainWindow::onStateChanged() const {
     using S = QMediaPlayer::PlaybackState;
-    if (m_player->playbackState() == S::PlayingState) {
+    if (playerState() == S::PlayingState) {
         m_btnPlayPause->setIcon(QIcon(":/icons/pause.svg"));
         statusBar()->showMessage("Playing");
-    } else if (m_player->playbackState() == S::PausedState) {
+    } else if (playerState() == S::PausedState) {
         m_btnPlayPause->setIcon(QIcon(":/icons/play.svg"));
         statusBar()->showMessage("Paused");
     } else {
@@ -498,6 +1691,10 @@ void MainWindow::onStateChanged() const {
 
 // 錯誤處理
 void MainWindow::onErrorChanged() {
+    if (m_usePcm) {
+        if (!m_pcm->errorString().isEmpty()) QMessageBox::warning(this, "Playback Error", m_pcm->errorString());
+        return;
+    }
     if (const auto err = m_player->error(); err != QMediaPlayer::NoError)
         QMessageBox::warning(
             this, "Playback Error", m_player->errorString());
@@ -505,7 +1702,7 @@ void MainWindow::onErrorChanged() {
 
 // 音量變更
 void MainWindow::onVolumeChanged(int) const {
-    int v = static_cast<int>(std::lround(m_audio->volume() * 100.0));
+    int v = static_cast<int>(std::lround(m_audio->volume() / m_qtGain * 100.0));
     v = std::clamp(v, 0, 100);
     if (m_volume->value() != v)
         m_volume->setValue(v);
@@ -519,40 +1716,65 @@ void MainWindow::onVolumeChanged(int) const {
 void MainWindow::onSeek(int v) const {
     if (m_durationMs <= 0) return;
     if (m_syncingFromPlayer) return;
-    const qint64 target = (m_durationMs * v) / 1000;
-    m_player->setPosition(target);
+    setPlayerPosition(std::min<qint64>(v, m_durationMs));
 }
 
 // 靜音切換
 void MainWindow::toggleMute() const {
     m_audio->setMuted(!m_audio->isMuted());
+    m_pcm->setMuted(m_audio->isMuted());
     onVolumeChanged(0);
 }
 
-// 播放指定索引
-void MainWindow::playIndex(int idx) {
-    if (idx < 0 || idx >= m_urls.size()) return;
+QString MainWindow::unplayableReason(int row) const {
+    if (QString reason = m_model->unplayableReason(row); !reason.isEmpty()) return reason;
+    const QString path = m_model->localFile(row);
+    if (path.isEmpty() || QFileInfo::exists(path)) return {};
+    m_model->markUnplayable({path}, {"File not found"});
+    return "File not found";
+}
 
-    for (int i = 0; i < m_list->count(); ++i) {
-        QFont f = m_list->item(i)->font();
-        f.setBold(false);
-        m_list->item(i)->setFont(f);
+// 播放指定索引
+void MainWindow::playIndex(int idx, qint64 startMs) {
+    if (idx < 0 || idx >= m_model->count()) return;
+    // 匯入時判定無法播放的不送進解碼器，依播放順序往下找（不跳出錯誤對話框）
+    int skipped = 0;
+    while (!unplayableReason(idx).isEmpty()) {
+        m_order.setCurrent(idx);
+        const int next = ++skipped < m_model->count() ? m_order.next(false) : -1;
+        if (next < 0 || next == idx) {
+            stop();
+            statusBar()->showMessage(QString("Cannot play %1: %2").arg(m_model->localFile(idx),
+                                                                        unplayableReason(idx)), 5000);
+            return;
+        }
+        idx = next;
     }
+    if (skipped > 0) statusBar()->showMessage(QString("Skipped %1 unplayable file(s)").arg(skipped), 3000);
+    m_resumeMs = -1;
+    m_pendingSeekMs = startMs;
+    Trace::cancel(Trace::Seek);
+    Trace::begin(Trace::TrackSwitch); // 到位置開始前進為止
 
     m_currentIndex = idx;
-    m_list->setCurrentRow(idx);
-
-    if (auto *item = m_list->item(idx)) {
-        QFont f = item->font();
-        f.setBold(true);
-        item->setFont(f);
-    }
+    m_order.setCurrent(idx); // 由 next()/previous() 而來時已經是目前曲目
+    m_model->setNowPlaying(idx); // 只重繪新舊兩列
+    m_list->setCurrentIndex(m_filterModel->mapFromSource(m_model->index(idx)));
 
     m_durationMs = 0;
     updateTimeLabels(0, 0);
 
-    m_player->setSource(m_urls[idx]);
-    m_player->play();
+    if (m_usePcm) {
+        m_prefetch->acquire(m_model->url(idx)); // 解碼器自己開檔，但讀取已在系統快取中
+        m_pcm->setSource(m_model->url(idx));
+        m_pcm->play();
+    } else if (!takePreloaded(idx)) {
+        setPlayerSource(m_model->url(idx));
+        m_player->play();
+    }
+    applyReplayGain();
+    updateWaveform();
+    preloadNext();
     setWindowTitle(QString("MusicPlayer"));
 }
 
@@ -581,10 +1803,7 @@ QString MainWindow::formatTime(qint64 ms) {
 
 // 判斷是否為音訊檔案
 bool MainWindow::isAudioUrl(const QUrl &url) {
-    const QString f = url.fileName().toLower();
-    return f.endsWith(".mp3") || f.endsWith(".wav") || f.endsWith(".flac") ||
-           f.endsWith(".m4a") || f.endsWith(".aac") || f.endsWith(".ogg") ||
-           f.endsWith(".opus");
+    return LibraryImporter::isAudioPath(url.fileName());
 }
 
 // 事件
@@ -594,5 +1813,5 @@ void MainWindow::dragEnterEvent(QDragEnterEvent *event) {
 
 // 事件
 void MainWindow::dropEvent(QDropEvent *event) {
-    if (const QList<QUrl> urls = event->mimeData()->urls(); !urls.isEmpty()) enqueue(urls);
+    if (const QList<QUrl> urls = event->mimeData()->urls(); !urls.isEmpty()) importUrls(urls);
 }
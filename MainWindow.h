@@ -1,13 +1,30 @@
 #pragma once
 #include <QLabel>
-#include <QListWidget>
+#include <QListView>
 #include <QtMultimedia/QMediaPlayer>
 #include <QMainWindow>
 #include <QMouseEvent>
 #include <QPushButton>
 #include <QSlider>
 #include <QVector>
+#include <QElapsedTimer>
 #include <QUrl>
+#include <QPixmap>
+#include <QThreadPool>
+#include <functional>
+#include "PlaylistModel.h"
+#include "LibraryImporter.h"
+#include "MetadataIndex.h"
+#include "M3UPlaylist.h"
+#include "SearchIndex.h"
+#include "PcmPlayer.h"
+#include "PlayOrder.h"
+#include "EqualizerDialog.h"
+#include "LoudnessAnalyzer.h"
+#include "DuplicateFinder.h"
+#include "LibraryWatcher.h"
+#include "WaveformCache.h"
+#include "SpectrumView.h"
 
 // 進度條
 class SeekSlider final : public QSlider {
@@ -16,6 +33,9 @@ class SeekSlider final : public QSlider {
 public:
     using QSlider::QSlider;
 
+    // 波形概觀；沒有資料時顯示一般的滑桿
+    void setPeaks(const std::optional<WaveformPeaks> &peaks);
+
 protected:
     // 點擊位置直接跳到該位置
     void mousePressEvent(QMouseEvent *e) override {
@@ -34,6 +54,19 @@ protected:
         QSlider::mousePressEvent(e);
     }
 
+    void paintEvent(QPaintEvent *e) override;
+
+    void resizeEvent(QResizeEvent *e) override;
+
+private:
+    static constexpr double kHandleHalf = 4.0;
+
+    // 依寬度選擇金字塔層級，預先畫好已播放/未播放兩種顏色
+    void renderWaveform();
+
+    std::optional<WaveformPeaks> m_peaks;
+    QPixmap m_wavePlayed;
+    QPixmap m_waveRest;
 };
 
 // 音量條
@@ -61,17 +94,48 @@ protected:
     }
 };
 
+// 播放清單檢視：拖曳選取的列重新排序（只接受自己的拖曳，外部檔案交給主視窗）
+class PlaylistView final : public QListView {
+    Q_OBJECT
+
+public:
+    using QListView::QListView;
+
+signals:
+    // 選取的列拖到檢視第 row 列之前（row = 列數時為最後）
+    void moveRequested(int row);
+
+protected:
+    void dragEnterEvent(QDragEnterEvent *e) override;
+
+    void dragMoveEvent(QDragMoveEvent *e) override;
+
+    void dropEvent(QDropEvent *e) override;
+
+private:
+    int dropRow(const QPoint &pos) const;
+};
 
 class QMediaDevices;
+class QProgressBar;
+class QLineEdit;
+class QAudioBufferOutput;
+class TraceOverlay;
+class Prefetcher;
+class QUndoStack;
 
 class MainWindow final : public QMainWindow {
     Q_OBJECT
+    friend class MusicPlayerBench; // bench/MusicPlayerBench.cpp 直接量測內部流程
 
 public:
     explicit MainWindow(QWidget *parent = nullptr);
 
     ~MainWindow() override;
 
+    // 單一執行個體的遠端命令（協定見 InstanceChannel.h），回傳回覆行
+    QString remoteCommand(const QString &verb, const QString &arg);
+
 protected:
     // 事件
     void dragEnterEvent(QDragEnterEvent *event) override;
@@ -82,6 +146,8 @@ private slots:
     // 動作
     void openFiles();
 
+    void openFolder();
+
     void clearList();
 
     void removeSelected();
@@ -116,6 +182,26 @@ private slots:
 
     void onMediaStatusChanged(QMediaPlayer::MediaStatus status);
 
+    void setGapless(bool on);
+
+    void applyFilter();
+
+    void setPcmEngine(bool on);
+
+    void showEqualizer();
+
+    void onTrackAdvanced(const QUrl &url);
+
+    void setReplayGainMode(int mode);
+
+    void analyzePlaylistLoudness();
+
+    // 加入「接下來播放」：front 為 true 時排在最前面
+    void queueSelected(bool front);
+
+    // 選取的列移到最前面/最後面
+    void moveSelected(bool top);
+
 private:
     void setupUi();
 
@@ -123,11 +209,55 @@ private:
 
     void setupShortcuts();
 
-    void enqueue(const QList<QUrl> &urls);
+    // autoplay：清單原本沒有播放中的曲目時從第一首開始
+    void enqueue(const QList<QUrl> &urls, bool autoplay = true);
+
+    // 已過濾的檔案直接加入（匯入器依檔頭判斷過）
+    // batch 不為 0 時，同一次匯入的批次在復原堆疊中合併成一步
+    void addTracks(const QList<QUrl> &accepted, bool autoplay = true, quint64 batch = 0);
+
+    // rows 為升冪的播放清單列號；經過復原堆疊（missing：音樂庫中消失的檔案，連續的合併成一步）
+    void removeRows(const QVector<int> &rows, bool missing = false);
+
+    void moveRows(const QVector<int> &rows, int dest);
+
+    // 選取的播放清單列號（升冪）
+    QVector<int> selectedRows() const;
+
+    // 本機路徑為 path 的列（升冪），以搜尋索引的路徑對應查，不走訪整份清單
+    QVector<int> rowsOf(const QString &path) const;
+
+    // 搜尋索引涵蓋整份清單時才執行（rowsOf 才完整）；否則等索引建好
+    void whenIndexed(std::function<void()> fn);
+
+    void onDuplicatesFound(const QStringList &paths, const QStringList &originals);
+
+    // 監看的音樂庫資料夾有變更
+    void onLibraryChanged(const QStringList &added, const QStringList &removed, const LibraryWatcher::Renames &renamed);
+
+    void setLibraryRoots(const QStringList &roots);
+
+    void importUrls(const QList<QUrl> &urls);
+
+    void scheduleTotalDuration();
+
+    // 自動換曲時的下一列（預載用，不改變順序）
+    int nextRow() const;
+
+    int rowAt(const QModelIndex &viewIndex) const;
 
     static QString mp3BasePath();
 
-    void playIndex(int idx);
+    // 不經過對話框的 M3U 讀寫（loadM3U/saveM3U 與效能測試共用）
+    bool readPlaylist(const QString &file);
+
+    bool writePlaylist(const QString &file) const;
+
+    // startMs > 0：載入後從該位置開始（還原工作階段）
+    void playIndex(int idx, qint64 startMs = 0);
+
+    // 無法播放的原因；載入清單時不逐檔檢查，輪到預載/播放才確認本機檔案還在
+    QString unplayableReason(int row) const;
 
     void updateTimeLabels(qint64 pos, qint64 dur) const;
 
@@ -137,13 +267,62 @@ private:
 
     void seekByMs(qint64 deltaMs) const;
 
+    // 無縫播放
+    void attachPlayer();
+
+    void detachPlayer();
+
+    void preloadNext();
+
+    void clearPreload();
+
+    // 預讀
+    void setPlayerSource(const QUrl &url) const;
+
+    void updatePrefetch();
+
+    bool takePreloaded(int idx);
+
+    // 目前使用的播放引擎
+    qint64 playerPosition() const;
+
+    QMediaPlayer::PlaybackState playerState() const;
+
+    void setPlayerPosition(qint64 ms) const;
+
+    void updateEngineStats() const;
+
+    // 響度正規化
+    std::optional<LoudnessInfo> albumLoudness(int idx) const;
+
+    void applyReplayGain();
+
+    void updateWaveform();
+
+    void updateOutputVolume() const;
+
+    // 工作階段快照
+    void restoreSession();
+
+    void saveSession(bool wait);
+
     // 多媒體物件
     QMediaPlayer *m_player;
     QAudioOutput *m_audio;
     QMediaDevices *m_devices = nullptr;
+    QMediaPlayer *m_nextPlayer{}; // 預載下一首
+    QAudioOutput *m_nextAudio{};
+    PcmPlayer *m_pcm{}; // 自行解碼輸出的引擎
+    bool m_usePcm = false;
 
     // UI 控制
-    QListWidget *m_list{};
+    PlaylistView *m_list{};
+    PlaylistModel *m_model{};
+    PlaylistFilterModel *m_filterModel{};
+    QLineEdit *m_filter{};
+    SearchIndex *m_search{};
+    QTimer *m_filterTimer{};
+    QTimer *m_reindexTimer{};
     QPushButton *m_btnPrev{};
     QPushButton *m_btnPlayPause{};
     QPushButton *m_btnStop{};
@@ -154,16 +333,90 @@ private:
     QSlider *m_volume{};
     QPushButton *m_btnMute{};
 
+    // 匯入進度
+    LibraryImporter *m_importer{};
+    QLabel *m_importLabel{};
+    QProgressBar *m_importBar{};
+    QPushButton *m_importCancel{};
+
+    // 曲目資訊索引
+    MetadataIndex *m_meta{};
+    QLabel *m_lblTotal{};
+    QTimer *m_totalTimer{};
+
+    // 引擎狀態（緩衝深度、underrun）
+    QLabel *m_lblEngine{};
+    QTimer *m_engineTimer{};
+    EqualizerDialog *m_eqDialog{};
+
+    // 進度條上的波形
+    WaveformCache *m_waveforms{};
+
+    // 頻譜視覺化（PCM 引擎走 AudioTap，Qt 引擎走 QAudioBufferOutput）
+    SpectrumView *m_spectrum{};
+    QAudioBufferOutput *m_bufferOutput{};
+
+    // 預讀
+    Prefetcher *m_prefetch{};
+    QLabel *m_lblPrefetch{};
+    int m_prefetchDepth = 3;
+
+    // 延遲追蹤
+    TraceOverlay *m_traceOverlay{};
+    mutable qint64 m_seekTraceMs = 0; // 位置超過這裡才算恢復播放
+
+    // 響度分析與 ReplayGain
+    enum ReplayGainMode { RgOff, RgTrack, RgAlbum };
+    LoudnessAnalyzer *m_loudness{};
+    QLabel *m_lblLoudness{};
+    int m_replayGain = RgOff;
+    float m_qtGain = 1.0f; // QAudioOutput 只能衰減，增益上限 1
+
+    // 匯入時的重複檔案偵測
+    enum DuplicateMode { DupKeep, DupMark, DupSkip };
+    DuplicateFinder *m_dupes{};
+    int m_dupMode = DupKeep;
+    bool m_dupSeeded = false; // 清單中原有的曲目已交給 m_dupes 當比對基準
+    QVector<std::function<void()>> m_afterIndex; // 等搜尋索引建好才處理的事件
+
+    // 監看的音樂庫資料夾
+    LibraryWatcher *m_library{};
+
     // 播放清單
-    QVector<QUrl> m_urls;
+    QUndoStack *m_undo{}; // 所有改變列結構的編輯（加入、移除、移動）
+    quint64 m_importBatch = 0; // 每次匯入（匯入器從閒置開始）遞增
+    mutable PlayOrder m_order; // 預覽下一首時隨機順序會先抽好
     int m_currentIndex = -1;
     qint64 m_durationMs = 0;
     bool m_syncingFromPlayer = false;
 
+    // 工作階段
+    QThreadPool m_sessionPool; // 單一執行緒，寫入依序進行
+    QTimer *m_sessionTimer{};
+    bool m_sessionDirty = true; // 清單變更過，下次要寫整份快照
+    qint64 m_resumeMs = -1; // 還原後尚未開始播放：按下播放時從這裡繼續
+    qint64 m_pendingSeekMs = 0; // 載入完成後再跳轉
+
+    // 無縫播放狀態
+    bool m_gapless = true;
+    int m_crossfadeMs = 0; // 只在 PCM 引擎生效
+    static constexpr int kSkipFadeMs = 30; // 手動換曲的淡出/淡入
+    QUrl m_preloadUrl;
+    QElapsedTimer m_transitionTimer; // EndOfMedia → 下一首第一個位置更新
+    qint64 m_lastTransitionMs = -1;
+
     // 動作
     QAction *m_actOpen{};
+    QAction *m_actOpenFolder{};
     QAction *m_actLoadM3U{};
     QAction *m_actSaveM3U{};
     QAction *m_actClear{};
     QAction *m_actRemove{};
+    QAction *m_actGapless{};
+    QAction *m_actPcmEngine{};
+    QAction *m_actEqualizer{};
+    QAction *m_actReplayGain[3]{};
+    QAction *m_actVisualizer{};
+    QAction *m_actTraceRecord{};
+    QAction *m_actTraceOverlay{};
 };
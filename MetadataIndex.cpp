@@ -0,0 +1,296 @@
+#include "MetadataIndex.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutex>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThread>
+#include <cstring>
+
+namespace {
+    constexpr char kMagic[4] = {'M', 'P', 'I', 'X'};
+    constexpr quint32 kVersion = 1;
+    constexpr int kScanChunk = 256;
+    constexpr int kSaveDelayMs = 3000;
+}
+
+MetadataIndex::MetadataIndex(QObject *parent)
+    : QObject(parent) {
+    // 背景掃描以低優先權執行，不影響播放
+    m_pool.setMaxThreadCount(std::max(2, QThread::idealThreadCount() / 2));
+    m_pool.setThreadPriority(QThread::LowPriority);
+
+    m_saveTimer.setSingleShot(true);
+    m_saveTimer.setInterval(kSaveDelayMs);
+    connect(&m_saveTimer, &QTimer::timeout, this, [this] { m_pool.start([this] { save(); }); });
+    connect(this, &MetadataIndex::updated, this, [this] { m_saveTimer.start(); });
+}
+
+MetadataIndex::~MetadataIndex() {
+    ++m_totalGeneration; // 進行中的加總提早結束
+    m_pool.clear();
+    m_pool.waitForDone();
+    save();
+    unmap();
+}
+
+QString MetadataIndex::defaultPath() {
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dir);
+    return dir + "/metadata.idx";
+}
+
+// 映射索引檔
+bool MetadataIndex::open(const QString &path) {
+    QWriteLocker lock(&m_lock);
+    return mapFile(path.isEmpty() ? defaultPath() : path);
+}
+
+// 呼叫端需持有寫鎖
+bool MetadataIndex::mapFile(const QString &path) {
+    unmap();
+    m_path = path;
+
+    m_file.setFileName(m_path);
+    if (!m_file.open(QIODevice::ReadOnly)) return false;
+    const qint64 size = m_file.size();
+    if (size < static_cast<qint64>(sizeof(Header))) {
+        m_file.close();
+        return false;
+    }
+
+    const uchar *map = m_file.map(0, size);
+    if (!map) {
+        m_file.close();
+        return false;
+    }
+
+    Header h{};
+    memcpy(&h, map, sizeof(Header));
+    const qint64 tableEnd = sizeof(Header) + static_cast<qint64>(h.count) * sizeof(Entry);
+    if (memcmp(h.magic, kMagic, 4) != 0 || h.version != kVersion || tableEnd > size) {
+        qWarning() << "metadata index invalid, ignoring:" << m_path;
+        m_file.unmap(const_cast<uchar *>(map));
+        m_file.close();
+        return false;
+    }
+
+    m_map = map;
+    m_mapSize = size;
+    m_count = h.count;
+    m_entries = reinterpret_cast<const Entry *>(map + sizeof(Header));
+    m_strings = map + tableEnd;
+    return true;
+}
+
+void MetadataIndex::unmap() {
+    if (m_map) m_file.unmap(const_cast<uchar *>(m_map));
+    m_file.close();
+    m_map = nullptr;
+    m_mapSize = 0;
+    m_entries = nullptr;
+    m_count = 0;
+    m_strings = nullptr;
+}
+
+// FNV-1a（跨程序穩定，不能用 qHash）
+quint64 MetadataIndex::hashPath(const QString &path) {
+    quint64 h = 14695981039346656037ULL;
+    for (const QChar c: path) {
+        h ^= c.unicode();
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+QString MetadataIndex::stringAt(quint32 off) const {
+    const qint64 base = m_strings - m_map;
+    if (base + off + 2 > m_mapSize) return {};
+    quint16 len;
+    memcpy(&len, m_strings + off, 2);
+    if (base + off + 2 + len > m_mapSize) return {};
+    return QString::fromUtf8(reinterpret_cast<const char *>(m_strings + off + 2), len);
+}
+
+// 二分搜尋
+const MetadataIndex::Entry *MetadataIndex::findEntry(const QString &path) const {
+    if (!m_entries) return nullptr;
+    const quint64 h = hashPath(path);
+    const Entry *end = m_entries + m_count;
+    const Entry *it = std::lower_bound(m_entries, end, h, [](const Entry &e, quint64 v) { return e.pathHash < v; });
+    for (; it != end && it->pathHash == h; ++it) {
+        if (stringAt(it->pathOff) == path) return it;
+    }
+    return nullptr;
+}
+
+TrackInfo MetadataIndex::infoOf(const Entry &e) const {
+    TrackInfo info;
+    info.title = stringAt(e.titleOff);
+    info.artist = stringAt(e.artistOff);
+    info.album = stringAt(e.albumOff);
+    info.durationMs = e.durationMs;
+    info.bitrate = static_cast<int>(e.bitrate);
+    info.sampleRate = static_cast<int>(e.sampleRate);
+    return info;
+}
+
+std::optional<TrackInfo> MetadataIndex::find(const QString &path) const {
+    QReadLocker lock(&m_lock);
+    if (const auto it = m_fresh.constFind(path); it != m_fresh.cend()) return it->info;
+    if (const Entry *e = findEntry(path)) return infoOf(*e);
+    if (const auto it = m_hints.constFind(path); it != m_hints.cend()) return *it;
+    return std::nullopt;
+}
+
+std::optional<TrackInfo> MetadataIndex::lookup(const QString &path, qint64 size, qint64 mtime) const {
+    QReadLocker lock(&m_lock);
+    if (const auto it = m_fresh.constFind(path); it != m_fresh.cend()) {
+        if (it->size == size && it->mtime == mtime) return it->info;
+        return std::nullopt;
+    }
+    if (const Entry *e = findEntry(path); e && e->size == size && e->mtime == mtime) return infoOf(*e);
+    return std::nullopt;
+}
+
+void MetadataIndex::insert(const QString &path, qint64 size, qint64 mtime, const TrackInfo &info) {
+    QWriteLocker lock(&m_lock);
+    m_fresh.insert(path, Record{size, mtime, info});
+    m_hints.remove(path);
+}
+
+void MetadataIndex::hint(const QString &path, const TrackInfo &info) {
+    QWriteLocker lock(&m_lock);
+    m_hints.insert(path, info);
+}
+
+int MetadataIndex::count() const {
+    QReadLocker lock(&m_lock);
+    return static_cast<int>(m_count + m_fresh.size());
+}
+
+// 背景掃描
+void MetadataIndex::scan(const QStringList &paths) {
+    for (qsizetype i = 0; i < paths.size(); i += kScanChunk) {
+        QStringList chunk = paths.mid(i, kScanChunk);
+        m_pool.start([this, chunk] { scanChunk(chunk); });
+    }
+}
+
+void MetadataIndex::scanChunk(const QStringList &paths) {
+    int added = 0;
+    for (const QString &path: paths) {
+        const QFileInfo fi(path);
+        if (!fi.isFile()) continue;
+        const qint64 size = fi.size();
+        const qint64 mtime = fi.lastModified().toMSecsSinceEpoch();
+        if (lookup(path, size, mtime)) continue; // 未變更：只花一次 stat
+
+        TrackInfo info;
+        TagReader::read(path, info);
+        insert(path, size, mtime, info);
+        ++added;
+    }
+    if (added > 0) emit updated(added);
+}
+
+// 背景加總長度（在 m_pool 上，解構時會等它結束）
+void MetadataIndex::requestTotalDuration(const PlaylistPaths &tracks) {
+    const int gen = ++m_totalGeneration;
+    m_pool.start([this, tracks, gen] {
+        qint64 total = 0;
+        int known = 0;
+        for (int row = 0; row < tracks.count(); ++row) {
+            if (m_totalGeneration.load(std::memory_order_relaxed) != gen) return;
+            if (const auto info = find(tracks.localFile(row)); info && info->durationMs > 0) {
+                total += info->durationMs;
+                ++known;
+            }
+        }
+        if (m_totalGeneration.load() == gen) emit totalDurationReady(total, known);
+    });
+}
+
+// 寫回：舊資料 + 新資料重新排序後寫成新檔，再重新映射
+bool MetadataIndex::save() {
+    static QMutex saveMutex;
+    QMutexLocker saveLock(&saveMutex);
+
+    QHash<QString, Record> fresh;
+    QVector<Entry> entries;
+    QByteArray strings;
+    QHash<QString, quint32> stringOffsets; // 去重（同一歌手/專輯只存一次）
+
+    auto addString = [&](const QString &s) -> quint32 {
+        if (const auto it = stringOffsets.constFind(s); it != stringOffsets.cend()) return *it;
+        const QByteArray utf8 = s.toUtf8().left(0xFFFF);
+        const auto off = static_cast<quint32>(strings.size());
+        const auto len = static_cast<quint16>(utf8.size());
+        strings.append(reinterpret_cast<const char *>(&len), 2);
+        strings.append(utf8);
+        stringOffsets.insert(s, off);
+        return off;
+    };
+    auto addEntry = [&](const QString &path, qint64 size, qint64 mtime, const TrackInfo &info) {
+        Entry e{};
+        e.pathHash = hashPath(path);
+        e.size = size;
+        e.mtime = mtime;
+        e.durationMs = static_cast<quint32>(std::clamp<qint64>(info.durationMs, 0, 0xFFFFFFFF));
+        e.bitrate = static_cast<quint32>(info.bitrate);
+        e.sampleRate = static_cast<quint32>(info.sampleRate);
+        e.pathOff = addString(path);
+        e.titleOff = addString(info.title);
+        e.artistOff = addString(info.artist);
+        e.albumOff = addString(info.album);
+        entries.push_back(e);
+    };
+
+    {
+        QReadLocker lock(&m_lock);
+        if (m_fresh.isEmpty()) return true;
+        fresh = m_fresh;
+        if (m_path.isEmpty()) m_path = defaultPath();
+
+        entries.reserve(m_count + fresh.size());
+        for (quint32 i = 0; i < m_count; ++i) {
+            const Entry &e = m_entries[i];
+            const QString path = stringAt(e.pathOff);
+            if (fresh.contains(path)) continue;
+            addEntry(path, e.size, e.mtime, infoOf(e));
+        }
+    }
+    for (auto it = fresh.cbegin(); it != fresh.cend(); ++it)
+        addEntry(it.key(), it->size, it->mtime, it->info);
+
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return a.pathHash < b.pathHash; });
+
+    Header h{};
+    memcpy(h.magic, kMagic, 4);
+    h.version = kVersion;
+    h.count = static_cast<quint32>(entries.size());
+
+    QSaveFile out(m_path);
+    if (!out.open(QIODevice::WriteOnly)) return false;
+    out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+    out.write(reinterpret_cast<const char *>(entries.constData()), entries.size() * qsizetype(sizeof(Entry)));
+    out.write(strings);
+
+    // 換檔時才需要寫鎖（Windows 無法覆蓋已映射的檔案）
+    QWriteLocker lock(&m_lock);
+    const QString path = m_path;
+    unmap();
+    const bool ok = out.commit();
+    mapFile(path);
+    if (!ok) return false;
+
+    for (auto it = fresh.cbegin(); it != fresh.cend(); ++it) {
+        if (const auto cur = m_fresh.constFind(it.key());
+            cur != m_fresh.cend() && cur->size == it->size && cur->mtime == it->mtime)
+            m_fresh.remove(it.key());
+    }
+    return true;
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <QObject>
+#include <QFile>
+#include <QHash>
+#include <QReadWriteLock>
+#include <QThreadPool>
+#include <QTimer>
+#include <QUrl>
+#include <atomic>
+#include <optional>
+#include "TagReader.h"
+#include "PlaylistPaths.h"
+
+// 持久化的曲目資訊索引（以路徑 + 大小 + 修改時間為鍵，記憶體映射的二進位檔）
+//
+// 檔案格式 (little-endian)：
+//   Header  { magic "MPIX", version, count, reserved }
+//   Entry[count]，依 pathHash 排序，可直接二分搜尋
+//   字串區：每個字串為 quint16 長度 + UTF-8
+class MetadataIndex final : public QObject {
+    Q_OBJECT
+
+public:
+    explicit MetadataIndex(QObject *parent = nullptr);
+
+    ~MetadataIndex() override;
+
+    // 載入（映射）索引檔；path 為空時使用預設位置
+    bool open(const QString &path = QString());
+
+    // 寫回磁碟（合併新資料後重新映射）
+    bool save();
+
+    // 依路徑查詢（不驗證大小/時間，供顯示用），執行緒安全
+    std::optional<TrackInfo> find(const QString &path) const;
+
+    // 依路徑 + 大小 + 修改時間查詢，執行緒安全
+    std::optional<TrackInfo> lookup(const QString &path, qint64 size, qint64 mtime) const;
+
+    void insert(const QString &path, qint64 size, qint64 mtime, const TrackInfo &info);
+
+    // 暫時提示（例如 #EXTINF），只在沒有真正的資料時顯示，不寫入磁碟
+    void hint(const QString &path, const TrackInfo &info);
+
+    // 背景掃描：未變更的檔案只需一次 stat
+    void scan(const QStringList &paths);
+
+    // 等待背景掃描完成（命令列模式使用）
+    void waitForDone() { m_pool.waitForDone(); }
+
+    // 背景計算總長度（毫秒）
+    void requestTotalDuration(const PlaylistPaths &tracks);
+
+    int count() const;
+
+    static QString defaultPath();
+
+signals:
+    void updated(int added);
+
+    void totalDurationReady(qint64 ms, int known);
+
+private:
+    struct Entry {
+        quint64 pathHash;
+        qint64 size;
+        qint64 mtime;
+        quint32 durationMs;
+        quint32 bitrate;
+        quint32 sampleRate;
+        quint32 pathOff;
+        quint32 titleOff;
+        quint32 artistOff;
+        quint32 albumOff;
+        quint32 reserved;
+    };
+
+    struct Header {
+        char magic[4];
+        quint32 version;
+        quint32 count;
+        quint32 reserved;
+    };
+
+    struct Record {
+        qint64 size;
+        qint64 mtime;
+        TrackInfo info;
+    };
+
+    static quint64 hashPath(const QString &path);
+
+    bool mapFile(const QString &path);
+
+    const Entry *findEntry(const QString &path) const;
+
+    QString stringAt(quint32 off) const;
+
+    TrackInfo infoOf(const Entry &e) const;
+
+    void scanChunk(const QStringList &paths);
+
+    void unmap();
+
+    QString m_path;
+    QFile m_file;
+    const uchar *m_map = nullptr;
+    qint64 m_mapSize = 0;
+    const Entry *m_entries = nullptr;
+    quint32 m_count = 0;
+    const uchar *m_strings = nullptr;
+
+    mutable QReadWriteLock m_lock;
+    QHash<QString, Record> m_fresh; // 尚未寫回的新資料
+    QHash<QString, TrackInfo> m_hints;
+
+    QThreadPool m_pool;
+    QTimer m_saveTimer;
+    std::atomic<int> m_totalGeneration{0};
+};
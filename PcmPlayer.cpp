@@ -0,0 +1,722 @@
+#include "PcmPlayer.h"
+
+#include <QtMultimedia/QAudioDecoder>
+#include <QtMultimedia/QAudioDevice>
+#include <QtMultimedia/QAudioSink>
+#include <QtMultimedia/QMediaDevices>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+#include <utility>
+
+namespace {
+    constexpr int kBufferMs = 2000; // 環形緩衝區長度
+    constexpr int kPrimeMs = 100; // 開始播放前先累積的量
+    constexpr int kSinkBufferMs = 100; // 音效卡端的緩衝
+    constexpr int kRetryMs = 5;
+    constexpr int kTickMs = 50;
+    constexpr int kSeekMs = 40; // 拖曳進度條時最多每 40 ms 重啟一次管線
+
+    // 固定輸出 float 立體聲，取樣率跟隨預設裝置（解碼器負責重取樣）
+    QAudioFormat outputFormat() {
+        QAudioFormat f = QMediaDevices::defaultAudioOutput().preferredFormat();
+        if (f.sampleRate() <= 0) f.setSampleRate(48000);
+        f.setChannelCount(2);
+        f.setSampleFormat(QAudioFormat::Float);
+        return f;
+    }
+}
+
+// 解碼執行緒
+PcmDecodeWorker::PcmDecodeWorker(SpscRingBuffer<float> &ring, PcmShared &shared, const QAudioFormat &format)
+    : m_ring(ring), m_shared(shared), m_format(format), m_retry(new QTimer(this)),
+      m_scratch(static_cast<size_t>(kScratch)) {
+    m_retry->setSingleShot(true);
+    m_retry->setInterval(kRetryMs);
+    connect(m_retry, &QTimer::timeout, this, &PcmDecodeWorker::pump);
+    setCrossfade(0, FadeCurve::EqualPower);
+}
+
+void PcmDecodeWorker::start(const QUrl &url, qint64 startFrame, const SeekTable::Target &from, quint64 generation) {
+    stop();
+    m_generation = generation;
+    QIODevice *range = from.isValid() ? SeekIndex::openRange(url.toLocalFile(), from.offset, from.end) : nullptr;
+    const qint64 skip = range ? from.skipFrames(m_format.sampleRate()) : startFrame;
+    m_skipSamples = skip * m_format.channelCount();
+    open(url, range, startFrame - skip);
+    m_trackDecoded = startFrame;
+}
+
+void PcmDecodeWorker::setCrossfade(int frames, FadeCurve curve) {
+    for (int i = 0; i <= kCurveSize; ++i) {
+        const double t = static_cast<double>(i) / kCurveSize;
+        double g = t;
+        if (curve == FadeCurve::EqualPower) g = std::sin(t * std::numbers::pi / 2); // 總功率不變
+        else if (curve == FadeCurve::SCurve) g = t * t * (3.0 - 2.0 * t);
+        m_curve[i] = static_cast<float>(g);
+    }
+    m_wantFadeFrames = std::max(0, frames);
+    if (m_tailCount == 0 && m_mixLen == 0) applyCrossfade();
+}
+
+// 只在尾端沒有資料時改變長度
+void PcmDecodeWorker::applyCrossfade() {
+    m_fadeFrames = m_wantFadeFrames;
+    m_tail.assign(static_cast<size_t>(m_fadeFrames) * m_format.channelCount(), 0.0f);
+    m_tailHead = 0;
+    m_tailCount = 0;
+}
+
+void PcmDecodeWorker::setNext(const QUrl &url) {
+    if (m_shared.decodeDone.load(std::memory_order_acquire)) return; // 已經收尾，改由一般換曲處理
+    m_next = url;
+    if (m_finished) pump();
+}
+
+void PcmDecodeWorker::stop() {
+    m_retry->stop();
+    if (m_decoder) {
+        m_decoder->disconnect(this);
+        m_decoder->stop();
+        m_decoder->deleteLater();
+        m_decoder = nullptr;
+    }
+    m_pending = QAudioBuffer();
+    m_pendingOffset = 0;
+    m_skipSamples = 0;
+    m_finished = false;
+    m_next.clear();
+    m_tailHead = 0;
+    m_tailCount = 0;
+    m_mixPos = 0;
+    m_mixLen = 0;
+    if (m_fadeFrames != m_wantFadeFrames) applyCrossfade();
+    m_shared.pendingFrames.store(0, std::memory_order_relaxed);
+}
+
+// 每首歌用新的解碼器
+void PcmDecodeWorker::open(const QUrl &url, QIODevice *range, qint64 rangeFrame) {
+    if (m_decoder) {
+        m_decoder->disconnect(this);
+        m_decoder->deleteLater();
+    }
+    m_decoder = new QAudioDecoder(this);
+    m_decoder->setAudioFormat(m_format);
+    if (range) {
+        range->setParent(m_decoder);
+        m_decoder->setSourceDevice(range);
+    } else {
+        m_decoder->setSource(url);
+    }
+    m_finished = false;
+    m_trackFrames = 0;
+    m_trackDecoded = 0;
+
+    connect(m_decoder, &QAudioDecoder::bufferReady, this, &PcmDecodeWorker::pump);
+    connect(m_decoder, &QAudioDecoder::finished, this, [this] {
+        m_finished = true;
+        pump();
+    });
+    const bool ranged = range != nullptr;
+    connect(m_decoder, &QAudioDecoder::durationChanged, this, [this, url, ranged, rangeFrame](qint64 ms) {
+        if (ms > 0) m_trackFrames = rangeFrame + ms * m_format.sampleRate() / 1000;
+        if (ms > 0 && !ranged) emit durationFound(m_generation, url, ms); // 區段的長度不是整首的長度
+    });
+    connect(m_decoder, qOverload<QAudioDecoder::Error>(&QAudioDecoder::error), this, [this] {
+        emit failed(m_generation, m_decoder->errorString());
+        stop();
+    });
+    m_decoder->start();
+}
+
+// 把解碼結果搬進環形緩衝區；緩衝區滿就先不讀，解碼器會停在原地等待
+void PcmDecodeWorker::pump() {
+    const int ch = m_format.channelCount();
+    while (true) {
+        if (!m_pending.isValid()) {
+            if (!m_decoder || !m_decoder->bufferAvailable()) break;
+            m_pending = m_decoder->read();
+            m_pendingOffset = 0;
+            if (!m_pending.isValid()) break;
+
+            const QAudioFormat f = m_pending.format();
+            if (f.sampleFormat() != QAudioFormat::Float || f.channelCount() != ch
+                || f.sampleRate() != m_format.sampleRate()) {
+                emit failed(m_generation, "Decoder did not deliver the requested PCM format");
+                stop();
+                return;
+            }
+        }
+
+        const qint64 total = qint64(m_pending.frameCount()) * ch;
+        if (m_skipSamples > 0) {
+            const qint64 d = std::min(m_skipSamples, total - m_pendingOffset);
+            m_pendingOffset += d;
+            m_skipSamples -= d;
+        }
+
+        m_pendingOffset += feed(m_pending.constData<float>() + m_pendingOffset, total - m_pendingOffset);
+        if (m_pendingOffset < total) {
+            m_retry->start();
+            break;
+        }
+        m_pending = QAudioBuffer();
+    }
+
+    m_shared.pendingFrames.store(m_pending.isValid() ? (m_pending.frameCount() - m_pendingOffset / ch) : 0,
+                                 std::memory_order_relaxed);
+    if (m_shared.written.load(std::memory_order_relaxed) >= qint64(m_format.sampleRate()) * kPrimeMs / 1000)
+        m_shared.primed.store(true, std::memory_order_release);
+
+    if (m_finished && !m_pending.isValid() && !(m_decoder && m_decoder->bufferAvailable())) finishTrack();
+}
+
+// 一首解碼完畢：接著解下一首，或標記結束
+void PcmDecodeWorker::finishTrack() {
+    const int ch = m_format.channelCount();
+    // 這一首比淡化長度還短：上一首剩下的尾端單獨淡出
+    while (m_mixLen > 0) {
+        const qint64 room = qint64(m_ring.freeSpace() / ch) * ch;
+        if (room <= 0) {
+            m_retry->start();
+            return;
+        }
+        mix(nullptr, room);
+    }
+    if (m_next.isEmpty()) {
+        // 沒有下一首：留下的尾端照常播完
+        while (m_tailCount > 0) {
+            const qint64 room = qint64(m_ring.freeSpace() / ch) * ch;
+            if (room <= 0) {
+                m_retry->start();
+                return;
+            }
+            tailPop(std::min(m_tailCount, room));
+        }
+        m_shared.primed.store(true, std::memory_order_release);
+        m_shared.decodeDone.store(true, std::memory_order_release);
+        return;
+    }
+    if (m_shared.boundary.load(std::memory_order_acquire) >= 0) {
+        m_retry->start(); // 上一個交接點還沒播到
+        return;
+    }
+    const QUrl next = std::exchange(m_next, QUrl());
+    m_shared.boundary.store(m_shared.written.load(std::memory_order_relaxed), std::memory_order_release);
+    if (m_tailCount > 0) {
+        m_mixLen = m_tailCount; // 下一首從尾端的第一個 sample 開始重疊
+        m_mixPos = 0;
+    }
+    emit nextStarted(m_generation, next);
+    open(next);
+}
+
+// 有下一首且接近結尾時，最後一段先留住（長度未知時從頭開始留）
+bool PcmDecodeWorker::holding() const {
+    if (m_fadeFrames <= 0 || m_next.isEmpty()) return false;
+    const qint64 margin = 2 * qint64(m_fadeFrames) + 2 * qint64(m_format.sampleRate()); // 長度估計可能不準
+    return m_trackFrames <= 0 || m_trackDecoded + margin >= m_trackFrames;
+}
+
+qint64 PcmDecodeWorker::feed(const float *in, qint64 n) {
+    const int ch = m_format.channelCount();
+    if (m_fadeFrames != m_wantFadeFrames && m_tailCount == 0 && m_mixLen == 0) applyCrossfade();
+
+    qint64 used = 0;
+    while (used < n) {
+        // 只寫完整的 frame
+        const qint64 room = qint64(m_ring.freeSpace() / ch) * ch;
+        qint64 m;
+        if (m_mixLen > 0) {
+            m = mix(in + used, std::min(n - used, room));
+        } else if (holding()) {
+            const auto cap = static_cast<qint64>(m_tail.size());
+            if (m_tailCount < cap) {
+                m = std::min(n - used, cap - m_tailCount); // 先填滿，不輸出
+            } else {
+                m = std::min(n - used, room);
+                tailPop(m); // 最舊的送出，新的補進來
+            }
+            tailPush(in + used, m);
+        } else if (m_tailCount > 0) {
+            // 下一首被取消：留下的尾端照常送出
+            const qint64 k = std::min(m_tailCount, room);
+            if (k <= 0) break;
+            tailPop(k);
+            continue;
+        } else {
+            m = std::min(n - used, room);
+            writeRing(in + used, m);
+        }
+        if (m <= 0) break;
+        used += m;
+    }
+    m_trackDecoded += used / ch;
+    return used;
+}
+
+void PcmDecodeWorker::writeRing(const float *src, qint64 n) {
+    if (n <= 0) return;
+    m_ring.write(src, static_cast<size_t>(n));
+    m_shared.written.fetch_add(n / m_format.channelCount(), std::memory_order_release);
+}
+
+void PcmDecodeWorker::tailPush(const float *src, qint64 n) {
+    const auto cap = static_cast<qint64>(m_tail.size());
+    const qint64 pos = (m_tailHead + m_tailCount) % cap;
+    const qint64 first = std::min(n, cap - pos);
+    memcpy(m_tail.data() + pos, src, sizeof(float) * first);
+    memcpy(m_tail.data(), src + first, sizeof(float) * (n - first));
+    m_tailCount += n;
+}
+
+void PcmDecodeWorker::tailPop(qint64 n) {
+    if (n <= 0) return;
+    const auto cap = static_cast<qint64>(m_tail.size());
+    const qint64 first = std::min(n, cap - m_tailHead);
+    writeRing(m_tail.data() + m_tailHead, first);
+    writeRing(m_tail.data(), n - first);
+    m_tailHead = (m_tailHead + n) % cap;
+    m_tailCount -= n;
+    if (m_tailCount == 0) m_tailHead = 0;
+}
+
+// 重疊區間內 t 從 0 到 1：淡出增益取曲線的反向，兩端對稱
+qint64 PcmDecodeWorker::mix(const float *in, qint64 n) {
+    const int ch = m_format.channelCount();
+    n = std::min({n, m_mixLen - m_mixPos, kScratch});
+    if (n <= 0) return 0;
+
+    const auto cap = static_cast<qint64>(m_tail.size());
+    qint64 at = (m_tailHead + m_mixPos) % cap;
+    const float step = static_cast<float>(ch) / static_cast<float>(m_mixLen);
+    float t = static_cast<float>(m_mixPos) / static_cast<float>(m_mixLen);
+    float *out = m_scratch.data();
+    for (qint64 i = 0; i < n; i += ch, t += step) {
+        const float gIn = curveGain(t);
+        const float gOut = curveGain(1.0f - t);
+        for (int c = 0; c < ch; ++c) {
+            out[i + c] = m_tail[at] * gOut + (in ? in[i + c] * gIn : 0.0f);
+            if (++at == cap) at = 0;
+        }
+    }
+    writeRing(out, n);
+
+    m_mixPos += n;
+    if (m_mixPos == m_mixLen) {
+        m_mixPos = m_mixLen = 0;
+        m_tailHead = m_tailCount = 0;
+    }
+    return n;
+}
+
+float PcmDecodeWorker::curveGain(float t) const {
+    const float x = std::clamp(t, 0.0f, 1.0f) * kCurveSize;
+    const int i = std::min(static_cast<int>(x), kCurveSize - 1);
+    return m_curve[i] + (m_curve[i + 1] - m_curve[i]) * (x - static_cast<float>(i));
+}
+
+// 輸出裝置
+PcmRingDevice::PcmRingDevice(SpscRingBuffer<float> &ring, PcmShared &shared, DspChain &dsp, AudioTap &tap,
+                             const QAudioFormat &format, QObject *parent)
+    : QIODevice(parent), m_ring(ring), m_shared(shared), m_dsp(dsp), m_tap(tap),
+      m_channels(format.channelCount()), m_sampleRate(format.sampleRate()),
+      m_rampLen(shared.fadeInFrames.load(std::memory_order_relaxed)), m_rampLeft(m_rampLen) {
+}
+
+qint64 PcmRingDevice::bytesAvailable() const {
+    return qint64(m_ring.available() * sizeof(float)) + QIODevice::bytesAvailable();
+}
+
+// 音訊回呼：不加鎖、不配置記憶體
+qint64 PcmRingDevice::readData(char *data, qint64 maxlen) {
+    const qint64 frames = maxlen / qint64(sizeof(float) * m_channels);
+    if (frames <= 0) return 0;
+    auto *out = reinterpret_cast<float *>(data);
+    const auto want = static_cast<size_t>(frames * m_channels);
+
+    if (const int fade = m_shared.fadeOutFrames.exchange(0, std::memory_order_relaxed); fade > 0) {
+        m_rampDown = true;
+        m_rampLen = m_rampLeft = fade;
+    }
+    if (m_silent) { // 淡出完成，等待管線停止
+        std::fill(out, out + want, 0.0f);
+        return qint64(want * sizeof(float));
+    }
+
+    // 先讀結束旗標：看到它時，解碼器寫入的資料也都可見
+    const bool done = m_shared.decodeDone.load(std::memory_order_acquire);
+    const bool primed = done || m_shared.primed.load(std::memory_order_acquire);
+    const size_t got = primed ? m_ring.read(out, want) : 0;
+    if (got == 0 && done) return 0; // 播完，讓 sink 進入 Idle
+
+    m_dsp.process(out, static_cast<int>(got / m_channels));
+    m_tap.write(out, static_cast<int>(got / m_channels), m_channels, m_sampleRate);
+    if (m_rampLeft > 0) {
+        const int n = static_cast<int>(got / m_channels);
+        int f = 0;
+        for (; f < n && m_rampLeft > 0; ++f, --m_rampLeft) {
+            const float r = static_cast<float>(m_rampLeft) / static_cast<float>(m_rampLen);
+            const float g = m_rampDown ? r : 1.0f - r;
+            for (int c = 0; c < m_channels; ++c) out[f * m_channels + c] *= g;
+        }
+        if (m_rampDown && m_rampLeft == 0) {
+            std::fill(out + f * m_channels, out + got, 0.0f);
+            m_silent = true;
+        }
+    }
+    if (const float g = m_shared.gain.load(std::memory_order_relaxed); g != 1.0f) {
+        for (size_t i = 0; i < got; ++i) out[i] *= g;
+    }
+    if (got < want) {
+        std::fill(out + got, out + want, 0.0f);
+        if (primed && !done) m_shared.underruns.fetch_add(1, std::memory_order_relaxed);
+    }
+    m_shared.consumed.fetch_add(qint64(got) / m_channels, std::memory_order_release);
+    return qint64(want * sizeof(float));
+}
+
+// 輸出執行緒
+PcmOutput::PcmOutput(SpscRingBuffer<float> &ring, PcmShared &shared, DspChain &dsp, AudioTap &tap,
+                     const QAudioFormat &format)
+    : m_ring(ring), m_shared(shared), m_dsp(dsp), m_tap(tap), m_format(format) {
+}
+
+void PcmOutput::start(quint64 generation) {
+    stop();
+    m_generation = generation;
+    m_device = new PcmRingDevice(m_ring, m_shared, m_dsp, m_tap, m_format, this);
+    m_device->open(QIODevice::ReadOnly);
+    m_sink = new QAudioSink(QMediaDevices::defaultAudioOutput(), m_format, this);
+    m_sink->setBufferSize(m_format.bytesForDuration(qint64(kSinkBufferMs) * 1000));
+    connect(m_sink, &QAudioSink::stateChanged, this, [this](QAudio::State s) {
+        if (s == QAudio::IdleState && m_shared.decodeDone.load(std::memory_order_acquire))
+            emit drained(m_generation);
+    });
+    m_sink->start(m_device);
+}
+
+void PcmOutput::suspend() {
+    if (m_sink) m_sink->suspend();
+}
+
+void PcmOutput::resume() {
+    if (m_sink) m_sink->resume();
+}
+
+void PcmOutput::stop() {
+    if (m_sink) {
+        m_sink->stop(); // 返回後不會再呼叫 readData
+        delete m_sink;
+        m_sink = nullptr;
+    }
+    delete m_device;
+    m_device = nullptr;
+}
+
+// 播放引擎
+PcmPlayer::PcmPlayer(QObject *parent)
+    : QObject(parent),
+      m_format(outputFormat()),
+      m_ring(static_cast<size_t>(m_format.sampleRate()) * m_format.channelCount() * kBufferMs / 1000),
+      m_decoder(new PcmDecodeWorker(m_ring, m_shared, m_format)),
+      m_output(new PcmOutput(m_ring, m_shared, m_dsp, m_tap, m_format)) {
+    m_dsp.prepare(m_format.sampleRate());
+    m_decodeThread.setObjectName("pcm-decode");
+    m_outputThread.setObjectName("pcm-output");
+    m_decoder->moveToThread(&m_decodeThread);
+    m_output->moveToThread(&m_outputThread);
+    connect(&m_decodeThread, &QThread::finished, m_decoder, &QObject::deleteLater);
+    connect(&m_outputThread, &QThread::finished, m_output, &QObject::deleteLater);
+
+    connect(m_decoder, &PcmDecodeWorker::durationFound, this, &PcmPlayer::onDurationFound);
+    connect(m_decoder, &PcmDecodeWorker::nextStarted, this, &PcmPlayer::onNextStarted);
+    connect(m_decoder, &PcmDecodeWorker::failed, this, &PcmPlayer::onFailed);
+    connect(m_output, &PcmOutput::drained, this, &PcmPlayer::onDrained);
+    connect(&m_seekIndex, &SeekIndex::ready, this, [this](const QString &path) {
+        if (m_source.isLocalFile() && m_source.toLocalFile() == path) loadSeekTable();
+    });
+
+    m_tick.setInterval(kTickMs);
+    connect(&m_tick, &QTimer::timeout, this, &PcmPlayer::tick);
+    m_seekTimer.setSingleShot(true);
+    m_seekTimer.setInterval(kSeekMs);
+    connect(&m_seekTimer, &QTimer::timeout, this, [this] {
+        if (m_seekSource != m_source) return; // 目標屬於別首歌
+        startPipeline(m_seekMs);
+        if (m_state == QMediaPlayer::PausedState) {
+            QMetaObject::invokeMethod(m_output, &PcmOutput::suspend);
+            m_tick.stop();
+        }
+    });
+    m_fadeTimer.setSingleShot(true);
+    connect(&m_fadeTimer, &QTimer::timeout, this, [this] {
+        const bool start = m_startAfterFade;
+        stopPipeline();
+        if (start) startPipeline(m_trackOffsetMs);
+    });
+
+    m_decodeThread.start();
+    m_outputThread.start(QThread::TimeCriticalPriority);
+}
+
+PcmPlayer::~PcmPlayer() {
+    stopPipeline();
+    m_decodeThread.quit();
+    m_outputThread.quit();
+    m_decodeThread.wait();
+    m_outputThread.wait();
+}
+
+void PcmPlayer::setSource(const QUrl &url) {
+    if (m_skipFadeMs > 0 && m_running && m_state == QMediaPlayer::PlayingState && !url.isEmpty())
+        fadeOutPipeline();
+    else
+        stopPipeline();
+    m_source = url;
+    m_next.clear();
+    m_trackOffsetMs = 0;
+    m_durationMs = 0;
+    m_error.clear();
+    emit durationChanged(0);
+    loadSeekTable();
+    setState(QMediaPlayer::StoppedState);
+    setStatus(url.isEmpty() ? QMediaPlayer::NoMedia : QMediaPlayer::LoadedMedia);
+}
+
+void PcmPlayer::setNextSource(const QUrl &url) {
+    if (url == m_next) return;
+    m_next = url;
+    if (m_running) QMetaObject::invokeMethod(m_decoder, [d = m_decoder, url] { d->setNext(url); });
+}
+
+void PcmPlayer::play() {
+    if (m_source.isEmpty() || m_state == QMediaPlayer::PlayingState) return;
+    if (m_state == QMediaPlayer::PausedState && m_running) {
+        QMetaObject::invokeMethod(m_output, &PcmOutput::resume);
+        m_tick.start();
+    } else {
+        startPipeline(m_trackOffsetMs);
+    }
+    setState(QMediaPlayer::PlayingState);
+    setStatus(QMediaPlayer::BufferedMedia);
+}
+
+void PcmPlayer::pause() {
+    if (m_state != QMediaPlayer::PlayingState) return;
+    if (m_fadeTimer.isActive()) m_startAfterFade = false; // 淡出完就停在這裡
+    else QMetaObject::invokeMethod(m_output, &PcmOutput::suspend);
+    m_tick.stop();
+    setState(QMediaPlayer::PausedState);
+    emit positionChanged(position());
+}
+
+void PcmPlayer::stop() {
+    stopPipeline();
+    m_trackOffsetMs = 0;
+    setState(QMediaPlayer::StoppedState);
+    emit positionChanged(0);
+}
+
+// 跳轉：重啟管線；有跳轉表時從目標前的幀讀起，否則從頭解碼並丟棄目標位置之前的 sample。
+// 連續的跳轉（拖曳進度條）只記下最新的目標，由 m_seekTimer 合併成一次重啟
+void PcmPlayer::setPosition(qint64 ms) {
+    ms = std::max<qint64>(0, ms);
+    if (m_running) {
+        m_seekMs = ms;
+        m_seekSource = m_source;
+        if (!m_seekTimer.isActive()) m_seekTimer.start();
+    } else {
+        m_trackOffsetMs = ms;
+    }
+    emit positionChanged(ms);
+}
+
+qint64 PcmPlayer::position() const {
+    if (m_seekTimer.isActive()) return m_seekMs;
+    if (!m_running || m_fadeTimer.isActive()) return m_trackOffsetMs;
+    const qint64 frames = m_shared.consumed.load(std::memory_order_acquire) - m_trackStartFrame;
+    return m_trackOffsetMs + framesToMs(std::max<qint64>(0, frames));
+}
+
+void PcmPlayer::setVolume(float v) {
+    m_volume = std::clamp(v, 0.0f, 1.0f);
+    applyGain();
+}
+
+void PcmPlayer::setMuted(bool muted) {
+    m_muted = muted;
+    applyGain();
+}
+
+void PcmPlayer::setDspParams(const DspChain::Params &params) {
+    const float replayGainDb = m_dspParams.replayGainDb;
+    m_dspParams = params;
+    m_dspParams.replayGainDb = replayGainDb;
+    m_dsp.setParams(m_dspParams);
+}
+
+void PcmPlayer::setReplayGain(float db) {
+    if (m_dspParams.replayGainDb == db) return;
+    m_dspParams.replayGainDb = db;
+    m_dsp.setParams(m_dspParams);
+}
+
+void PcmPlayer::setCrossfade(int ms, FadeCurve curve) {
+    const int frames = msToFrames(std::clamp(ms, 0, 12000));
+    QMetaObject::invokeMethod(m_decoder, [d = m_decoder, frames, curve] { d->setCrossfade(frames, curve); });
+}
+
+void PcmPlayer::applyGain() {
+    m_shared.gain.store(m_muted ? 0.0f : m_volume, std::memory_order_relaxed);
+}
+
+PcmPlayer::Metrics PcmPlayer::metrics() const {
+    const int ch = m_format.channelCount();
+    const auto buffered = static_cast<qint64>(m_ring.available()) / ch;
+    Metrics m;
+    m.bufferedMs = framesToMs(buffered);
+    m.capacityMs = framesToMs(static_cast<qint64>(m_ring.capacity()) / ch);
+    m.decodeAheadMs = framesToMs(buffered + m_shared.pendingFrames.load(std::memory_order_relaxed));
+    m.underruns = m_shared.underruns.load(std::memory_order_relaxed);
+    return m;
+}
+
+int PcmPlayer::framesToMs(qint64 frames) const {
+    return static_cast<int>(frames * 1000 / m_format.sampleRate());
+}
+
+int PcmPlayer::msToFrames(int ms) const {
+    return static_cast<int>(qint64(ms) * m_format.sampleRate() / 1000);
+}
+
+// 啟動解碼與輸出（從 startMs 開始）
+void PcmPlayer::startPipeline(qint64 startMs) {
+    if (m_fadeTimer.isActive()) { // 舊管線還在淡出，結束後再開始
+        m_trackOffsetMs = startMs;
+        m_startAfterFade = true;
+        return;
+    }
+    stopPipeline();
+    m_running = true;
+    m_trackStartFrame = 0;
+    m_trackOffsetMs = startMs;
+    const quint64 gen = ++m_generation;
+    const qint64 start = startMs * m_format.sampleRate() / 1000;
+    // 耗時與跳轉位置、檔案長度無關
+    const SeekTable::Target from = startMs > 0 && m_seekTable ? m_seekTable->locate(startMs) : SeekTable::Target{};
+
+    QMetaObject::invokeMethod(m_decoder, [d = m_decoder, url = m_source, start, from, gen] {
+        d->start(url, start, from, gen);
+    });
+    if (!m_next.isEmpty())
+        QMetaObject::invokeMethod(m_decoder, [d = m_decoder, url = m_next] { d->setNext(url); });
+    m_shared.fadeInFrames.store(msToFrames(m_skipFadeMs), std::memory_order_relaxed);
+    QMetaObject::invokeMethod(m_output, [o = m_output, gen] { o->start(gen); });
+    m_tick.start();
+}
+
+// 換曲時先淡出：等音效卡端的緩衝也播完才真正停止，避免爆音
+void PcmPlayer::fadeOutPipeline() {
+    if (m_fadeTimer.isActive()) return;
+    m_tick.stop();
+    ++m_generation; // 舊管線之後的訊號一律忽略
+    m_advanceUrl.clear();
+    m_shared.fadeOutFrames.store(msToFrames(m_skipFadeMs), std::memory_order_relaxed);
+    m_fadeTimer.start(m_skipFadeMs + kSinkBufferMs);
+}
+
+// 停止兩端後才重設緩衝區（SPSC 的 reset 不能與讀寫同時進行）
+void PcmPlayer::stopPipeline() {
+    m_fadeTimer.stop();
+    m_seekTimer.stop();
+    m_startAfterFade = false;
+    m_tick.stop();
+    if (!m_running) return;
+    m_running = false;
+    QMetaObject::invokeMethod(m_output, &PcmOutput::stop, Qt::BlockingQueuedConnection);
+    QMetaObject::invokeMethod(m_decoder, &PcmDecodeWorker::stop, Qt::BlockingQueuedConnection);
+
+    m_ring.reset();
+    m_dsp.reset();
+    m_shared.written.store(0, std::memory_order_relaxed);
+    m_shared.consumed.store(0, std::memory_order_relaxed);
+    m_shared.boundary.store(-1, std::memory_order_relaxed);
+    m_shared.pendingFrames.store(0, std::memory_order_relaxed);
+    m_shared.primed.store(false, std::memory_order_relaxed);
+    m_shared.decodeDone.store(false, std::memory_order_relaxed);
+    m_shared.fadeOutFrames.store(0, std::memory_order_relaxed);
+    m_advanceUrl.clear();
+}
+
+// 定時更新位置；播放到交接點時切換為下一首（有跳轉等著套用時不切換：管線會從目前這首的目標重啟）
+void PcmPlayer::tick() {
+    const qint64 boundary = m_shared.boundary.load(std::memory_order_acquire);
+    if (boundary >= 0 && !m_advanceUrl.isEmpty() && !m_seekTimer.isActive()
+        && m_shared.consumed.load(std::memory_order_acquire) >= boundary) {
+        m_trackStartFrame = boundary;
+        m_trackOffsetMs = 0;
+        m_source = std::exchange(m_advanceUrl, QUrl());
+        m_next.clear();
+        m_durationMs = std::exchange(m_nextDurationMs, 0);
+        m_shared.boundary.store(-1, std::memory_order_release); // 解碼器可以再接下一首
+        emit durationChanged(m_durationMs);
+        loadSeekTable();
+        emit trackAdvanced(m_source);
+    }
+    emit positionChanged(position());
+}
+
+void PcmPlayer::onDurationFound(quint64 generation, const QUrl &url, qint64 ms) {
+    if (generation != m_generation) return;
+    if (url == m_advanceUrl) {
+        m_nextDurationMs = ms;
+    } else if (url == m_source && !(m_seekTable && m_seekTable->exact)) {
+        m_durationMs = ms;
+        emit durationChanged(ms);
+    }
+}
+
+void PcmPlayer::loadSeekTable() {
+    m_seekTable = m_source.isLocalFile() ? m_seekIndex.request(m_source.toLocalFile()) : std::nullopt;
+    if (m_seekTable && m_seekTable->exact && m_seekTable->durationMs() != m_durationMs) {
+        m_durationMs = m_seekTable->durationMs();
+        emit durationChanged(m_durationMs);
+    }
+}
+
+void PcmPlayer::onNextStarted(quint64 generation, const QUrl &url) {
+    if (generation != m_generation) return;
+    m_advanceUrl = url;
+    m_nextDurationMs = 0;
+}
+
+void PcmPlayer::onFailed(quint64 generation, const QString &error) {
+    if (generation != m_generation) return;
+    stopPipeline();
+    m_error = error;
+    setState(QMediaPlayer::StoppedState);
+    setStatus(QMediaPlayer::InvalidMedia);
+    emit errorOccurred(QMediaPlayer::ResourceError, error);
+}
+
+void PcmPlayer::onDrained(quint64 generation) {
+    if (generation != m_generation || !m_running) return;
+    stopPipeline();
+    m_trackOffsetMs = 0;
+    setState(QMediaPlayer::StoppedState);
+    setStatus(QMediaPlayer::EndOfMedia);
+}
+
+void PcmPlayer::setState(QMediaPlayer::PlaybackState state) {
+    if (state == m_state) return;
+    m_state = state;
+    emit playbackStateChanged(state);
+}
+
+void PcmPlayer::setStatus(QMediaPlayer::MediaStatus status) {
+    if (status == m_status) return;
+    m_status = status;
+    emit mediaStatusChanged(status);
+}
@@ -0,0 +1,329 @@
+#pragma once
+#include <QObject>
+#include <QIODevice>
+#include <QThread>
+#include <QTimer>
+#include <QUrl>
+#include <QtMultimedia/QAudioBuffer>
+#include <QtMultimedia/QAudioFormat>
+#include <QtMultimedia/QMediaPlayer>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <vector>
+#include "SpscRingBuffer.h"
+#include "DspChain.h"
+#include "AudioTap.h"
+#include "SeekIndex.h"
+
+class QAudioDecoder;
+class QAudioSink;
+
+// 解碼執行緒、輸出執行緒與 GUI 之間共用的狀態（全部是 atomic）
+struct PcmShared {
+    std::atomic<qint64> written{0}; // 已寫入環形緩衝區的 frame 數
+    std::atomic<qint64> consumed{0}; // 已交給音效卡的 frame 數
+    std::atomic<qint64> boundary{-1}; // 下一首開始的 frame（無縫接續，-1 = 無）
+    std::atomic<qint64> pendingFrames{0}; // 解碼器手上、尚未放進緩衝區的 frame 數
+    std::atomic<quint64> underruns{0};
+    std::atomic<float> gain{1.0f};
+    std::atomic<bool> primed{false}; // 預先緩衝完成才開始計算 underrun
+    std::atomic<bool> decodeDone{false};
+    std::atomic<int> fadeInFrames{0}; // 新的輸出從靜音淡入
+    std::atomic<int> fadeOutFrames{0}; // 要求輸出淡出到靜音（換曲防爆音）
+};
+
+// 交叉淡化曲線（淡入增益；淡出為時間反向）
+enum class FadeCurve { Linear, EqualPower, SCurve };
+
+// 解碼執行緒：QAudioDecoder → 環形緩衝區（唯一的生產者）
+class PcmDecodeWorker final : public QObject {
+    Q_OBJECT
+
+public:
+    PcmDecodeWorker(SpscRingBuffer<float> &ring, PcmShared &shared, const QAudioFormat &format);
+
+public slots:
+    // 從 startFrame 開始；from 有效時直接從檔案中該幀讀起，不必從頭解碼
+    void start(const QUrl &url, qint64 startFrame, const SeekTable::Target &from, quint64 generation);
+
+    void setNext(const QUrl &url);
+
+    // 0 = 無縫直接接續；緩衝在這裡配置一次，之後每個緩衝區都不配置記憶體
+    void setCrossfade(int frames, FadeCurve curve);
+
+    void stop();
+
+signals:
+    void durationFound(quint64 generation, const QUrl &url, qint64 ms);
+
+    // 已開始解碼下一首（交接點在 PcmShared::boundary）
+    void nextStarted(quint64 generation, const QUrl &url);
+
+    void failed(quint64 generation, const QString &error);
+
+private:
+    // range 不為 nullptr 時從該裝置解碼，rangeFrame 為它在曲目中的起點
+    void open(const QUrl &url, QIODevice *range = nullptr, qint64 rangeFrame = 0);
+
+    void pump();
+
+    void finishTrack();
+
+    // 經過交叉淡化階段寫入環形緩衝區，回傳用掉的輸入 sample 數（受空間限制）
+    qint64 feed(const float *in, qint64 n);
+
+    bool holding() const;
+
+    void writeRing(const float *src, qint64 n);
+
+    void tailPush(const float *src, qint64 n);
+
+    // 把最舊的 n 個 sample 寫出
+    void tailPop(qint64 n);
+
+    // 混合尾端與下一首的開頭（in 為 nullptr 時只淡出尾端）
+    qint64 mix(const float *in, qint64 n);
+
+    float curveGain(float t) const;
+
+    void applyCrossfade();
+
+    SpscRingBuffer<float> &m_ring;
+    PcmShared &m_shared;
+    const QAudioFormat m_format;
+    QAudioDecoder *m_decoder = nullptr;
+    QTimer *m_retry; // 緩衝區滿時稍後再試
+    QAudioBuffer m_pending;
+    qint64 m_pendingOffset = 0; // 已寫出的 sample 數
+    qint64 m_skipSamples = 0; // 跳轉：丟棄開頭的 sample
+    bool m_finished = false;
+    QUrl m_next;
+    quint64 m_generation = 0;
+    qint64 m_trackFrames = 0; // 解碼器回報的長度（0 = 未知）
+    qint64 m_trackDecoded = 0; // 目前曲目已處理的 frame 數
+
+    // 交叉淡化：有下一首時，目前曲目最後的 m_fadeFrames 個 frame 先留在 m_tail，
+    // 下一首開頭與它逐 sample 混合後才寫入環形緩衝區
+    static constexpr int kCurveSize = 1024;
+    static constexpr qint64 kScratch = 4096;
+    int m_fadeFrames = 0;
+    int m_wantFadeFrames = 0;
+    std::array<float, kCurveSize + 1> m_curve{};
+    std::vector<float> m_tail; // 環形
+    qint64 m_tailHead = 0; // 最舊 sample 的位置
+    qint64 m_tailCount = 0;
+    qint64 m_mixPos = 0; // 混合中：已混合 / 總共的 sample 數（m_mixLen = 0 表示沒在混合）
+    qint64 m_mixLen = 0;
+    std::vector<float> m_scratch;
+};
+
+// 拉取模式的輸出裝置：音訊回呼只從環形緩衝區複製，不加鎖、不配置記憶體
+class PcmRingDevice final : public QIODevice {
+    Q_OBJECT
+
+public:
+    PcmRingDevice(SpscRingBuffer<float> &ring, PcmShared &shared, DspChain &dsp, AudioTap &tap,
+                  const QAudioFormat &format, QObject *parent = nullptr);
+
+    bool isSequential() const override { return true; }
+
+    qint64 bytesAvailable() const override;
+
+protected:
+    qint64 readData(char *data, qint64 maxlen) override;
+
+    qint64 writeData(const char *, qint64) override { return -1; }
+
+private:
+    SpscRingBuffer<float> &m_ring;
+    PcmShared &m_shared;
+    DspChain &m_dsp;
+    AudioTap &m_tap;
+    const int m_channels;
+    const int m_sampleRate;
+    int m_rampLen = 0; // 淡入/淡出
+    int m_rampLeft = 0;
+    bool m_rampDown = false;
+    bool m_silent = false; // 淡出完成，之後只輸出靜音
+};
+
+// 輸出執行緒：持有 QAudioSink（唯一的消費者）
+class PcmOutput final : public QObject {
+    Q_OBJECT
+
+public:
+    PcmOutput(SpscRingBuffer<float> &ring, PcmShared &shared, DspChain &dsp, AudioTap &tap,
+              const QAudioFormat &format);
+
+public slots:
+    void start(quint64 generation);
+
+    void suspend();
+
+    void resume();
+
+    void stop();
+
+signals:
+    // 解碼完畢且音效卡已播完
+    void drained(quint64 generation);
+
+private:
+    SpscRingBuffer<float> &m_ring;
+    PcmShared &m_shared;
+    DspChain &m_dsp;
+    AudioTap &m_tap;
+    const QAudioFormat m_format;
+    QAudioSink *m_sink = nullptr;
+    PcmRingDevice *m_device = nullptr;
+    quint64 m_generation = 0;
+};
+
+// 自行解碼與輸出的播放引擎，介面與訊號比照 QMediaPlayer
+//
+// QAudioDecoder（解碼執行緒，交叉淡化在此混合）→ SpscRingBuffer（float PCM）→ DspChain → QAudioSink（輸出執行緒）
+//                                                                                        └→ AudioTap（視覺化）
+class PcmPlayer final : public QObject {
+    Q_OBJECT
+
+public:
+    struct Metrics {
+        int bufferedMs = 0; // 緩衝區內的音訊
+        int capacityMs = 0;
+        int decodeAheadMs = 0; // 解碼領先播放的量（含尚未放入緩衝區的部分）
+        quint64 underruns = 0;
+    };
+
+    explicit PcmPlayer(QObject *parent = nullptr);
+
+    ~PcmPlayer() override;
+
+    void setSource(const QUrl &url);
+
+    // 無縫播放：目前曲目解碼完後直接接著解碼這一首
+    void setNextSource(const QUrl &url);
+
+    QUrl source() const { return m_source; }
+
+    void play();
+
+    void pause();
+
+    void stop();
+
+    void setPosition(qint64 ms);
+
+    qint64 position() const;
+
+    qint64 duration() const { return m_durationMs; }
+
+    QMediaPlayer::PlaybackState playbackState() const { return m_state; }
+
+    QMediaPlayer::MediaStatus mediaStatus() const { return m_status; }
+
+    QString errorString() const { return m_error; }
+
+    void setVolume(float v);
+
+    void setMuted(bool muted);
+
+    // 等化器、前級與限幅器（在輸出執行緒即時套用）
+    void setDspParams(const DspChain::Params &params);
+
+    // ReplayGain（dB），由 DSP 的前級套用，提升音量時由限幅器防止削波
+    void setReplayGain(float db);
+
+    // 與 setNextSource() 指定的下一首重疊 ms 毫秒（0 = 無縫直接接續）
+    void setCrossfade(int ms, FadeCurve curve);
+
+    // 手動換曲時先淡出、新曲淡入（0 = 直接切換）
+    void setSkipFade(int ms) { m_skipFadeMs = std::max(0, ms); }
+
+    const char *dspKernel() const { return m_dsp.kernelName(); }
+
+    // 等化器之後、音量之前的輸出樣本（視覺化用）
+    AudioTap &tap() { return m_tap; }
+
+    Metrics metrics() const;
+
+signals:
+    void positionChanged(qint64 ms);
+
+    void durationChanged(qint64 ms);
+
+    void playbackStateChanged(QMediaPlayer::PlaybackState state);
+
+    void mediaStatusChanged(QMediaPlayer::MediaStatus status);
+
+    void errorOccurred(QMediaPlayer::Error error, const QString &errorString);
+
+    // 已無縫接到 setNextSource() 指定的曲目
+    void trackAdvanced(const QUrl &url);
+
+private:
+    void startPipeline(qint64 startMs);
+
+    void stopPipeline();
+
+    void fadeOutPipeline();
+
+    void tick();
+
+    void onDurationFound(quint64 generation, const QUrl &url, qint64 ms);
+
+    // 目前曲目的跳轉表；精確表的長度取代解碼器的估計值
+    void loadSeekTable();
+
+    void onNextStarted(quint64 generation, const QUrl &url);
+
+    void onFailed(quint64 generation, const QString &error);
+
+    void onDrained(quint64 generation);
+
+    void setState(QMediaPlayer::PlaybackState state);
+
+    void setStatus(QMediaPlayer::MediaStatus status);
+
+    void applyGain();
+
+    int framesToMs(qint64 frames) const;
+
+    int msToFrames(int ms) const;
+
+    const QAudioFormat m_format;
+    SpscRingBuffer<float> m_ring;
+    PcmShared m_shared;
+    DspChain m_dsp;
+    AudioTap m_tap;
+    SeekIndex m_seekIndex;
+    std::optional<SeekTable> m_seekTable;
+
+    QThread m_decodeThread;
+    QThread m_outputThread;
+    PcmDecodeWorker *m_decoder;
+    PcmOutput *m_output;
+    QTimer m_tick; // 位置更新與換曲偵測
+    QTimer m_fadeTimer; // 淡出中：舊管線播完淡出後才停止
+    QTimer m_seekTimer; // 跳轉合併：到期時從 m_seekMs 重啟管線
+    bool m_startAfterFade = false;
+    int m_skipFadeMs = 0;
+
+    QUrl m_source;
+    QUrl m_next; // 要求的下一首
+    QUrl m_advanceUrl; // 解碼器已接上、尚未播到交接點的下一首
+    qint64 m_nextDurationMs = 0;
+    qint64 m_durationMs = 0;
+    qint64 m_trackStartFrame = 0; // 目前曲目第一個 frame 在串流中的位置
+    qint64 m_trackOffsetMs = 0; // 跳轉起點
+    qint64 m_seekMs = 0; // 等著套用的跳轉目標
+    QUrl m_seekSource; // m_seekMs 所屬的曲目
+    quint64 m_generation = 0; // 每次重啟管線遞增，丟棄過期訊號
+    bool m_running = false;
+    float m_volume = 1.0f;
+    bool m_muted = false;
+    DspChain::Params m_dspParams;
+    QMediaPlayer::PlaybackState m_state = QMediaPlayer::StoppedState;
+    QMediaPlayer::MediaStatus m_status = QMediaPlayer::NoMedia;
+    QString m_error;
+};
@@ -0,0 +1,345 @@
+#include "PlayOrder.h"
+
+#include <QRandomGenerator>
+#include <algorithm>
+
+namespace {
+    // 刪除列之後的新列號，被刪除的回傳 -1（rows 為升冪）
+    int shiftRemoved(const QVector<int> &rows, int x) {
+        if (x < 0) return -1;
+        const auto it = std::lower_bound(rows.cbegin(), rows.cend(), x);
+        if (it != rows.cend() && *it == x) return -1;
+        return x - static_cast<int>(it - rows.cbegin());
+    }
+
+    template<typename T, typename F>
+    void remap(std::deque<T> &items, F &&shift) {
+        std::deque<T> out;
+        for (T item: items) {
+            if (shift(item)) out.push_back(item);
+        }
+        items.swap(out);
+    }
+}
+
+void PlayOrder::setShuffle(bool on) {
+    if (on == m_shuffle) return;
+    m_shuffle = on;
+    m_ahead.clear();
+    // 每次開啟都是新的一輪，目前曲目算已播過
+    if (on) rebuild(m_count, m_current >= 0 ? QVector<int>{m_current} : QVector<int>());
+}
+
+void PlayOrder::setRepeat(Repeat repeat) {
+    m_repeat = repeat;
+}
+
+void PlayOrder::setFilter(const QVector<int> *rows) {
+    dropAhead();
+    m_filter = rows;
+}
+
+void PlayOrder::reset(int count) {
+    m_current = -1;
+    m_anchor = -1;
+    m_ahead.clear();
+    m_queue.clear();
+    m_back.clear();
+    m_forward.clear();
+    rebuild(count, {});
+}
+
+void PlayOrder::insertRows(int first, int count) {
+    if (count <= 0) return;
+    auto shift = [first, count](int &x) {
+        if (x >= first) x += count;
+        return true;
+    };
+    QVector<int> drawn = m_shuffle ? drawnRows() : QVector<int>();
+    for (int &x: drawn) shift(x);
+    remap(m_queue, shift);
+    remap(m_back, shift);
+    remap(m_forward, shift);
+    remap(m_ahead, [&shift](Ahead &a) { return shift(a.row); });
+    if (m_current >= 0) shift(m_current);
+    if (m_anchor >= 0) shift(m_anchor);
+    rebuild(m_count + count, drawn);
+}
+
+// 只重新編號已抽過的列與各個佇列，未抽過的仍是恆等對應
+void PlayOrder::removeRows(const QVector<int> &rows) {
+    if (rows.isEmpty()) return;
+    auto shift = [&rows](int &x) { return (x = shiftRemoved(rows, x)) >= 0; };
+
+    QVector<int> drawn;
+    if (m_shuffle) {
+        for (int x: drawnRows()) {
+            if (shift(x)) drawn.push_back(x);
+        }
+    }
+    remap(m_queue, shift);
+    remap(m_back, shift);
+    remap(m_forward, shift);
+    remap(m_ahead, [&shift](Ahead &a) { return shift(a.row); });
+    m_current = shiftRemoved(rows, m_current);
+    if (m_anchor >= 0) {
+        // 被刪除時停在前一列，順序模式從刪除處之後接著播
+        const auto it = std::lower_bound(rows.cbegin(), rows.cend(), m_anchor);
+        const int below = static_cast<int>(it - rows.cbegin());
+        m_anchor = it != rows.cend() && *it == m_anchor ? m_anchor - below - 1 : m_anchor - below;
+    }
+    rebuild(m_count - static_cast<int>(rows.size()), drawn);
+}
+
+void PlayOrder::remapRows(const QVector<int> &newRowOf, int count) {
+    auto shift = [&newRowOf](int &x) {
+        x = x >= 0 && x < newRowOf.size() ? newRowOf[x] : -1;
+        return x >= 0;
+    };
+
+    QVector<int> drawn;
+    if (m_shuffle) {
+        for (int x: drawnRows()) {
+            if (shift(x)) drawn.push_back(x);
+        }
+    }
+    remap(m_queue, shift);
+    remap(m_back, shift);
+    remap(m_forward, shift);
+    remap(m_ahead, [&shift](Ahead &a) { return shift(a.row); });
+    shift(m_current);
+    if (m_anchor >= 0) {
+        // 被移除時停在前面最近一個保留的列
+        int anchor = std::min<int>(m_anchor, static_cast<int>(newRowOf.size()) - 1);
+        while (anchor >= 0 && newRowOf[anchor] < 0) --anchor;
+        m_anchor = anchor >= 0 ? newRowOf[anchor] : -1;
+    }
+    rebuild(count, drawn);
+}
+
+// 直接點選：已抽好的預覽仍然有效，只是這一列不再重播
+void PlayOrder::setCurrent(int row) {
+    if (row == m_current) return;
+    pushHistory(m_current);
+    m_forward.clear();
+    m_current = row;
+    m_anchor = row;
+    if (!m_shuffle || row < 0 || row >= m_count) return;
+    const auto it = std::ranges::find(m_ahead, row, &Ahead::row);
+    if (it != m_ahead.end()) m_ahead.erase(it);
+    else take(row);
+}
+
+void PlayOrder::enqueue(const QVector<int> &rows, bool front) {
+    if (front) {
+        for (auto it = rows.crbegin(); it != rows.crend(); ++it) m_queue.push_front(*it);
+    } else {
+        m_queue.insert(m_queue.end(), rows.cbegin(), rows.cend());
+    }
+}
+
+int PlayOrder::next(bool manual) {
+    if (m_count == 0) return -1;
+    if (!manual && m_repeat == RepeatOne && m_current >= 0) return m_current;
+
+    int row;
+    bool fromQueue = false;
+    if (!m_forward.empty()) {
+        row = m_forward.back();
+        m_forward.pop_back();
+    } else if (!m_queue.empty()) {
+        row = m_queue.front();
+        m_queue.pop_front();
+        fromQueue = true;
+        if (m_shuffle) {
+            const auto it = std::ranges::find(m_ahead, row, &Ahead::row);
+            if (it != m_ahead.end()) m_ahead.erase(it);
+            else take(row);
+        }
+    } else if (m_shuffle) {
+        if (m_ahead.empty() && !drawAhead()) return -1;
+        row = m_ahead.front().row;
+        m_ahead.pop_front();
+    } else {
+        row = stepForward(m_anchor >= 0 ? m_anchor : m_current);
+        if (row < 0) return -1;
+    }
+
+    pushHistory(m_current);
+    m_current = row;
+    if (!fromQueue) m_anchor = row;
+    return row;
+}
+
+int PlayOrder::previous() {
+    int row = -1;
+    if (!m_back.empty()) {
+        row = m_back.back();
+        m_back.pop_back();
+    } else if (!m_shuffle) {
+        row = stepBack(m_current);
+    }
+    if (row < 0) return -1;
+    if (m_current >= 0) m_forward.push_back(m_current);
+    m_current = row;
+    m_anchor = row;
+    return row;
+}
+
+int PlayOrder::peekNext(bool manual) const {
+    if (!manual && m_repeat == RepeatOne && m_current >= 0) return m_current;
+    const QVector<int> rows = upcoming(1);
+    return rows.isEmpty() ? -1 : rows.front();
+}
+
+int PlayOrder::peekPrevious() const {
+    if (!m_back.empty()) return m_back.back();
+    return m_shuffle ? -1 : stepBack(m_current);
+}
+
+// 依序：上一首之後的、佇列、再來是順序或預先抽好的隨機列
+QVector<int> PlayOrder::upcoming(int n) const {
+    QVector<int> rows;
+    for (auto it = m_forward.crbegin(); it != m_forward.crend() && rows.size() < n; ++it) rows.push_back(*it);
+    for (auto it = m_queue.cbegin(); it != m_queue.cend() && rows.size() < n; ++it) rows.push_back(*it);
+
+    if (m_shuffle) {
+        for (size_t i = 0; rows.size() < n; ++i) {
+            if (i == m_ahead.size() && !drawAhead()) break;
+            rows.push_back(m_ahead[i].row);
+        }
+        return rows;
+    }
+    const int start = m_anchor >= 0 ? m_anchor : m_current;
+    for (int row = start; rows.size() < n;) {
+        row = stepForward(row);
+        if (row < 0 || row == start || (!rows.isEmpty() && row == rows.front())) break;
+        rows.push_back(row);
+    }
+    return rows;
+}
+
+void PlayOrder::setAt(int pos, int row) const {
+    if (pos == row) {
+        m_at.remove(pos);
+        m_pos.remove(row);
+    } else {
+        m_at.insert(pos, row);
+        m_pos.insert(row, pos);
+    }
+}
+
+void PlayOrder::swapPos(int a, int b) const {
+    if (a == b) return;
+    const int ra = rowAt(a);
+    const int rb = rowAt(b);
+    setAt(a, rb);
+    setAt(b, ra);
+}
+
+void PlayOrder::take(int row) const {
+    if (const int p = posOf(row); p < m_left) {
+        swapPos(p, m_left - 1);
+        --m_left;
+    }
+}
+
+void PlayOrder::putBack(int row) const {
+    if (const int p = posOf(row); p >= m_left) {
+        swapPos(p, m_left);
+        ++m_left;
+    }
+}
+
+// 從還沒抽到的區段隨機取一個，換到區段尾端
+int PlayOrder::draw() const {
+    if (m_left == 0) {
+        if (m_repeat == RepeatOff || m_count == 0) return -1;
+        // 新的一輪：目前與預先抽好的列不會馬上重播
+        m_at.clear();
+        m_pos.clear();
+        m_left = m_count;
+        if (m_current >= 0) take(m_current);
+        for (const Ahead &a: m_ahead) take(a.row);
+        if (m_left == 0) m_left = m_count; // 清單太短，只能重複
+    }
+    const int j = static_cast<int>(QRandomGenerator::global()->bounded(m_left));
+    const int row = rowAt(j);
+    swapPos(j, m_left - 1);
+    --m_left;
+    return row;
+}
+
+bool PlayOrder::drawAhead() const {
+    if (!m_filter) {
+        const int row = draw();
+        if (row < 0) return false;
+        m_ahead.push_back({row, true});
+        return true;
+    }
+    // 過濾中：在符合的列之間隨機（不保證一輪內不重複），避免連續兩次同一首
+    const auto n = static_cast<int>(m_filter->size());
+    if (n == 0) return false;
+    const int last = m_ahead.empty() ? m_current : m_ahead.back().row;
+    int i = static_cast<int>(QRandomGenerator::global()->bounded(n));
+    if ((*m_filter)[i] == last && n > 1) i = (i + 1) % n;
+    const int row = (*m_filter)[i];
+    m_ahead.push_back({row, posOf(row) < m_left});
+    take(row);
+    return true;
+}
+
+void PlayOrder::rebuild(int count, const QVector<int> &drawn) {
+    m_count = std::max(0, count);
+    m_at.clear();
+    m_pos.clear();
+    m_left = m_count;
+    if (!m_shuffle) return;
+    for (const int row: drawn) {
+        if (row >= 0 && row < m_count) take(row);
+    }
+}
+
+QVector<int> PlayOrder::drawnRows() const {
+    QVector<int> rows;
+    rows.reserve(m_count - m_left);
+    for (int pos = m_left; pos < m_count; ++pos) rows.push_back(rowAt(pos));
+    return rows;
+}
+
+void PlayOrder::dropAhead() {
+    for (const Ahead &a: m_ahead) {
+        if (a.took) putBack(a.row);
+    }
+    m_ahead.clear();
+}
+
+int PlayOrder::stepForward(int after) const {
+    if (m_count == 0) return -1;
+    if (!m_filter) {
+        if (after + 1 < m_count) return after + 1;
+        return m_repeat == RepeatOff ? -1 : 0;
+    }
+    if (m_filter->isEmpty()) return -1;
+    const auto it = std::upper_bound(m_filter->cbegin(), m_filter->cend(), after);
+    if (it != m_filter->cend()) return *it;
+    return m_repeat == RepeatOff ? -1 : m_filter->front();
+}
+
+int PlayOrder::stepBack(int before) const {
+    if (m_count == 0) return -1;
+    if (!m_filter) {
+        if (before > 0) return before - 1;
+        return m_repeat == RepeatOff ? -1 : m_count - 1;
+    }
+    if (m_filter->isEmpty()) return -1;
+    const auto it = std::lower_bound(m_filter->cbegin(), m_filter->cend(), before);
+    if (it != m_filter->cbegin()) return *(it - 1);
+    return m_repeat == RepeatOff ? -1 : m_filter->back();
+}
+
+void PlayOrder::pushHistory(int row) {
+    if (row < 0 || (!m_back.empty() && m_back.back() == row)) return;
+    m_back.push_back(row);
+    if (m_back.size() > kHistory) m_back.pop_front();
+}
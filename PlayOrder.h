@@ -0,0 +1,118 @@
+#pragma once
+#include <QHash>
+#include <QVector>
+#include <cstddef>
+#include <deque>
+
+// 播放順序：順序/隨機、重複模式、播放歷史與「接下來播放」佇列
+//
+// 隨機用延遲產生的 Fisher–Yates：虛擬陣列 [0, count) 未抽過的在前、抽過的在後，
+// 只記錄與恆等排列不同的位置（稀疏），每一步 O(1)、一輪內不重複，不需要先洗整份清單。
+// 清單增刪列時只重新編號已抽過的列（與抽過的數量成正比），未抽過的仍然是恆等對應。
+class PlayOrder final {
+public:
+    enum Repeat { RepeatOff, RepeatAll, RepeatOne };
+
+    void setShuffle(bool on);
+
+    bool shuffle() const { return m_shuffle; }
+
+    void setRepeat(Repeat repeat);
+
+    Repeat repeat() const { return m_repeat; }
+
+    // 過濾中的來源列（升冪，由呼叫端持有）；nullptr = 全部
+    void setFilter(const QVector<int> *rows);
+
+    // 清單整個換掉
+    void reset(int count);
+
+    void insertRows(int first, int count);
+
+    // rows 為升冪
+    void removeRows(const QVector<int> &rows);
+
+    // 大量移除/重新排序：newRowOf[舊列] = 新列（-1 = 移除），沒有舊列對應的新列為插入的列
+    void remapRows(const QVector<int> &newRowOf, int count);
+
+    // 開始播放 row（點選等）：前一首進入歷史
+    void setCurrent(int row);
+
+    int current() const { return m_current; }
+
+    // 加入「接下來播放」佇列；front 為 true 時插在最前面
+    void enqueue(const QVector<int> &rows, bool front);
+
+    int queued() const { return static_cast<int>(m_queue.size()); }
+
+    // 下一首並設為目前曲目（-1 = 播完）；自動換曲時單曲重複回傳目前曲目
+    int next(bool manual);
+
+    int previous();
+
+    // 不改變順序的預覽（隨機時會先抽好並保留）
+    int peekNext(bool manual) const;
+
+    int peekPrevious() const;
+
+    QVector<int> upcoming(int n) const;
+
+private:
+    static constexpr size_t kHistory = 1000;
+
+    int rowAt(int pos) const { return m_at.value(pos, pos); }
+
+    int posOf(int row) const { return m_pos.value(row, row); }
+
+    void setAt(int pos, int row) const;
+
+    void swapPos(int a, int b) const;
+
+    // 移出/放回這一輪未抽過的區段
+    void take(int row) const;
+
+    void putBack(int row) const;
+
+    // 抽完一輪時依重複模式開始新的一輪
+    int draw() const;
+
+    // 隨機：再抽一首放進預覽
+    bool drawAhead() const;
+
+    // 從新的恆等排列開始，只把 drawn 移到已抽過的區段
+    void rebuild(int count, const QVector<int> &drawn);
+
+    QVector<int> drawnRows() const;
+
+    // 預先抽好的列還給這一輪
+    void dropAhead();
+
+    // 順序模式（過濾中只在符合的列之間移動）
+    int stepForward(int after) const;
+
+    int stepBack(int before) const;
+
+    void pushHistory(int row);
+
+    bool m_shuffle = false;
+    Repeat m_repeat = RepeatAll;
+    const QVector<int> *m_filter = nullptr;
+
+    int m_count = 0;
+    int m_current = -1;
+    int m_anchor = -1; // 順序模式從這一列接著走（播放佇列中的曲目不改變它）
+
+    // 隨機：稀疏的位置 → 列與其反向；[0, m_left) 為這一輪還沒抽到的
+    mutable QHash<int, int> m_at;
+    mutable QHash<int, int> m_pos;
+    mutable int m_left = 0;
+    struct Ahead {
+        int row;
+        bool took; // 抽的時候還在這一輪裡（過濾中可能抽到已播過的）
+    };
+    mutable std::deque<Ahead> m_ahead; // 預覽時先抽好的
+
+    std::deque<int> m_queue;
+    std::deque<int> m_back; // 歷史（最新的在尾端）
+    std::deque<int> m_forward; // 上一首之後再按下一首時回到這裡
+};
@@ -0,0 +1,163 @@
+#include "PlaylistCommands.h"
+#include "PlaylistModel.h"
+
+#include <algorithm>
+#include <numeric>
+
+QVector<RowRange> toRanges(const QVector<int> &rows) {
+    QVector<RowRange> ranges;
+    for (const int row: rows) {
+        if (!ranges.isEmpty() && ranges.back().first + ranges.back().count == row) ++ranges.back().count;
+        else ranges.push_back({row, 1});
+    }
+    return ranges;
+}
+
+AddRowsCommand::AddRowsCommand(PlaylistModel *model, const QList<QUrl> &urls, quint64 batch)
+    : m_model(model), m_urls(urls), m_batch(batch), m_count(static_cast<int>(urls.size())) {
+    setText(QString("Add %1 Track(s)").arg(m_count));
+}
+
+void AddRowsCommand::redo() {
+    if (m_first < 0) {
+        m_first = m_model->count();
+        m_model->append(m_urls);
+        m_urls.clear();
+        return;
+    }
+    m_model->append(m_undone);
+    m_undone.clear();
+}
+
+void AddRowsCommand::undo() {
+    const int n = m_count;
+    QVector<int> rows(n);
+    std::iota(rows.begin(), rows.end(), m_first);
+    m_undone = m_model->subset(rows);
+
+    QVector<int> newRowOf(m_model->count());
+    for (int row = 0; row < newRowOf.size(); ++row) {
+        newRowOf[row] = row < m_first ? row : row < m_first + n ? -1 : row - n;
+    }
+    m_model->remap(newRowOf, static_cast<int>(newRowOf.size()) - n);
+}
+
+bool AddRowsCommand::mergeWith(const QUndoCommand *other) {
+    const auto *add = static_cast<const AddRowsCommand *>(other);
+    if (m_batch == 0 || add->m_batch != m_batch || add->m_model != m_model || add->m_first != m_first + m_count)
+        return false;
+    m_count += add->m_count;
+    setText(QString("Add %1 Track(s)").arg(m_count));
+    return true;
+}
+
+RemoveRowsCommand::RemoveRowsCommand(PlaylistModel *model, const QVector<int> &rows, bool missing)
+    : m_model(model), m_ranges(toRanges(rows)), m_tracks(model->subset(rows)), m_missing(missing) {
+    updateText();
+}
+
+void RemoveRowsCommand::updateText() {
+    setText(QString(m_missing ? "Remove %1 Missing Track(s)" : "Remove %1 Track(s)").arg(m_tracks.count()));
+}
+
+QVector<int> RemoveRowsCommand::rows() const {
+    QVector<int> rows;
+    rows.reserve(m_tracks.count());
+    for (const RowRange &r: m_ranges) {
+        for (int row = r.first; row < r.first + r.count; ++row) rows.push_back(row);
+    }
+    return rows;
+}
+
+// other 的列號是這次移除之後的：換算回移除前，兩批依列號交錯合併
+bool RemoveRowsCommand::mergeWith(const QUndoCommand *other) {
+    const auto *rm = static_cast<const RemoveRowsCommand *>(other);
+    if (!m_missing || !rm->m_missing || rm->m_model != m_model) return false;
+    const QVector<int> mine = rows();
+    const QVector<int> theirs = rm->rows();
+    QVector<int> merged;
+    merged.reserve(mine.size() + theirs.size());
+    TrackStore tracks;
+    tracks.reserve(mine.size() + theirs.size());
+    qsizetype i = 0;
+    for (qsizetype j = 0; j < theirs.size(); ++j) {
+        // 之後的第 t 列 = 之前的第 t + (在它之前移除的列數) 列
+        for (; i < mine.size() && mine[i] <= theirs[j] + i; ++i) {
+            merged.push_back(mine[i]);
+            tracks.append(m_tracks, static_cast<int>(i));
+        }
+        merged.push_back(theirs[j] + static_cast<int>(i));
+        tracks.append(rm->m_tracks, static_cast<int>(j));
+    }
+    for (; i < mine.size(); ++i) {
+        merged.push_back(mine[i]);
+        tracks.append(m_tracks, static_cast<int>(i));
+    }
+    m_ranges = toRanges(merged);
+    m_tracks = std::move(tracks);
+    updateText();
+    return true;
+}
+
+// 一次壓縮：每列往前移動它之前被移除的列數
+void RemoveRowsCommand::redo() {
+    QVector<int> newRowOf(m_model->count());
+    int removed = 0;
+    int next = 0;
+    for (const RowRange &r: std::as_const(m_ranges)) {
+        for (; next < r.first; ++next) newRowOf[next] = next - removed;
+        for (; next < r.first + r.count; ++next) newRowOf[next] = -1;
+        removed += r.count;
+    }
+    for (; next < newRowOf.size(); ++next) newRowOf[next] = next - removed;
+    m_model->remap(newRowOf, static_cast<int>(newRowOf.size()) - removed);
+}
+
+void RemoveRowsCommand::undo() {
+    m_model->insertAt(rows(), m_tracks);
+}
+
+MoveRowsCommand::MoveRowsCommand(PlaylistModel *model, const QVector<int> &rows, int dest)
+    : m_model(model), m_ranges(toRanges(rows)), m_dest(dest) {
+    setText(QString("Move %1 Track(s)").arg(rows.size()));
+}
+
+// 移動的列排在 block 起點之後，其餘的列依序填滿前後
+QVector<int> MoveRowsCommand::forward() const {
+    const int count = m_model->count();
+    QVector<int> newRowOf(count, -1);
+    int moved = 0;
+    int before = 0; // dest 之前被移走的列數
+    for (const RowRange &r: m_ranges) {
+        for (int row = r.first; row < r.first + r.count; ++row) newRowOf[row] = moved++;
+        before += std::clamp(m_dest - r.first, 0, r.count);
+    }
+    const int block = m_dest - before;
+
+    bool changed = false;
+    int rest = 0;
+    for (int row = 0; row < count; ++row) {
+        int &n = newRowOf[row];
+        if (n >= 0) n += block;
+        else n = rest < block ? rest++ : moved + rest++;
+        changed |= n != row;
+    }
+    return changed ? newRowOf : QVector<int>();
+}
+
+void MoveRowsCommand::redo() {
+    const QVector<int> newRowOf = forward();
+    if (newRowOf.isEmpty()) {
+        setObsolete(true); // 沒有實際移動，不放進復原堆疊
+        return;
+    }
+    m_model->remap(newRowOf, static_cast<int>(newRowOf.size()));
+}
+
+void MoveRowsCommand::undo() {
+    const QVector<int> newRowOf = forward();
+    if (newRowOf.isEmpty()) return;
+    QVector<int> back(newRowOf.size());
+    for (int row = 0; row < newRowOf.size(); ++row) back[newRowOf[row]] = row;
+    m_model->remap(back, static_cast<int>(back.size()));
+}
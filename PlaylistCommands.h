@@ -0,0 +1,82 @@
+#pragma once
+#include <QUndoCommand>
+#include <QUrl>
+#include <QVector>
+#include "TrackStore.h"
+
+class PlaylistModel;
+
+// 播放清單的可復原編輯：只記錄變動的列範圍（與被移除的列），不保存整份清單的拷貝。
+// 所有改變列結構的編輯都要經過同一個 QUndoStack，記錄的列號才會一直有效。
+struct RowRange {
+    int first;
+    int count;
+};
+
+// 升冪列號 → 連續範圍
+QVector<RowRange> toRanges(const QVector<int> &rows);
+
+// 加入到最後；同一次匯入（batch 相同且不為 0）的批次合併成一個命令。加入的列在清單中時不另外保留，復原時才取出
+class AddRowsCommand final : public QUndoCommand {
+public:
+    AddRowsCommand(PlaylistModel *model, const QList<QUrl> &urls, quint64 batch = 0);
+
+    void redo() override;
+
+    void undo() override;
+
+    int id() const override { return 1; }
+
+    bool mergeWith(const QUndoCommand *other) override;
+
+private:
+    PlaylistModel *m_model;
+    QList<QUrl> m_urls; // 第一次 redo 後清空
+    TrackStore m_undone; // 復原後等待重做的列
+    quint64 m_batch;
+    int m_first = -1;
+    int m_count;
+};
+
+// missing：音樂庫中消失的檔案；連續幾次這種移除合併成一個命令，檔案事件不會塞滿復原堆疊
+class RemoveRowsCommand final : public QUndoCommand {
+public:
+    // rows 為升冪
+    RemoveRowsCommand(PlaylistModel *model, const QVector<int> &rows, bool missing = false);
+
+    void redo() override;
+
+    void undo() override;
+
+    int id() const override { return m_missing ? 2 : -1; }
+
+    bool mergeWith(const QUndoCommand *other) override;
+
+private:
+    QVector<int> rows() const;
+
+    void updateText();
+
+    PlaylistModel *m_model;
+    QVector<RowRange> m_ranges;
+    TrackStore m_tracks; // 與範圍內的列依序對應
+    bool m_missing;
+};
+
+class MoveRowsCommand final : public QUndoCommand {
+public:
+    // rows（升冪）整塊移到移動前的第 dest 列之前（dest = 列數時移到最後），保持原本的相對順序
+    MoveRowsCommand(PlaylistModel *model, const QVector<int> &rows, int dest);
+
+    void redo() override;
+
+    void undo() override;
+
+private:
+    // 舊列 → 新列；位置沒有改變時回傳空的
+    QVector<int> forward() const;
+
+    PlaylistModel *m_model;
+    QVector<RowRange> m_ranges;
+    int m_dest;
+};
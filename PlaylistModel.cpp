@@ -0,0 +1,453 @@
+#include "PlaylistModel.h"
+#include "MetadataIndex.h"
+#include "SessionSnapshot.h"
+
+#include <QFileInfo>
+#include <QMimeData>
+#include <QPainter>
+
+PlaylistModel::PlaylistModel(QObject *parent)
+    : QAbstractListModel(parent) {
+}
+
+int PlaylistModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : count();
+}
+
+QVariant PlaylistModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() >= count()) return {};
+    const int row = index.row();
+
+    switch (role) {
+        case Qt::DisplayRole:
+            // 只在可見時才產生顯示文字
+            if (m_meta) {
+                if (const auto info = m_meta->find(localFile(row)); info && !info->title.isEmpty())
+                    return info->artist.isEmpty() ? info->title : info->artist + " – " + info->title;
+            }
+            return displayName(row);
+        case DurationRole:
+            if (m_meta) {
+                if (const auto info = m_meta->find(localFile(row))) return info->durationMs;
+            }
+            return qint64(0);
+        case Qt::ToolTipRole:
+            if (const QString reason = unplayableReason(row); !reason.isEmpty())
+                return localFile(row) + "\nCannot be played: " + reason;
+            if (const QString original = m_duplicates.value(localFile(row)); !original.isEmpty())
+                return localFile(row) + "\nDuplicate of " + original;
+            return localFile(row);
+        case UrlRole:
+            return url(row);
+        case NowPlayingRole:
+            return row == m_nowPlaying;
+        case DuplicateRole:
+            if (m_duplicates.isEmpty()) return QString();
+            return m_duplicates.value(localFile(row));
+        case UnplayableRole:
+            return unplayableReason(row);
+        default:
+            return {};
+    }
+}
+
+Qt::ItemFlags PlaylistModel::flags(const QModelIndex &index) const {
+    const Qt::ItemFlags f = QAbstractListModel::flags(index);
+    return index.isValid() ? f | Qt::ItemIsDragEnabled : f;
+}
+
+Qt::DropActions PlaylistModel::supportedDragActions() const {
+    return Qt::CopyAction | Qt::MoveAction;
+}
+
+QStringList PlaylistModel::mimeTypes() const {
+    return {"text/uri-list"};
+}
+
+QMimeData *PlaylistModel::mimeData(const QModelIndexList &indexes) const {
+    QList<QUrl> urls;
+    urls.reserve(indexes.size());
+    for (const QModelIndex &index: indexes) {
+        if (index.isValid() && index.row() < count()) urls.push_back(url(index.row()));
+    }
+    auto *mime = new QMimeData;
+    mime->setUrls(urls);
+    return mime;
+}
+
+// 快照中的列記著快照列號，重新排列後仍然有效
+QUrl PlaylistModel::url(int row) const {
+    if (const int p = m_tracks.pendingRow(row); p >= 0) return m_snapshot->url(p);
+    return m_tracks.url(row);
+}
+
+QString PlaylistModel::localFile(int row) const {
+    if (const int p = m_tracks.pendingRow(row); p >= 0) return m_snapshot->url(p).toLocalFile();
+    return m_tracks.localFile(row);
+}
+
+QString PlaylistModel::path(int row) const {
+    if (const int p = m_tracks.pendingRow(row); p >= 0) {
+        const QUrl u = m_snapshot->url(p);
+        return u.isLocalFile() ? u.toLocalFile() : u.toString();
+    }
+    return m_tracks.path(row);
+}
+
+const TrackStore &PlaylistModel::tracks() const {
+    materializeAll();
+    return m_tracks;
+}
+
+int PlaylistModel::indexOf(const QUrl &url) const {
+    return tracks().indexOf(url);
+}
+
+TrackStore PlaylistModel::subset(const QVector<int> &rows) const {
+    TrackStore out;
+    out.reserve(rows.size());
+    for (const int row: rows) {
+        if (const int p = m_tracks.pendingRow(row); p >= 0) out.append(m_snapshot->url(p));
+        else out.append(m_tracks, row);
+    }
+    return out;
+}
+
+// 取出所有仍在快照中的列，之後可以釋放映射（快照檔會被改寫）
+void PlaylistModel::materializeAll() const {
+    if (!m_snapshot) return;
+    for (int row = 0; row < count(); ++row) {
+        if (const int p = m_tracks.pendingRow(row); p >= 0) m_tracks.set(row, m_snapshot->url(p));
+    }
+    m_snapshot.reset();
+}
+
+void PlaylistModel::restore(std::shared_ptr<const SessionSnapshot> snapshot) {
+    beginResetModel();
+    m_tracks.clear();
+    if (snapshot) m_tracks.appendPending(snapshot->count());
+    m_snapshot = m_tracks.isEmpty() ? nullptr : std::move(snapshot);
+    m_nowPlaying = -1;
+    m_duplicates.clear();
+    endResetModel();
+}
+
+// 加入整批
+void PlaylistModel::append(const QList<QUrl> &urls) {
+    if (urls.isEmpty()) return;
+    const int first = count();
+    beginInsertRows(QModelIndex(), first, first + static_cast<int>(urls.size()) - 1);
+    m_tracks.reserve(first + urls.size());
+    for (const QUrl &url: urls) m_tracks.append(url);
+    endInsertRows();
+}
+
+void PlaylistModel::append(const TrackStore &tracks) {
+    if (tracks.isEmpty()) return;
+    const int first = count();
+    beginInsertRows(QModelIndex(), first, first + tracks.count() - 1);
+    m_tracks.reserve(first + tracks.count());
+    for (int row = 0; row < tracks.count(); ++row) m_tracks.append(tracks, row);
+    endInsertRows();
+}
+
+void PlaylistModel::setUrl(int row, const QUrl &url) {
+    if (row < 0 || row >= count()) return;
+    m_tracks.set(row, url);
+    emit dataChanged(index(row), index(row));
+}
+
+// 只搬移每列 8 位元組的參照，路徑字串不動
+void PlaylistModel::remap(const QVector<int> &newRowOf, int count) {
+    if (newRowOf.size() != this->count()) return;
+    emit rowsAboutToBeRemapped(newRowOf, count);
+    emit layoutAboutToBeChanged();
+    m_tracks.remap(newRowOf, count);
+    endRelayout(newRowOf);
+}
+
+// 合併一次：舊列依序填入插入列之間的空位
+void PlaylistModel::insertAt(const QVector<int> &rows, const TrackStore &tracks) {
+    const int total = count() + static_cast<int>(rows.size());
+    if (rows.isEmpty() || rows.size() != tracks.count() || rows.back() >= total) return;
+    QVector<int> newRowOf(count());
+    int old = 0;
+    qsizetype k = 0;
+    for (int n = 0; n < total; ++n) {
+        if (k < rows.size() && rows[k] == n) ++k;
+        else newRowOf[old++] = n;
+    }
+    emit layoutAboutToBeChanged();
+    m_tracks.insertAt(rows, tracks);
+    endRelayout(newRowOf);
+}
+
+void PlaylistModel::endRelayout(const QVector<int> &newRowOf) {
+    if (m_nowPlaying >= 0) m_nowPlaying = m_nowPlaying < newRowOf.size() ? newRowOf[m_nowPlaying] : -1;
+
+    const QModelIndexList from = persistentIndexList();
+    QModelIndexList to;
+    to.reserve(from.size());
+    for (const QModelIndex &idx: from) {
+        const int row = idx.row() < newRowOf.size() ? newRowOf[idx.row()] : -1;
+        to.push_back(row >= 0 ? index(row) : QModelIndex());
+    }
+    changePersistentIndexList(from, to);
+    emit rowsRemapped(newRowOf, count());
+    emit layoutChanged();
+}
+
+// 清空
+void PlaylistModel::clear() {
+    beginResetModel();
+    m_tracks.clear();
+    m_snapshot.reset();
+    m_nowPlaying = -1;
+    m_duplicates.clear();
+    endResetModel();
+}
+
+// 設定正在播放的列
+void PlaylistModel::setNowPlaying(int row) {
+    if (row == m_nowPlaying) return;
+    const int old = m_nowPlaying;
+    m_nowPlaying = (row >= 0 && row < count()) ? row : -1;
+
+    const QList<int> roles{NowPlayingRole};
+    if (old >= 0) emit dataChanged(index(old), index(old), roles);
+    if (m_nowPlaying >= 0) emit dataChanged(index(m_nowPlaying), index(m_nowPlaying), roles);
+}
+
+// 通知所有列重新取值
+void PlaylistModel::refreshMetadata() {
+    if (isEmpty()) return;
+    emit dataChanged(index(0), index(count() - 1), {Qt::DisplayRole, DurationRole});
+}
+
+// 只通知重繪，可見列才會重新取值
+void PlaylistModel::markDuplicates(const QStringList &paths, const QStringList &originals) {
+    for (qsizetype i = 0; i < paths.size() && i < originals.size(); ++i) m_duplicates.insert(paths[i], originals[i]);
+    if (!isEmpty()) emit dataChanged(index(0), index(count() - 1), {DuplicateRole, Qt::ToolTipRole});
+}
+
+void PlaylistModel::markUnplayable(const QStringList &paths, const QStringList &reasons) {
+    for (qsizetype i = 0; i < paths.size() && i < reasons.size(); ++i) m_unplayable.insert(paths[i], reasons[i]);
+    if (!isEmpty()) emit dataChanged(index(0), index(count() - 1), {UnplayableRole, Qt::ToolTipRole});
+}
+
+QString PlaylistModel::unplayableReason(int row) const {
+    if (m_unplayable.isEmpty() || row < 0 || row >= count()) return {};
+    return m_unplayable.value(localFile(row));
+}
+
+// 顯示名稱（不含副檔名）
+QString PlaylistModel::displayName(int row) const {
+    const QString name = m_tracks.pendingRow(row) < 0 ? m_tracks.fileName(row) : url(row).fileName();
+    if (name.isEmpty()) return url(row).toString();
+    return QFileInfo(name).completeBaseName();
+}
+
+PlaylistFilterModel::PlaylistFilterModel(QObject *parent)
+    : QAbstractProxyModel(parent) {
+}
+
+// 轉接來源的結構變更（未過濾時原樣轉送，過濾時調整列號）
+void PlaylistFilterModel::setSourceModel(QAbstractItemModel *source) {
+    beginResetModel();
+    if (sourceModel()) disconnect(sourceModel(), nullptr, this, nullptr);
+    QAbstractProxyModel::setSourceModel(source);
+
+    connect(source, &QAbstractItemModel::rowsAboutToBeInserted, this, [this](const QModelIndex &, int first, int last) {
+        if (!m_filtered) beginInsertRows(QModelIndex(), first, last);
+    });
+    connect(source, &QAbstractItemModel::rowsInserted, this, [this](const QModelIndex &, int first, int last) {
+        if (!m_filtered) {
+            endInsertRows();
+            return;
+        }
+        const int n = last - first + 1;
+        for (auto it = std::lower_bound(m_rows.begin(), m_rows.end(), first); it != m_rows.end(); ++it) *it += n;
+    });
+    connect(source, &QAbstractItemModel::rowsAboutToBeRemoved, this, [this](const QModelIndex &, int first, int last) {
+        if (!m_filtered) {
+            beginRemoveRows(QModelIndex(), first, last);
+            return;
+        }
+        const auto lo = std::lower_bound(m_rows.cbegin(), m_rows.cend(), first);
+        const auto hi = std::upper_bound(m_rows.cbegin(), m_rows.cend(), last);
+        m_removeFirst = static_cast<int>(lo - m_rows.cbegin());
+        m_removeLast = static_cast<int>(hi - m_rows.cbegin()) - 1;
+        if (m_removeFirst <= m_removeLast) beginRemoveRows(QModelIndex(), m_removeFirst, m_removeLast);
+    });
+    connect(source, &QAbstractItemModel::rowsRemoved, this, [this](const QModelIndex &, int first, int last) {
+        if (!m_filtered) {
+            endRemoveRows();
+            return;
+        }
+        const int n = last - first + 1;
+        if (m_removeFirst <= m_removeLast) m_rows.remove(m_removeFirst, m_removeLast - m_removeFirst + 1);
+        for (auto it = std::lower_bound(m_rows.begin(), m_rows.end(), first); it != m_rows.end(); ++it) *it -= n;
+        if (m_removeFirst <= m_removeLast) endRemoveRows();
+        m_removeFirst = m_removeLast = -1;
+    });
+    // 來源一次重新排列（大量移除、移動）：符合的列號跟著對應，仍維持升冪
+    connect(source, &QAbstractItemModel::layoutAboutToBeChanged, this, [this] {
+        emit layoutAboutToBeChanged();
+        m_layoutFrom = persistentIndexList();
+        m_layoutSource.clear();
+        m_layoutSource.reserve(m_layoutFrom.size());
+        for (const QModelIndex &idx: std::as_const(m_layoutFrom)) m_layoutSource.push_back(mapToSource(idx).row());
+    });
+    if (const auto *playlist = qobject_cast<PlaylistModel *>(source)) {
+        connect(playlist, &PlaylistModel::rowsRemapped, this, [this](const QVector<int> &newRowOf, int) {
+            auto mapRow = [&newRowOf](int row) { return row >= 0 && row < newRowOf.size() ? newRowOf[row] : -1; };
+            if (m_filtered) {
+                QVector<int> rows;
+                rows.reserve(m_rows.size());
+                for (const int row: std::as_const(m_rows)) {
+                    if (const int n = mapRow(row); n >= 0) rows.push_back(n);
+                }
+                std::sort(rows.begin(), rows.end());
+                m_rows = std::move(rows);
+            }
+            QModelIndexList to;
+            to.reserve(m_layoutFrom.size());
+            for (const int row: std::as_const(m_layoutSource)) {
+                const int n = mapRow(row);
+                const int proxy = n >= 0 ? proxyRow(n) : -1;
+                to.push_back(proxy >= 0 ? index(proxy, 0) : QModelIndex());
+            }
+            changePersistentIndexList(m_layoutFrom, to);
+        });
+    }
+    connect(source, &QAbstractItemModel::layoutChanged, this, [this] {
+        m_layoutFrom.clear();
+        m_layoutSource.clear();
+        emit layoutChanged();
+    });
+    connect(source, &QAbstractItemModel::modelAboutToBeReset, this, [this] { beginResetModel(); });
+    connect(source, &QAbstractItemModel::modelReset, this, [this] {
+        m_rows.clear();
+        endResetModel();
+    });
+    connect(source, &QAbstractItemModel::dataChanged, this,
+            [this](const QModelIndex &tl, const QModelIndex &br, const QList<int> &roles) {
+                if (!m_filtered) {
+                    emit dataChanged(index(tl.row(), 0), index(br.row(), 0), roles);
+                    return;
+                }
+                const auto lo = std::lower_bound(m_rows.cbegin(), m_rows.cend(), tl.row());
+                const auto hi = std::upper_bound(m_rows.cbegin(), m_rows.cend(), br.row());
+                if (lo == hi) return;
+                emit dataChanged(index(static_cast<int>(lo - m_rows.cbegin()), 0),
+                                 index(static_cast<int>(hi - m_rows.cbegin()) - 1, 0), roles);
+            });
+    endResetModel();
+}
+
+void PlaylistFilterModel::setRows(QVector<int> rows) {
+    beginResetModel();
+    m_filtered = true;
+    m_rows = std::move(rows);
+    endResetModel();
+}
+
+void PlaylistFilterModel::clearFilter() {
+    if (!m_filtered) return;
+    beginResetModel();
+    m_filtered = false;
+    m_rows.clear();
+    m_rows.squeeze();
+    endResetModel();
+}
+
+int PlaylistFilterModel::proxyRow(int sourceRow) const {
+    if (!m_filtered) return sourceRow;
+    const auto it = std::lower_bound(m_rows.cbegin(), m_rows.cend(), sourceRow);
+    return it != m_rows.cend() && *it == sourceRow ? static_cast<int>(it - m_rows.cbegin()) : -1;
+}
+
+QModelIndex PlaylistFilterModel::mapToSource(const QModelIndex &proxyIndex) const {
+    if (!proxyIndex.isValid() || !sourceModel()) return {};
+    const int row = m_filtered ? m_rows.value(proxyIndex.row(), -1) : proxyIndex.row();
+    return row < 0 ? QModelIndex() : sourceModel()->index(row, 0);
+}
+
+QModelIndex PlaylistFilterModel::mapFromSource(const QModelIndex &sourceIndex) const {
+    if (!sourceIndex.isValid()) return {};
+    const int row = proxyRow(sourceIndex.row());
+    return row < 0 ? QModelIndex() : index(row, 0);
+}
+
+QModelIndex PlaylistFilterModel::index(int row, int column, const QModelIndex &parent) const {
+    if (parent.isValid() || column != 0 || row < 0 || row >= rowCount()) return {};
+    return createIndex(row, column);
+}
+
+QModelIndex PlaylistFilterModel::parent(const QModelIndex &) const {
+    return {};
+}
+
+int PlaylistFilterModel::rowCount(const QModelIndex &parent) const {
+    if (parent.isValid() || !sourceModel()) return 0;
+    return m_filtered ? static_cast<int>(m_rows.size()) : sourceModel()->rowCount();
+}
+
+int PlaylistFilterModel::columnCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : 1;
+}
+
+// 繪製單列
+void PlaylistDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const {
+    const bool nowPlaying = index.data(PlaylistModel::NowPlayingRole).toBool();
+    const bool duplicate = !index.data(PlaylistModel::DuplicateRole).toString().isEmpty();
+    const bool unplayable = !index.data(PlaylistModel::UnplayableRole).toString().isEmpty();
+    const bool hovered = option.state & QStyle::State_MouseOver;
+    const bool selected = option.state & QStyle::State_Selected;
+
+    painter->save();
+    // 樣式表把選取背景設為透明，選取列在這裡畫（與播放中同一個藍色）
+    if (selected) {
+        painter->fillRect(option.rect, QColor(0x5C, 0xC8, 0xFF, hovered ? 70 : 50));
+        painter->fillRect(QRect(option.rect.left(), option.rect.top(), 3, option.rect.height()), QColor(0x5C, 0xC8, 0xFF));
+    } else if (hovered) {
+        painter->fillRect(option.rect, QColor(255, 255, 255, 20));
+    }
+
+    QFont f = option.font;
+    f.setBold(nowPlaying);
+    f.setItalic(duplicate);
+    f.setStrikeOut(unplayable);
+    painter->setFont(f);
+    painter->setPen(nowPlaying   ? QColor(0x5C, 0xC8, 0xFF)
+                    : unplayable ? QColor(0xD0, 0x60, 0x60)
+                    : duplicate  ? QColor(0x88, 0x88, 0x88)
+                                 : option.palette.color(QPalette::Text));
+
+    QRect textRect = option.rect.adjusted(6, 0, -6, 0);
+
+    // 右側顯示長度
+    if (const qint64 ms = index.data(PlaylistModel::DurationRole).toLongLong(); ms > 0) {
+        const qint64 sec = ms / 1000;
+        const QString dur = sec >= 3600
+                                ? QString("%1:%2:%3").arg(sec / 3600).arg(sec % 3600 / 60, 2, 10, QLatin1Char('0'))
+                                .arg(sec % 60, 2, 10, QLatin1Char('0'))
+                                : QString("%1:%2").arg(sec / 60).arg(sec % 60, 2, 10, QLatin1Char('0'));
+        const int w = QFontMetrics(f).horizontalAdvance(dur);
+        painter->save();
+        painter->setPen(QColor(0x88, 0x88, 0x88));
+        painter->drawText(textRect, Qt::AlignVCenter | Qt::AlignRight, dur);
+        painter->restore();
+        textRect.setRight(textRect.right() - w - 12);
+    }
+
+    const QString text = QFontMetrics(f).elidedText(index.data(Qt::DisplayRole).toString(), Qt::ElideRight,
+                                                    textRect.width());
+    painter->drawText(textRect, Qt::AlignVCenter | Qt::AlignLeft, text);
+    painter->restore();
+}
+
+// 固定列高（搭配 uniformItemSizes 避免逐列量測）
+QSize PlaylistDelegate::sizeHint(const QStyleOptionViewItem &option, const QModelIndex &) const {
+    return {option.rect.width(), QFontMetrics(option.font).height() + 6};
+}
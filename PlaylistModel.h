@@ -0,0 +1,182 @@
+#pragma once
+#include <QAbstractListModel>
+#include <QAbstractProxyModel>
+#include <QHash>
+#include <QStyledItemDelegate>
+#include <QVector>
+#include <QUrl>
+#include <memory>
+#include "PlaylistPaths.h"
+#include "TrackStore.h"
+
+class MetadataIndex;
+class SessionSnapshot;
+
+// 播放清單模型（取代 QListWidget）：路徑存在 TrackStore，取用時才組成 QUrl
+class PlaylistModel final : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    enum Roles {
+        UrlRole = Qt::UserRole + 1,
+        NowPlayingRole,
+        DurationRole,
+        DuplicateRole, // 內容相同的較早檔案；不是重複時為空字串
+        UnplayableRole // 匯入時判定無法播放的原因；可以播放時為空字串
+    };
+
+    explicit PlaylistModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    QVariant data(const QModelIndex &index, int role) const override;
+
+    // 拖曳：列可拖動，拖出時帶本機檔案的 URL
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+
+    Qt::DropActions supportedDragActions() const override;
+
+    QStringList mimeTypes() const override;
+
+    QMimeData *mimeData(const QModelIndexList &indexes) const override;
+
+    int count() const { return m_tracks.count(); }
+
+    bool isEmpty() const { return m_tracks.isEmpty(); }
+
+    // 每次呼叫都重新組成，交給播放器時才用；只要路徑時用 localFile()/path()
+    QUrl url(int row) const;
+
+    // 非本機檔案時為空字串
+    QString localFile(int row) const;
+
+    // 本機路徑；非本機時為完整 URL
+    QString path(int row) const;
+
+    // 整份清單（會先取出仍在快照中的列）；複製只增加參考計數，可交給背景執行緒
+    const TrackStore &tracks() const;
+
+    // 只需要路徑時用：不取出快照中的列，走訪整份清單的背景工作用這個
+    PlaylistPaths paths() const { return {m_tracks, m_snapshot}; }
+
+    int indexOf(const QUrl &url) const;
+
+    // 依序取出 rows 各列（復原用）
+    TrackStore subset(const QVector<int> &rows) const;
+
+    // 記憶體用量（位元組）
+    qint64 memoryUsage() const { return m_tracks.memoryUsage(); }
+
+    // 一次 beginInsertRows/endInsertRows 加入整批
+    void append(const QList<QUrl> &urls);
+
+    void append(const TrackStore &tracks);
+
+    // 取代單列（檔案改名）
+    void setUrl(int row, const QUrl &url);
+
+    // 一次 O(n) 搬移套用每列的新位置：newRowOf[舊列] = 新列，-1 = 移除（大量移除與重新排序）
+    void remap(const QVector<int> &newRowOf, int count);
+
+    // 在升冪的最終列號 rows 插入 urls（復原移除）
+    void insertAt(const QVector<int> &rows, const TrackStore &tracks);
+
+    void clear();
+
+    // 以快照取代整份清單：只配置空的列，畫面或播放用到時才逐列轉換
+    void restore(std::shared_ptr<const SessionSnapshot> snapshot);
+
+    // 正在播放的列，O(1) 更新（只通知新舊兩列）
+    int nowPlaying() const { return m_nowPlaying; }
+
+    void setNowPlaying(int row);
+
+    // 曲目資訊來源（標籤與長度）
+    void setMetadataIndex(const MetadataIndex *index) { m_meta = index; }
+
+    // 索引有新資料時重繪（只有可見列會重新取值）
+    void refreshMetadata();
+
+    // 標記重複的檔案（paths[i] 與 originals[i] 內容相同）
+    void markDuplicates(const QStringList &paths, const QStringList &originals);
+
+    // 標記無法播放的檔案（reasons[i] 為 paths[i] 的原因）；以路徑為準，列還沒加入也可以先標記
+    void markUnplayable(const QStringList &paths, const QStringList &reasons);
+
+    QString unplayableReason(int row) const;
+
+signals:
+    // remap：列還沒搬動前發出，移除的列（newRowOf 為 -1）此時還讀得到
+    void rowsAboutToBeRemapped(const QVector<int> &newRowOf, int count);
+
+    // remap/insertAt：在 layoutAboutToBeChanged 與 layoutChanged 之間發出；沒有舊列對應的新列為插入的列
+    void rowsRemapped(const QVector<int> &newRowOf, int count);
+
+private:
+    void materializeAll() const;
+
+    QString displayName(int row) const;
+
+    // 列已換上（在 layoutAboutToBeChanged 之後）：以 layoutChanged 通知（列數可能改變），持久索引（選取、目前列）跟著搬移
+    void endRelayout(const QVector<int> &newRowOf);
+
+    mutable TrackStore m_tracks;
+    mutable std::shared_ptr<const SessionSnapshot> m_snapshot; // 還有未取出的列時保留映射
+    const MetadataIndex *m_meta = nullptr;
+    int m_nowPlaying = -1;
+    QHash<QString, QString> m_duplicates; // 本機路徑 → 較早的相同檔案
+    QHash<QString, QString> m_unplayable; // 本機路徑 → 原因（清單清空後仍保留，檔案沒變就還是壞的）
+};
+
+// 過濾後的檢視：只保存符合的來源列號（升冪），未過濾時直接對應
+class PlaylistFilterModel final : public QAbstractProxyModel {
+    Q_OBJECT
+
+public:
+    explicit PlaylistFilterModel(QObject *parent = nullptr);
+
+    void setSourceModel(QAbstractItemModel *source) override;
+
+    // 設定符合的列；clearFilter() 回到顯示全部
+    void setRows(QVector<int> rows);
+
+    void clearFilter();
+
+    bool isFiltered() const { return m_filtered; }
+
+    const QVector<int> &sourceRows() const { return m_rows; }
+
+    QModelIndex mapToSource(const QModelIndex &proxyIndex) const override;
+
+    QModelIndex mapFromSource(const QModelIndex &sourceIndex) const override;
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+
+    QModelIndex parent(const QModelIndex &child) const override;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+
+private:
+    int proxyRow(int sourceRow) const;
+
+    bool m_filtered = false;
+    QVector<int> m_rows;
+    int m_removeFirst = -1; // rowsAboutToBeRemoved 對應到的代理列範圍
+    int m_removeLast = -1;
+    QModelIndexList m_layoutFrom; // 來源重新排列前的持久索引與對應的來源列
+    QVector<int> m_layoutSource;
+};
+
+// 輕量繪製：只畫可見列，正在播放的列以粗體藍色顯示，重複的檔案以灰色斜體顯示，無法播放的加刪除線
+class PlaylistDelegate final : public QStyledItemDelegate {
+    Q_OBJECT
+
+public:
+    using QStyledItemDelegate::QStyledItemDelegate;
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+
+    QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+};
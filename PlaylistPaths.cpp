@@ -0,0 +1,19 @@
+#include "PlaylistPaths.h"
+#include "SessionSnapshot.h"
+
+PlaylistPaths::PlaylistPaths(TrackStore tracks, std::shared_ptr<const SessionSnapshot> snapshot)
+    : m_tracks(std::move(tracks)), m_snapshot(std::move(snapshot)) {
+}
+
+QString PlaylistPaths::localFile(int row) const {
+    if (const int p = m_tracks.pendingRow(row); p >= 0) return m_snapshot->url(p).toLocalFile();
+    return m_tracks.localFile(row);
+}
+
+QString PlaylistPaths::path(int row) const {
+    if (const int p = m_tracks.pendingRow(row); p >= 0) {
+        const QUrl u = m_snapshot->url(p);
+        return u.isLocalFile() ? u.toLocalFile() : u.toString();
+    }
+    return m_tracks.path(row);
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <QString>
+#include <memory>
+#include "TrackStore.h"
+
+class SessionSnapshot;
+
+// 播放清單的唯讀複本：仍在快照中的列取用時才從快照轉換，不會寫回模型。
+// 複製只增加參考計數，可交給背景執行緒走訪整份清單。
+class PlaylistPaths final {
+public:
+    PlaylistPaths() = default;
+
+    PlaylistPaths(TrackStore tracks, std::shared_ptr<const SessionSnapshot> snapshot);
+
+    int count() const { return m_tracks.count(); }
+
+    // 非本機檔案時為空字串
+    QString localFile(int row) const;
+
+    // 本機路徑；非本機時為完整 URL
+    QString path(int row) const;
+
+private:
+    TrackStore m_tracks;
+    std::shared_ptr<const SessionSnapshot> m_snapshot;
+};
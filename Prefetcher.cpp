@@ -0,0 +1,130 @@
+#include "Prefetcher.h"
+
+#include <QFile>
+#include <QThread>
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#endif
+
+namespace {
+    constexpr qint64 kChunk = 1 << 20; // 每次讀取量，之間檢查是否取消
+}
+
+Prefetcher::Prefetcher(QObject *parent)
+    : QObject(parent) {
+    m_pool.setMaxThreadCount(1);
+    m_pool.setThreadPriority(QThread::LowPriority);
+}
+
+Prefetcher::~Prefetcher() {
+    if (m_cancel) m_cancel->store(true);
+    m_pool.waitForDone();
+}
+
+void Prefetcher::setBudget(qint64 bytes) {
+    m_budget = std::max<qint64>(0, bytes);
+    if (m_budget == 0) {
+        if (m_cancel) m_cancel->store(true);
+        m_wanted.clear();
+        m_cache.clear();
+        m_used = 0;
+    } else {
+        // 預算縮小：從優先順序最低的開始釋放
+        for (auto it = m_wanted.crbegin(); it != m_wanted.crend() && m_used > m_budget; ++it) {
+            if (const auto c = m_cache.constFind(*it); c != m_cache.cend()) {
+                m_used -= c->size();
+                m_cache.erase(c);
+            }
+        }
+    }
+    m_skipped.clear();
+    startNext();
+    emit statsChanged();
+}
+
+void Prefetcher::setUpcoming(const QList<QUrl> &urls) {
+    if (m_budget <= 0) return;
+    QStringList wanted;
+    for (const QUrl &url: urls) {
+        if (url.isLocalFile() && !wanted.contains(url.toLocalFile())) wanted.push_back(url.toLocalFile());
+    }
+    if (wanted == m_wanted) return;
+    m_wanted = wanted;
+    m_skipped.clear();
+
+    for (auto it = m_cache.begin(); it != m_cache.end();) {
+        if (m_wanted.contains(it.key())) {
+            ++it;
+        } else {
+            m_used -= it->size();
+            it = m_cache.erase(it);
+        }
+    }
+    if (!m_loading.isEmpty() && !m_wanted.contains(m_loading)) m_cancel->store(true); // 使用者跳到別處
+    startNext();
+    emit statsChanged();
+}
+
+QByteArray Prefetcher::acquire(const QUrl &url) {
+    if (m_budget <= 0 || !url.isLocalFile()) return {};
+    const auto it = m_cache.constFind(url.toLocalFile());
+    if (it != m_cache.cend()) ++m_hits;
+    else ++m_misses;
+    emit statsChanged();
+    return it != m_cache.cend() ? *it : QByteArray();
+}
+
+Prefetcher::Stats Prefetcher::stats() const {
+    return {m_hits, m_misses, m_used, m_budget, static_cast<int>(m_cache.size())};
+}
+
+// 一次只讀一個檔案，依優先順序
+void Prefetcher::startNext() {
+    if (m_budget <= 0 || !m_loading.isEmpty()) return;
+    for (const QString &path: std::as_const(m_wanted)) {
+        if (m_cache.contains(path) || m_skipped.contains(path)) continue;
+
+        m_loading = path;
+        m_cancel = std::make_shared<std::atomic<bool>>(false);
+        const qint64 room = m_budget - m_used;
+        m_pool.start([this, path, room, cancel = m_cancel] {
+            QByteArray data;
+            bool tooLarge = false;
+            QFile f(path);
+            if (f.open(QIODevice::ReadOnly)) {
+                const qint64 size = f.size();
+                tooLarge = size > room;
+                if (!tooLarge && size > 0) {
+#ifdef Q_OS_LINUX
+                    posix_fadvise(f.handle(), 0, 0, POSIX_FADV_SEQUENTIAL); // 加大核心預讀
+#endif
+                    data.resize(size);
+                    qint64 done = 0;
+                    while (done < size && !cancel->load(std::memory_order_relaxed)) {
+                        const qint64 n = f.read(data.data() + done, std::min(kChunk, size - done));
+                        if (n <= 0) break;
+                        done += n;
+                    }
+                    if (done != size) data.clear();
+                }
+            }
+            QMetaObject::invokeMethod(this, [this, path, data, tooLarge] { onLoaded(path, data, tooLarge); });
+        });
+        return;
+    }
+}
+
+void Prefetcher::onLoaded(const QString &path, const QByteArray &data, bool tooLarge) {
+    const bool canceled = m_cancel->load();
+    m_loading.clear();
+    if (m_wanted.contains(path) && !canceled) {
+        if (!data.isEmpty() && !tooLarge && m_used + data.size() <= m_budget) {
+            m_cache.insert(path, data);
+            m_used += data.size();
+        } else {
+            m_skipped.insert(path);
+        }
+    }
+    startNext();
+    emit statsChanged();
+}
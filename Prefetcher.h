@@ -0,0 +1,66 @@
+#pragma once
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QThreadPool>
+#include <QUrl>
+#include <atomic>
+#include <memory>
+
+// 預讀：播放時在背景把接下來的曲目整個讀進記憶體（總量受預算限制）
+//
+// 命中時播放器直接從記憶體開啟，不必等慢速磁碟或網路掛載的第一次讀取；
+// 同時也暖了作業系統的快取，不經過記憶體緩衝的路徑（PCM 引擎）一樣受益。
+class Prefetcher final : public QObject {
+    Q_OBJECT
+
+public:
+    struct Stats {
+        quint64 hits = 0;
+        quint64 misses = 0;
+        qint64 usedBytes = 0;
+        qint64 budgetBytes = 0;
+        int cached = 0;
+    };
+
+    explicit Prefetcher(QObject *parent = nullptr);
+
+    ~Prefetcher() override;
+
+    // 0 = 關閉並釋放所有緩衝
+    void setBudget(qint64 bytes);
+
+    qint64 budget() const { return m_budget; }
+
+    // 依優先順序給出接下來可能播放的曲目；不在其中的緩衝立即釋放
+    void setUpcoming(const QList<QUrl> &urls);
+
+    // 開始播放前查詢：已完整載入時回傳內容（隱式共用，不複製），並計入命中/未命中
+    QByteArray acquire(const QUrl &url);
+
+    Stats stats() const;
+
+signals:
+    void statsChanged();
+
+private:
+    void startNext();
+
+    void onLoaded(const QString &path, const QByteArray &data, bool tooLarge);
+
+    QThreadPool m_pool; // 單一執行緒：旋轉式硬碟上循序讀取最快
+    qint64 m_budget = 0;
+
+    QStringList m_wanted; // 依優先順序
+    QHash<QString, QByteArray> m_cache;
+    qint64 m_used = 0;
+    QSet<QString> m_skipped; // 超過剩餘預算或讀取失敗，這一輪不再嘗試
+
+    QString m_loading;
+    std::shared_ptr<std::atomic<bool>> m_cancel;
+
+    quint64 m_hits = 0;
+    quint64 m_misses = 0;
+};
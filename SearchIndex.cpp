@@ -0,0 +1,325 @@
+#include "SearchIndex.h"
+#include "MetadataIndex.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <algorithm>
+#include <iterator>
+#include <memory>
+
+namespace {
+    constexpr int kMaxGram = 3;
+
+    // n 個位元組（1–3）的 posting 鍵；最高位元組放 n，不同長度不會撞在一起
+    quint32 gramAt(const char *p, int n) {
+        quint32 k = 0;
+        for (int i = 0; i < n; ++i) k = (k << 8) | uchar(p[i]);
+        return (quint32(n) << 24) | k;
+    }
+
+    const char *readVarint(const char *p, quint32 &v) {
+        v = 0;
+        int shift = 0;
+        while (true) {
+            const uchar b = uchar(*p++);
+            v |= quint32(b & 0x7F) << shift;
+            if (!(b & 0x80)) return p;
+            shift += 7;
+        }
+    }
+}
+
+SearchIndex::SearchIndex(QObject *parent)
+    : QObject(parent) {
+    m_pool.setMaxThreadCount(1);
+}
+
+SearchIndex::~SearchIndex() {
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+QByteArray SearchIndex::normalize(const QString &s) {
+    return s.toCaseFolded().toUtf8();
+}
+
+QString SearchIndex::searchKey(const QString &path, const MetadataIndex *meta) {
+    const QFileInfo fi(path);
+    QString key = fi.completeBaseName() + ' ' + fi.dir().dirName();
+    if (meta) {
+        if (const auto info = meta->find(path)) key += ' ' + info->title + ' ' + info->artist + ' ' + info->album;
+    }
+    return key;
+}
+
+void SearchIndex::push(Posting &p, quint32 id) {
+    quint32 delta = p.count == 0 ? id : id - p.last;
+    while (delta >= 0x80) {
+        p.data.append(char((delta & 0x7F) | 0x80));
+        delta >>= 7;
+    }
+    p.data.append(char(delta));
+    p.last = id;
+    ++p.count;
+}
+
+// 把一個鍵的所有 1–3 bytes 片段加入（同一鍵內重複的只記一次）
+void SearchIndex::addKey(Postings &postings, quint32 id, const char *key, qsizetype len) {
+    for (int n = 1; n <= kMaxGram; ++n) {
+        for (qsizetype i = 0; i + n <= len; ++i) {
+            Posting &p = postings[gramAt(key + i, n)];
+            if (p.count > 0 && p.last == id) continue;
+            push(p, id);
+        }
+    }
+}
+
+void SearchIndex::addRow(Built &built, quint32 id, const QString &path, const MetadataIndex *meta) {
+    const qsizetype start = built.arena.size();
+    built.arena.append(normalize(searchKey(path, meta)));
+    built.offsets.push_back(static_cast<quint32>(built.arena.size()));
+    addKey(built.postings, id, built.arena.constData() + start, built.arena.size() - start);
+    built.idsOfPath.insert(hashPath(path), id);
+}
+
+QVector<quint32> SearchIndex::decode(const Posting &p) {
+    QVector<quint32> ids;
+    ids.reserve(p.count);
+    const char *c = p.data.constData();
+    quint32 cur = 0;
+    for (quint32 i = 0; i < p.count; ++i) {
+        quint32 d;
+        c = readVarint(c, d);
+        cur = i == 0 ? d : cur + d;
+        ids.push_back(cur);
+    }
+    return ids;
+}
+
+QByteArrayView SearchIndex::keyOf(quint32 id) const {
+    return QByteArrayView(m_arena.constData() + m_offsets[id], m_offsets[id + 1] - m_offsets[id]);
+}
+
+void SearchIndex::invalidateQuery() {
+    m_lastQuery.clear();
+    m_lastIds.clear();
+}
+
+// 新增一批：先配置 id，鍵值（需讀標籤）與 posting 都在背景建立後併入
+void SearchIndex::append(const QStringList &paths, const MetadataIndex *meta) {
+    if (paths.isEmpty()) return;
+    ++m_structureGen;
+    invalidateQuery();
+
+    const auto firstId = static_cast<quint32>(m_rowOfId.size());
+    for (qsizetype i = 0; i < paths.size(); ++i) {
+        m_rowOfId.push_back(static_cast<int>(m_idOfRow.size()));
+        m_idOfRow.push_back(firstId + static_cast<quint32>(i));
+    }
+
+    const quint64 gen = m_resetGen;
+    m_pool.start([this, paths, meta, firstId, gen] {
+        auto built = std::make_shared<Built>();
+        built->offsets.reserve(paths.size() + 1);
+        built->offsets.push_back(0);
+        for (qsizetype i = 0; i < paths.size(); ++i) addRow(*built, firstId + static_cast<quint32>(i), paths[i], meta);
+
+        QMetaObject::invokeMethod(this, [this, built, firstId, gen] {
+            if (gen != m_resetGen || firstId != keyed()) return;
+            // 併入：id 遞增，鍵值與 posting 都直接接在後面
+            const auto base = static_cast<quint32>(m_arena.size());
+            m_arena.append(built->arena);
+            for (qsizetype i = 1; i < built->offsets.size(); ++i) m_offsets.push_back(base + built->offsets[i]);
+            for (auto it = built->postings.cbegin(); it != built->postings.cend(); ++it) {
+                Posting &dst = m_postings[it.key()];
+                for (const quint32 id: decode(it.value())) push(dst, id);
+            }
+            m_idsOfPath.unite(built->idsOfPath);
+            invalidateQuery();
+            emit ready();
+        }, Qt::QueuedConnection);
+    });
+}
+
+// 插入的列先照常接在尾端，再和其他列一起搬到新位置（只改列號對應，鍵值不動）
+void SearchIndex::remapRows(const QVector<int> &newRowOf, int count, const QStringList &insertedPaths,
+                            const MetadataIndex *meta) {
+    const qsizetype oldCount = std::min(m_idOfRow.size(), newRowOf.size());
+    append(insertedPaths, meta);
+    ++m_structureGen;
+    invalidateQuery();
+
+    QVector<quint32> idOfRow(count);
+    QVector<bool> filled(count, false);
+    for (qsizetype r = 0; r < oldCount; ++r) {
+        if (const int n = newRowOf[r]; n >= 0 && n < count) {
+            idOfRow[n] = m_idOfRow[r];
+            filled[n] = true;
+        } else {
+            m_rowOfId[m_idOfRow[r]] = -1;
+        }
+    }
+    qsizetype next = m_idOfRow.size() - insertedPaths.size();
+    for (int n = 0; n < count; ++n) {
+        if (!filled[n]) {
+            if (next == m_idOfRow.size()) continue;
+            idOfRow[n] = m_idOfRow[next++];
+        }
+        m_rowOfId[idOfRow[n]] = n;
+    }
+    m_idOfRow = std::move(idOfRow);
+}
+
+void SearchIndex::clear() {
+    ++m_resetGen;
+    ++m_structureGen;
+    invalidateQuery();
+    m_arena.clear();
+    m_offsets = {0};
+    m_postings.clear();
+    m_idsOfPath.clear();
+    m_rowOfId.clear();
+    m_idOfRow.clear();
+}
+
+void SearchIndex::invalidate() {
+    ++m_structureGen;
+    invalidateQuery();
+}
+
+QVector<int> SearchIndex::rowsOf(const QString &path) const {
+    QVector<int> rows;
+    for (auto [it, end] = m_idsOfPath.equal_range(hashPath(path)); it != end; ++it) {
+        if (*it < m_rowOfId.size() && alive(*it)) rows.push_back(m_rowOfId[*it]);
+    }
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
+void SearchIndex::renameRow(int row, const QString &from, const QString &to) {
+    if (row < 0 || row >= m_idOfRow.size()) return;
+    const quint32 id = m_idOfRow[row];
+    if (id >= keyed()) return; // 還在背景建立：批次用的是改名前的路徑，等重建
+    m_idsOfPath.remove(hashPath(from), id);
+    m_idsOfPath.insert(hashPath(to), id);
+}
+
+// 背景重建（例如標籤更新後）
+void SearchIndex::rebuild(const PlaylistPaths &tracks, const MetadataIndex *meta) {
+    const quint64 structureGen = m_structureGen;
+    m_pool.start([this, tracks, meta, structureGen] {
+        auto built = std::make_shared<Built>();
+        built->offsets.reserve(tracks.count() + 1);
+        built->offsets.push_back(0);
+        for (int row = 0; row < tracks.count(); ++row) addRow(*built, static_cast<quint32>(row), tracks.path(row), meta);
+
+        QMetaObject::invokeMethod(this, [this, built, structureGen] {
+            if (structureGen != m_structureGen) return; // 期間清單有變動，結果作廢
+            ++m_resetGen;
+            m_arena = std::move(built->arena);
+            m_offsets = std::move(built->offsets);
+            m_postings = std::move(built->postings);
+            m_idsOfPath = std::move(built->idsOfPath);
+            m_rowOfId.resize(keyed());
+            m_idOfRow.resize(keyed());
+            for (quint32 i = 0; i < keyed(); ++i) {
+                m_rowOfId[i] = static_cast<int>(i);
+                m_idOfRow[i] = i;
+            }
+            invalidateQuery();
+            emit ready();
+        }, Qt::QueuedConnection);
+    });
+}
+
+// 交集：從最短的 posting 開始；詞不超過 3 bytes 時只有一串，結果就是精確的
+QVector<quint32> SearchIndex::candidates(const QByteArray &term) const {
+    const int n = static_cast<int>(std::min<qsizetype>(term.size(), kMaxGram));
+    QVector<const Posting *> lists;
+    for (qsizetype i = 0; i + n <= term.size(); ++i) {
+        const auto it = m_postings.constFind(gramAt(term.constData() + i, n));
+        if (it == m_postings.cend()) return {};
+        if (!lists.contains(&it.value())) lists.push_back(&it.value());
+    }
+    std::sort(lists.begin(), lists.end(), [](const Posting *a, const Posting *b) { return a->count < b->count; });
+
+    QVector<quint32> result = decode(*lists.front());
+    for (qsizetype l = 1; l < lists.size() && !result.isEmpty(); ++l) {
+        const Posting &p = *lists[l];
+        const char *c = p.data.constData();
+        quint32 cur = 0;
+        qsizetype w = 0;
+        qsizetype r = 0;
+        for (quint32 i = 0; i < p.count && r < result.size(); ++i) {
+            quint32 d;
+            c = readVarint(c, d);
+            cur = i == 0 ? d : cur + d;
+            while (r < result.size() && result[r] < cur) ++r;
+            if (r < result.size() && result[r] == cur) result[w++] = result[r++];
+        }
+        result.resize(w);
+    }
+    return result;
+}
+
+// 查詢
+QVector<int> SearchIndex::query(const QString &text) {
+    const QByteArray q = normalize(text).simplified();
+    if (q.isEmpty()) return {};
+    const QList<QByteArray> terms = q.split(' ');
+
+    // 每個詞都不超過 3 bytes 時 posting 的交集就是答案，不必讀鍵值
+    const bool exact = std::ranges::all_of(terms, [](const QByteArray &t) { return t.size() <= kMaxGram; });
+
+    QVector<quint32> ids;
+    if (!exact && !m_lastQuery.isEmpty() && q.startsWith(m_lastQuery)) {
+        ids = m_lastIds; // 結果必為上次的子集
+    } else {
+        // 從最長的詞開始（posting 通常最短）；其他詞只在 exact 時交集，否則留給驗證
+        QList<QByteArray> order = terms;
+        std::sort(order.begin(), order.end(), [](const QByteArray &a, const QByteArray &b) { return a.size() > b.size(); });
+        ids = candidates(order.front());
+        for (qsizetype t = 1; exact && t < order.size() && !ids.isEmpty(); ++t) {
+            const QVector<quint32> other = candidates(order[t]);
+            QVector<quint32> both;
+            std::ranges::set_intersection(ids, other, std::back_inserter(both));
+            ids = std::move(both);
+        }
+    }
+
+    // 驗證完整子字串（exact 時只濾掉移除的 id）
+    QVector<quint32> matched;
+    for (const quint32 id: std::as_const(ids)) {
+        if (!alive(id)) continue;
+        bool ok = true;
+        if (!exact) {
+            const QByteArrayView key = keyOf(id);
+            for (const QByteArray &t: terms) {
+                if (!key.contains(t)) {
+                    ok = false;
+                    break;
+                }
+            }
+        }
+        if (ok) matched.push_back(id);
+    }
+
+    m_lastQuery = q;
+    m_lastIds = matched;
+
+    QVector<int> rows;
+    rows.reserve(matched.size());
+    for (const quint32 id: std::as_const(matched)) rows.push_back(m_rowOfId[id]);
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
+// FNV-1a（與 MetadataIndex 相同）
+quint64 SearchIndex::hashPath(const QString &path) {
+    quint64 h = 14695981039346656037ULL;
+    for (const QChar c: path) {
+        h ^= c.unicode();
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
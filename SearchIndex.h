@@ -0,0 +1,121 @@
+#pragma once
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QThreadPool>
+#include <QUrl>
+#include <QVector>
+#include "PlaylistPaths.h"
+
+class MetadataIndex;
+
+// 播放清單的 n-gram 索引，支援逐字輸入過濾
+//
+// 每列有一個內部 id；鍵值以小寫 UTF-8 連續存放，
+// 每個 1、2、3 bytes 的片段對應一串遞增 id（差值以 varint 壓縮）。
+// 短於 3 bytes 的詞直接查單字元/雙字元的 posting（打字的頭一兩個字不必逐一比對鍵值），
+// 代價是 posting 約為只有 trigram 時的兩倍多。
+// 新增的批次在背景讀標籤、建立鍵值與 posting 後併入，併入前查不到這些列。
+// 另外以路徑雜湊對應到 id，讓檔案事件與重複檔案不必走訪整份清單就能找到列。
+//
+// 限制：
+// - 移除只標記 id 失效，鍵值與 posting 留在原處，直到 clear 或 rebuild 才回收
+class SearchIndex final : public QObject {
+    Q_OBJECT
+
+public:
+    explicit SearchIndex(QObject *parent = nullptr);
+
+    ~SearchIndex() override;
+
+    // 列尾加入（paths 與新增列一一對應）
+    void append(const QStringList &paths, const MetadataIndex *meta);
+
+    // 大量移除/重新排序：newRowOf[舊列] = 新列（-1 = 移除）；沒有舊列對應的新列依序使用 insertedPaths
+    void remapRows(const QVector<int> &newRowOf, int count, const QStringList &insertedPaths,
+                   const MetadataIndex *meta);
+
+    void clear();
+
+    // 清單變了但索引沒有跟上（還原後尚未重建）：作廢進行中的重建，等下一次 rebuild
+    void invalidate();
+
+    // 索引涵蓋全部 rowCount 列且都已併入（rowsOf 的結果完整）
+    bool isComplete(int rowCount) const { return size() == rowCount && keyed() == m_rowOfId.size(); }
+
+    // 路徑雜湊相同的列（升冪）；可能含雜湊碰撞或改名前的路徑，呼叫端要再比對
+    QVector<int> rowsOf(const QString &path) const;
+
+    // 單列改名（不重建鍵值，只更新路徑對應）
+    void renameRow(int row, const QString &from, const QString &to);
+
+    // 標籤變更後在背景整個重建，完成後替換（期間舊索引仍可查詢）
+    void rebuild(const PlaylistPaths &tracks, const MetadataIndex *meta);
+
+    // 以空白分隔的每個詞都必須出現（不分大小寫），回傳升冪排序的列號
+    QVector<int> query(const QString &text);
+
+    int size() const { return static_cast<int>(m_idOfRow.size()); }
+
+    // 列的搜尋鍵：檔名、所在資料夾與標籤；path 為本機路徑或完整 URL
+    static QString searchKey(const QString &path, const MetadataIndex *meta);
+
+signals:
+    // 背景工作完成（過濾結果可能改變）
+    void ready();
+
+private:
+    struct Posting {
+        QByteArray data; // varint 差值
+        quint32 last = 0;
+        quint32 count = 0;
+    };
+
+    using Postings = QHash<quint32, Posting>;
+
+    struct Built {
+        QByteArray arena;
+        QVector<quint32> offsets;
+        Postings postings;
+        QMultiHash<quint64, quint32> idsOfPath;
+    };
+
+    static QByteArray normalize(const QString &s);
+
+    // 把一列的鍵值與 n-gram 加到 built（id 需遞增）
+    static void addRow(Built &built, quint32 id, const QString &path, const MetadataIndex *meta);
+
+    static void addKey(Postings &postings, quint32 id, const char *key, qsizetype len);
+
+    static void push(Posting &p, quint32 id);
+
+    static QVector<quint32> decode(const Posting &p);
+
+    static quint64 hashPath(const QString &path);
+
+    QByteArrayView keyOf(quint32 id) const;
+
+    quint32 keyed() const { return static_cast<quint32>(m_offsets.size() - 1); }
+
+    bool alive(quint32 id) const { return m_rowOfId[id] >= 0; }
+
+    QVector<quint32> candidates(const QByteArray &term) const;
+
+    void invalidateQuery();
+
+    QByteArray m_arena; // 所有鍵值
+    QVector<quint32> m_offsets{0}; // id → [offsets[id], offsets[id + 1])；keyed() 之後的 id 仍在背景建立
+    Postings m_postings;
+    QMultiHash<quint64, quint32> m_idsOfPath; // 路徑雜湊 → id（移除的 id 留到重建）
+
+    QVector<int> m_rowOfId; // -1 = 已移除
+    QVector<quint32> m_idOfRow;
+
+    QThreadPool m_pool; // 單一執行緒：批次依序完成
+    quint64 m_resetGen = 0; // clear/rebuild 後丟棄過期批次
+    quint64 m_structureGen = 0; // 新增/移除後丟棄過期的重建
+
+    // 逐字輸入：新查詢以上一次為前綴時，只需重新比對上次結果
+    QByteArray m_lastQuery;
+    QVector<quint32> m_lastIds;
+};
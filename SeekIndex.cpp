@@ -0,0 +1,496 @@
+#include "SeekIndex.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThread>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    constexpr char kMagic[4] = {'M', 'P', 'S', 'K'};
+    constexpr quint32 kVersion = 1;
+    constexpr int kMaxRecent = 16;
+    constexpr int kMaxTags = 4; // 連續的 ID3 標籤
+    constexpr qint64 kHeadBytes = 8192; // 第一幀（Xing/VBRI）最長不到 2 KB
+    constexpr qint64 kMaxResync = 64 * 1024; // 連續這麼多位元組都不是幀就當作串流結束
+
+    struct Header {
+        char magic[4];
+        quint32 version;
+        qint64 size;
+        qint64 mtime;
+        qint32 sampleRate;
+        qint32 frameSamples;
+        qint64 leadIn;
+        qint64 totalSamples;
+        qint64 dataEnd;
+        qint64 count;
+    };
+
+    struct Frame {
+        int length = 0;
+        int samples = 0;
+        int sampleRate = 0;
+        quint32 key = 0; // 整個串流都不變的欄位
+    };
+
+    // 第一幀的 Xing/Info 或 VBRI 標頭
+    struct InfoFrame {
+        bool found = false;
+        qint64 frames = 0; // 音訊幀數（不含資訊幀）
+        qint64 bytes = 0;
+        qint64 leadIn = 0;
+        qint64 endPad = 0;
+        QVector<SeekTable::Point> toc; // offset 從資訊幀開頭起算
+    };
+
+    using Parser = bool (*)(const uchar *, Frame &);
+
+    quint32 be32(const uchar *p) {
+        return quint32(p[0]) << 24 | quint32(p[1]) << 16 | quint32(p[2]) << 8 | p[3];
+    }
+
+    // MPEG 音訊幀頭；free format（位元率索引 0）沒有固定幀長，不支援
+    bool parseMpeg(const uchar *p, Frame &f) {
+        static constexpr int kBitrates[5][15] = {
+            {0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448}, // MPEG 1 Layer I
+            {0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384}, // MPEG 1 Layer II
+            {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320}, // MPEG 1 Layer III
+            {0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256}, // MPEG 2/2.5 Layer I
+            {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160}, // MPEG 2/2.5 Layer II/III
+        };
+        static constexpr int kRates[3] = {44100, 48000, 32000};
+        if (p[0] != 0xFF || (p[1] & 0xE0) != 0xE0) return false;
+        const int version = (p[1] >> 3) & 3; // 3 = MPEG 1、2 = MPEG 2、0 = MPEG 2.5
+        const int layer = (p[1] >> 1) & 3; // 3 = Layer I、2 = II、1 = III
+        const int bitrateIndex = p[2] >> 4;
+        const int rateIndex = (p[2] >> 2) & 3;
+        if (version == 1 || layer == 0 || bitrateIndex == 0 || bitrateIndex == 15 || rateIndex == 3) return false;
+
+        const bool v1 = version == 3;
+        const int bitrate = kBitrates[v1 ? 3 - layer : (layer == 3 ? 3 : 4)][bitrateIndex] * 1000;
+        const int pad = (p[2] >> 1) & 1;
+        f.sampleRate = kRates[rateIndex] >> (v1 ? 0 : version == 2 ? 1 : 2);
+        if (layer == 3) {
+            f.samples = 384;
+            f.length = (12 * bitrate / f.sampleRate + pad) * 4;
+        } else {
+            f.samples = layer == 1 && !v1 ? 576 : 1152;
+            f.length = f.samples / 8 * bitrate / f.sampleRate + pad;
+        }
+        f.key = be32(p) & 0xFFFE0C00; // 同步、版本、layer、取樣率
+        return true;
+    }
+
+    // ADTS（AAC）幀頭：幀長直接寫在標頭裡
+    bool parseAdts(const uchar *p, Frame &f) {
+        static constexpr int kRates[13] = {96000, 88200, 64000, 48000, 44100, 32000, 24000, 22050, 16000, 12000, 11025,
+                                           8000, 7350};
+        if (p[0] != 0xFF || (p[1] & 0xF6) != 0xF0) return false;
+        const int rateIndex = (p[2] >> 2) & 0x0F;
+        if (rateIndex >= 13) return false;
+        f.length = ((p[3] & 0x03) << 11) | (p[4] << 3) | (p[5] >> 5);
+        if (f.length < 7) return false;
+        f.samples = 1024 * ((p[6] & 0x03) + 1);
+        f.sampleRate = kRates[rateIndex];
+        f.key = be32(p) & 0xFFFFFC00; // 同步、profile、取樣率
+        return true;
+    }
+
+    // ID3v2 標籤總長度（與 FormatSniffer 相同）；不是 ID3 時回傳 0
+    qint64 id3Size(const uchar *p, qint64 n) {
+        if (n < 10 || memcmp(p, "ID3", 3) != 0) return 0;
+        if ((p[6] | p[7] | p[8] | p[9]) & 0x80) return 0;
+        const qint64 size = (qint64(p[6]) << 21) | (qint64(p[7]) << 14) | (qint64(p[8]) << 7) | p[9];
+        return 10 + size + ((p[5] & 0x10) ? 10 : 0);
+    }
+
+    InfoFrame parseInfo(const uchar *p, qint64 n, const Frame &f) {
+        InfoFrame info;
+        const bool v1 = ((p[1] >> 3) & 3) == 3;
+        const bool mono = (p[3] >> 6) == 3;
+        const qint64 xing = v1 ? (mono ? 21 : 36) : (mono ? 13 : 21); // 幀頭 + side info 之後
+        if (xing + 8 <= n && (memcmp(p + xing, "Xing", 4) == 0 || memcmp(p + xing, "Info", 4) == 0)) {
+            info.found = true;
+            const quint32 flags = be32(p + xing + 4);
+            qint64 at = xing + 8;
+            if ((flags & 1) && at + 4 <= n) {
+                info.frames = be32(p + at);
+                at += 4;
+            }
+            if ((flags & 2) && at + 4 <= n) {
+                info.bytes = be32(p + at);
+                at += 4;
+            }
+            if ((flags & 4) && at + 100 <= n) {
+                // 目錄：第 i 個百分點在 toc[i] / 256 × 總位元組的位置
+                if (info.frames > 0 && info.bytes > 0) {
+                    info.toc.push_back({0, f.length});
+                    for (int i = 1; i < 100; ++i)
+                        info.toc.push_back({info.frames * f.samples * i / 100, info.bytes * p[at + i] / 256});
+                }
+                at += 100;
+            }
+            if (flags & 8) at += 4;
+            // LAME 標籤：編碼延遲與結尾補齊各 12 位；FFmpeg 會丟掉延遲 + 529（解碼延遲），結尾補齊扣掉同樣的 529
+            if (at + 24 <= n && (memcmp(p + at, "LAME", 4) == 0 || memcmp(p + at, "Lavf", 4) == 0
+                                 || memcmp(p + at, "Lavc", 4) == 0)) {
+                const int delay = (p[at + 21] << 4) | (p[at + 22] >> 4);
+                const int padding = ((p[at + 22] & 0x0F) << 8) | p[at + 23];
+                info.leadIn = delay + 529;
+                info.endPad = padding - 529;
+            }
+            return info;
+        }
+
+        constexpr qint64 vbri = 36; // 固定在幀頭 + 32 位元組之後
+        if (vbri + 26 <= n && memcmp(p + vbri, "VBRI", 4) == 0) {
+            info.found = true;
+            const auto be16 = [p](qint64 at) { return (int(p[at]) << 8) | p[at + 1]; };
+            info.bytes = be32(p + vbri + 10);
+            info.frames = be32(p + vbri + 14);
+            const int entries = be16(vbri + 18);
+            const int scale = be16(vbri + 20);
+            const int entryBytes = be16(vbri + 22);
+            const int framesPerEntry = be16(vbri + 24);
+            // 目錄：每 framesPerEntry 幀的位元組數
+            qint64 at = vbri + 26;
+            if (entryBytes >= 1 && entryBytes <= 4 && at + qint64(entries) * entryBytes <= n) {
+                qint64 offset = f.length;
+                info.toc.push_back({0, offset});
+                for (int i = 0; i + 1 < entries; ++i, at += entryBytes) {
+                    qint64 v = 0;
+                    for (int b = 0; b < entryBytes; ++b) v = (v << 8) | p[at + b];
+                    offset += v * scale;
+                    info.toc.push_back({qint64(i + 1) * framesPerEntry * f.samples, offset});
+                }
+            }
+        }
+        return info;
+    }
+
+    // FNV-1a（與 MetadataIndex 相同）
+    quint64 hashPath(const QString &path) {
+        quint64 h = 14695981039346656037ULL;
+        for (const QChar c: path) {
+            h ^= c.unicode();
+            h *= 1099511628211ULL;
+        }
+        return h;
+    }
+
+    // 檔案的一段當作從 0 開始的獨立裝置
+    class FileRange final : public QIODevice {
+    public:
+        FileRange(const QString &path, qint64 begin, qint64 end, QObject *parent)
+            : QIODevice(parent), m_file(path), m_begin(begin), m_end(end) {
+        }
+
+        bool open(OpenMode mode) override {
+            if ((mode & WriteOnly) || !m_file.open(QIODevice::ReadOnly)) return false;
+            m_end = std::min(m_end, m_file.size());
+            if (m_begin > m_end || !m_file.seek(m_begin)) return false;
+            return QIODevice::open(mode | Unbuffered);
+        }
+
+        void close() override {
+            m_file.close();
+            QIODevice::close();
+        }
+
+        bool isSequential() const override { return false; }
+
+        qint64 size() const override { return m_end - m_begin; }
+
+        bool seek(qint64 pos) override {
+            if (pos < 0 || pos > size() || !m_file.seek(m_begin + pos)) return false;
+            return QIODevice::seek(pos);
+        }
+
+    protected:
+        qint64 readData(char *data, qint64 maxlen) override {
+            const qint64 left = m_end - m_file.pos();
+            return left <= 0 ? -1 : m_file.read(data, std::min(maxlen, left));
+        }
+
+        qint64 writeData(const char *, qint64) override { return -1; }
+
+    private:
+        QFile m_file;
+        const qint64 m_begin;
+        qint64 m_end;
+    };
+}
+
+// 精確表：從目標前 kPrerollFrames 幀之前最近的點開始，多解的部分丟掉，落點準到 sample
+SeekTable::Target SeekTable::locate(qint64 ms) const {
+    if (isEmpty()) return {};
+    const qint64 want = std::clamp<qint64>(ms * sampleRate / 1000, 0, totalSamples) + leadIn;
+    const auto bySample = [](qint64 s, const Point &p) { return s < p.sample; };
+
+    if (!exact) {
+        // 目錄只有約 100 點：兩點之間依位元組內插，直接從那裡播（落點是近似值）
+        const auto hi = std::upper_bound(points.cbegin(), points.cend(), want, bySample);
+        const Point &lo = hi == points.cbegin() ? *hi : *(hi - 1);
+        qint64 offset = lo.offset;
+        if (hi != points.cbegin() && hi != points.cend() && hi->sample > lo.sample)
+            offset += (want - lo.sample) * (hi->offset - lo.offset) / (hi->sample - lo.sample);
+        return {offset, dataEnd, 0, sampleRate};
+    }
+
+    const qint64 from = std::max<qint64>(0, want - qint64(kPrerollFrames) * frameSamples);
+    auto it = std::upper_bound(points.cbegin(), points.cend(), from, bySample);
+    if (it != points.cbegin()) --it;
+    return {it->offset, dataEnd, want - it->sample, sampleRate};
+}
+
+SeekIndex::SeekIndex(QObject *parent)
+    : QObject(parent) {
+    // 只有目前曲目需要：單一執行緒，新請求取代舊的
+    m_pool.setMaxThreadCount(1);
+    m_pool.setThreadPriority(QThread::LowPriority);
+}
+
+SeekIndex::~SeekIndex() {
+    {
+        QMutexLocker lock(&m_lock);
+        if (m_cancel) *m_cancel = true;
+    }
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+QString SeekIndex::cacheDir() {
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/seekindex";
+    QDir().mkpath(dir);
+    return dir;
+}
+
+QString SeekIndex::fileFor(const QString &path) {
+    return cacheDir() + '/' + QString::number(hashPath(path), 16).rightJustified(16, '0') + ".sek";
+}
+
+std::optional<SeekTable> SeekIndex::request(const QString &path) {
+    if (path.isEmpty()) return std::nullopt;
+    {
+        QMutexLocker lock(&m_lock);
+        if (const auto it = m_recent.constFind(path); it != m_recent.cend() && it->exact) return *it;
+    }
+    if (auto table = load(path)) {
+        remember(path, *table);
+        return table;
+    }
+
+    // 掃描完成前先用目錄
+    const auto toc = readToc(path);
+    if (toc) remember(path, *toc);
+
+    auto cancel = std::make_shared<std::atomic<bool>>(false);
+    {
+        QMutexLocker lock(&m_lock);
+        if (m_scanning == path) return toc;
+        if (m_cancel) *m_cancel = true;
+        m_cancel = cancel;
+        m_scanning = path;
+    }
+    m_pool.clear();
+    m_pool.start([this, path, cancel] {
+        const auto table = scan(path, cancel.get());
+        {
+            QMutexLocker lock(&m_lock);
+            if (m_scanning == path) m_scanning.clear();
+        }
+        if (!table || *cancel) return;
+        store(path, *table);
+        remember(path, *table);
+        emit ready(path);
+    });
+    return toc;
+}
+
+std::optional<SeekTable> SeekIndex::cached(const QString &path) {
+    QMutexLocker lock(&m_lock);
+    if (const auto it = m_recent.constFind(path); it != m_recent.cend()) return *it;
+    return std::nullopt;
+}
+
+void SeekIndex::remember(const QString &path, const SeekTable &table) {
+    QMutexLocker lock(&m_lock);
+    if (m_recent.size() >= kMaxRecent) m_recent.clear();
+    m_recent.insert(path, table);
+}
+
+std::optional<SeekTable> SeekIndex::scan(const QString &path, const std::atomic<bool> *abort) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly) || file.size() <= 0) return std::nullopt;
+    const uchar *data = file.map(0, file.size()); // 只碰幀頭所在的頁
+    if (!data) return std::nullopt;
+    auto table = build(data, file.size(), abort);
+    file.unmap(const_cast<uchar *>(data));
+    return table;
+}
+
+// 逐幀前進：每幀只讀幀頭，長度由幀頭決定
+std::optional<SeekTable> SeekIndex::build(const uchar *data, qint64 size, const std::atomic<bool> *abort) {
+    qint64 pos = 0;
+    for (int i = 0; i < kMaxTags; ++i) {
+        const qint64 tag = id3Size(data + pos, size - pos);
+        if (tag == 0 || tag >= size - pos) break;
+        pos += tag;
+    }
+    while (pos < size && data[pos] == 0) ++pos;
+
+    Frame f;
+    Parser parse;
+    int headerBytes;
+    if (size - pos >= 7 && parseMpeg(data + pos, f)) {
+        parse = parseMpeg;
+        headerBytes = 4;
+    } else if (size - pos >= 7 && parseAdts(data + pos, f)) {
+        parse = parseAdts;
+        headerBytes = 7;
+    } else {
+        return std::nullopt;
+    }
+
+    SeekTable t;
+    t.sampleRate = f.sampleRate;
+    t.frameSamples = f.samples;
+    qint64 endPad = 0;
+    if (parse == parseMpeg) {
+        // 資訊幀不是音訊，解碼器從檔頭播放時也會跳過
+        if (const InfoFrame info = parseInfo(data + pos, std::min<qint64>(f.length, size - pos), f); info.found) {
+            t.leadIn = info.leadIn;
+            endPad = info.endPad;
+            pos += f.length;
+        }
+    }
+
+    // 只接受同一串流的幀；失去同步後要連下一幀也對得上才算找回來
+    const quint32 key = f.key;
+    const auto frameAt = [&](qint64 at, Frame &out) {
+        return at + headerBytes <= size && parse(data + at, out) && out.key == key && at + out.length <= size;
+    };
+    qint64 sample = 0;
+    qint64 frames = 0;
+    qint64 skipped = 0;
+    while (pos + headerBytes <= size) {
+        if ((frames & 0xFFF) == 0 && abort && abort->load(std::memory_order_relaxed)) return std::nullopt;
+        Frame cur, next;
+        bool ok = frameAt(pos, cur);
+        if (ok && skipped > 0) ok = pos + cur.length + headerBytes > size || frameAt(pos + cur.length, next);
+        if (!ok) {
+            if (size - pos >= 3 && memcmp(data + pos, "TAG", 3) == 0) break; // ID3v1
+            if (size - pos >= 8 && memcmp(data + pos, "APETAGEX", 8) == 0) break;
+            if (++skipped > kMaxResync) break;
+            ++pos;
+            continue;
+        }
+        skipped = 0;
+        if (frames % kStride == 0) t.points.push_back({sample, pos});
+        sample += cur.samples;
+        pos += cur.length;
+        t.dataEnd = pos;
+        ++frames;
+    }
+    if (t.points.isEmpty()) return std::nullopt;
+    t.totalSamples = std::clamp<qint64>(sample - t.leadIn - endPad, 0, sample);
+    t.exact = true;
+    return t;
+}
+
+std::optional<SeekTable> SeekIndex::readToc(const QString &path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return std::nullopt;
+    qint64 base = 0;
+    QByteArray head = file.read(kHeadBytes);
+    for (int i = 0; i < kMaxTags; ++i) {
+        const qint64 tag = id3Size(reinterpret_cast<const uchar *>(head.constData()), head.size());
+        if (tag == 0) break;
+        base += tag;
+        if (base >= file.size() || !file.seek(base)) return std::nullopt;
+        head = file.read(kHeadBytes);
+    }
+    qsizetype zeros = 0;
+    while (zeros < head.size() && head[zeros] == '\0') ++zeros;
+    base += zeros;
+
+    const auto *p = reinterpret_cast<const uchar *>(head.constData()) + zeros;
+    const qint64 n = head.size() - zeros;
+    Frame f;
+    if (n < 4 || !parseMpeg(p, f)) return std::nullopt;
+    const InfoFrame info = parseInfo(p, std::min<qint64>(f.length, n), f);
+    if (info.toc.size() < 2) return std::nullopt;
+
+    SeekTable t;
+    t.sampleRate = f.sampleRate;
+    t.frameSamples = f.samples;
+    t.leadIn = info.leadIn;
+    const qint64 raw = info.frames * f.samples;
+    t.totalSamples = std::clamp<qint64>(raw - info.leadIn - info.endPad, 0, raw);
+    t.dataEnd = info.bytes > 0 ? std::min(file.size(), base + info.bytes) : file.size();
+    t.points.reserve(info.toc.size());
+    for (const SeekTable::Point &pt: info.toc) {
+        if (pt.sample <= raw) t.points.push_back({pt.sample, base + pt.offset});
+    }
+    return t;
+}
+
+QIODevice *SeekIndex::openRange(const QString &path, qint64 begin, qint64 end, QObject *parent) {
+    auto *device = new FileRange(path, begin, end, parent);
+    if (device->open(QIODevice::ReadOnly)) return device;
+    delete device;
+    return nullptr;
+}
+
+std::optional<SeekTable> SeekIndex::load(const QString &path) {
+    const QFileInfo fi(path);
+    if (!fi.isFile()) return std::nullopt;
+
+    QFile f(fileFor(path));
+    if (!f.open(QIODevice::ReadOnly)) return std::nullopt;
+    Header h{};
+    if (f.read(reinterpret_cast<char *>(&h), sizeof(h)) != sizeof(h)) return std::nullopt;
+    if (memcmp(h.magic, kMagic, 4) != 0 || h.version != kVersion || h.size != fi.size() ||
+        h.mtime != fi.lastModified().toMSecsSinceEpoch() || h.count <= 0 || h.sampleRate <= 0 ||
+        f.size() != static_cast<qint64>(sizeof(Header)) + h.count * qint64(sizeof(SeekTable::Point)))
+        return std::nullopt;
+
+    SeekTable t;
+    t.sampleRate = h.sampleRate;
+    t.frameSamples = h.frameSamples;
+    t.leadIn = h.leadIn;
+    t.totalSamples = h.totalSamples;
+    t.dataEnd = h.dataEnd;
+    t.exact = true;
+    t.points.resize(h.count);
+    const qint64 bytes = h.count * qint64(sizeof(SeekTable::Point));
+    if (f.read(reinterpret_cast<char *>(t.points.data()), bytes) != bytes) return std::nullopt;
+    return t;
+}
+
+void SeekIndex::store(const QString &path, const SeekTable &table) {
+    const QFileInfo fi(path);
+    Header h{};
+    memcpy(h.magic, kMagic, 4);
+    h.version = kVersion;
+    h.size = fi.size();
+    h.mtime = fi.lastModified().toMSecsSinceEpoch();
+    h.sampleRate = table.sampleRate;
+    h.frameSamples = table.frameSamples;
+    h.leadIn = table.leadIn;
+    h.totalSamples = table.totalSamples;
+    h.dataEnd = table.dataEnd;
+    h.count = table.points.size();
+
+    QSaveFile out(fileFor(path));
+    if (!out.open(QIODevice::WriteOnly)) return;
+    out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+    out.write(reinterpret_cast<const char *>(table.points.constData()),
+              table.points.size() * qsizetype(sizeof(SeekTable::Point)));
+    out.commit();
+}
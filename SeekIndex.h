@@ -0,0 +1,99 @@
+#pragma once
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QThreadPool>
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include <optional>
+
+class QIODevice;
+
+// 幀串流（MPEG 音訊、ADTS）的跳轉表：解碼器可以從任何一幀開始，跳轉時只讀目標之前幾幀
+struct SeekTable {
+    struct Point {
+        qint64 sample; // 從第一個音訊幀起算（來源取樣率）
+        qint64 offset; // 該幀在檔案中的位置
+    };
+
+    // 從 offset 開始解碼到 end，丟掉開頭 skipSamples 個 sample 之後就是要求的位置
+    struct Target {
+        qint64 offset = -1;
+        qint64 end = 0;
+        qint64 skipSamples = 0;
+        int sampleRate = 0;
+
+        bool isValid() const { return offset >= 0 && sampleRate > 0; }
+
+        // 換算成輸出 frame（解碼器會重取樣）
+        qint64 skipFrames(int outputRate) const { return skipSamples * outputRate / sampleRate; }
+    };
+
+    static constexpr int kPrerollFrames = 4; // bit reservoir 與 MDCT 重疊：多解幾幀再丟掉
+
+    int sampleRate = 0;
+    int frameSamples = 0; // 每幀 sample 數
+    qint64 leadIn = 0; // 從檔頭播放時解碼器丟掉的 sample（LAME 標籤的編碼延遲 + 解碼延遲）
+    qint64 totalSamples = 0; // 播放長度（已扣掉 leadIn 與結尾補齊）
+    qint64 dataEnd = 0; // 最後一幀的結尾（之後是 ID3v1/APE 標籤）
+    bool exact = false; // 逐幀掃描所得；false 為 Xing/VBRI 目錄的近似值
+    QVector<Point> points; // sample 遞增
+
+    bool isEmpty() const { return points.isEmpty() || sampleRate <= 0; }
+
+    qint64 durationMs() const { return sampleRate > 0 ? totalSamples * 1000 / sampleRate : 0; }
+
+    Target locate(qint64 ms) const;
+};
+
+// 每首歌一張跳轉表：先用檔頭的 Xing/VBRI 目錄，背景逐幀掃描後換成精確表，
+// 並以每首一個小檔案快取在磁碟（路徑雜湊為檔名，大小 + 修改時間驗證）
+class SeekIndex final : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr int kStride = 16; // 每 16 幀一點（MP3 約 0.4 秒）
+
+    explicit SeekIndex(QObject *parent = nullptr);
+
+    ~SeekIndex() override;
+
+    // 有精確表就回傳；否則回傳目錄近似表（可能沒有）並排入背景掃描，完成後發出 ready
+    std::optional<SeekTable> request(const QString &path);
+
+    // 只查記憶體，不碰磁碟
+    std::optional<SeekTable> cached(const QString &path);
+
+    // 逐幀掃描整個檔案
+    static std::optional<SeekTable> scan(const QString &path, const std::atomic<bool> *abort = nullptr);
+
+    // data 為整個檔案的內容
+    static std::optional<SeekTable> build(const uchar *data, qint64 size, const std::atomic<bool> *abort = nullptr);
+
+    // 只讀檔頭：Xing 或 VBRI 目錄
+    static std::optional<SeekTable> readToc(const QString &path);
+
+    // 檔案的 [begin, end) 當作獨立的串流交給解碼器；開啟失敗回傳 nullptr
+    static QIODevice *openRange(const QString &path, qint64 begin, qint64 end, QObject *parent = nullptr);
+
+    static QString cacheDir();
+
+signals:
+    void ready(const QString &path);
+
+private:
+    static QString fileFor(const QString &path);
+
+    static std::optional<SeekTable> load(const QString &path);
+
+    static void store(const QString &path, const SeekTable &table);
+
+    void remember(const QString &path, const SeekTable &table);
+
+    QThreadPool m_pool;
+    QMutex m_lock;
+    std::shared_ptr<std::atomic<bool>> m_cancel; // 目前背景工作的取消旗標
+    QString m_scanning;
+    QHash<QString, SeekTable> m_recent; // 最近用過的，避免反覆讀檔
+};
@@ -0,0 +1,147 @@
+#include "SessionSnapshot.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    constexpr char kMagic[4] = {'M', 'P', 'S', 'S'};
+    constexpr quint32 kVersion = 1;
+}
+
+SessionSnapshot::~SessionSnapshot() {
+    if (m_map) m_file.unmap(const_cast<uchar *>(m_map));
+}
+
+QString SessionSnapshot::defaultPath() {
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dir);
+    return dir + "/session.bin";
+}
+
+// 映射快照：只檢查檔頭與表格範圍
+std::shared_ptr<const SessionSnapshot> SessionSnapshot::open(const QString &path) {
+    std::shared_ptr<SessionSnapshot> s(new SessionSnapshot);
+    s->m_file.setFileName(path.isEmpty() ? defaultPath() : path);
+    if (!s->m_file.open(QIODevice::ReadOnly)) return nullptr;
+    const qint64 size = s->m_file.size();
+    if (size < static_cast<qint64>(sizeof(Header))) return nullptr;
+
+    const uchar *map = s->m_file.map(0, size);
+    if (!map) return nullptr;
+    s->m_map = map;
+    s->m_mapSize = size;
+
+    Header &h = s->m_header;
+    memcpy(&h, map, sizeof(Header));
+    const qint64 dirsOff = sizeof(Header);
+    const qint64 entriesOff = dirsOff + static_cast<qint64>(h.dirCount) * sizeof(Dir);
+    const qint64 stringsOff = entriesOff + static_cast<qint64>(h.count) * sizeof(Entry);
+    if (memcmp(h.magic, kMagic, 4) != 0 || h.version != kVersion || h.count > INT_MAX || stringsOff > size) {
+        qWarning() << "session snapshot invalid, ignoring:" << s->m_file.fileName();
+        return nullptr;
+    }
+    s->m_dirs = reinterpret_cast<const Dir *>(map + dirsOff);
+    s->m_entries = reinterpret_cast<const Entry *>(map + entriesOff);
+    s->m_stringsOff = stringsOff;
+    return s;
+}
+
+int SessionSnapshot::count() const {
+    return static_cast<int>(m_header.count);
+}
+
+SessionSnapshot::State SessionSnapshot::state() const {
+    State st;
+    st.currentIndex = m_header.currentIndex < static_cast<qint32>(m_header.count) ? m_header.currentIndex : -1;
+    st.positionMs = std::max<qint64>(0, m_header.positionMs);
+    st.volume = std::isfinite(m_header.volume)
+                    ? static_cast<int>(std::lround(std::clamp(m_header.volume, 0.0f, 1.0f) * 100.0f))
+                    : 100;
+    st.muted = m_header.flags & kMuted;
+    return st;
+}
+
+QString SessionSnapshot::stringAt(quint32 off, quint32 len) const {
+    if (m_stringsOff + off + len > m_mapSize) return {};
+    return QString::fromUtf8(reinterpret_cast<const char *>(m_map + m_stringsOff + off), len);
+}
+
+QUrl SessionSnapshot::url(int row) const {
+    if (row < 0 || row >= count()) return {};
+    const Entry &e = m_entries[row];
+    if (e.dir == kNoDir) return QUrl(stringAt(e.off, e.len));
+    if (e.dir >= m_header.dirCount) return {};
+    const Dir &d = m_dirs[e.dir];
+    return QUrl::fromLocalFile(stringAt(d.off, d.len) + u'/' + stringAt(e.off, e.len));
+}
+
+// 清單本來就是目錄 + 檔名：直接複製 UTF-8，只寫出仍被引用的目錄
+bool SessionSnapshot::save(const TrackStore &tracks, const State &state, const QString &path) {
+    QVector<Dir> dirs;
+    QVector<Entry> entries;
+    QByteArray strings;
+    QVector<quint32> dirIndex(tracks.dirCount(), kNoDir);
+    entries.reserve(tracks.count());
+
+    auto addString = [&strings](QByteArrayView utf8) -> Dir {
+        const Dir d{static_cast<quint32>(strings.size()), static_cast<quint32>(utf8.size())};
+        strings.append(utf8);
+        return d;
+    };
+
+    for (int row = 0; row < tracks.count(); ++row) {
+        const quint32 dir = tracks.dirOf(row);
+        if (dir == TrackStore::kPending) return false; // 呼叫端要先取出快照中的列
+        const Dir name = addString(tracks.nameUtf8(row));
+        if (dir == TrackStore::kNoDir) {
+            entries.push_back({kNoDir, name.off, name.len});
+            continue;
+        }
+        if (dirIndex[dir] == kNoDir) {
+            dirIndex[dir] = static_cast<quint32>(dirs.size());
+            dirs.push_back(addString(tracks.dirUtf8(dir)));
+        }
+        entries.push_back({dirIndex[dir], name.off, name.len});
+    }
+    if (strings.size() > 0xFFFFFFFFLL) return false;
+
+    Header h{};
+    memcpy(h.magic, kMagic, 4);
+    h.version = kVersion;
+    h.count = static_cast<quint32>(entries.size());
+    h.dirCount = static_cast<quint32>(dirs.size());
+    h.currentIndex = state.currentIndex;
+    h.flags = state.muted ? kMuted : 0;
+    h.volume = static_cast<float>(state.volume) / 100.0f;
+    h.positionMs = state.positionMs;
+
+    QSaveFile out(path.isEmpty() ? defaultPath() : path);
+    if (!out.open(QIODevice::WriteOnly)) return false;
+    out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+    out.write(reinterpret_cast<const char *>(dirs.constData()), dirs.size() * qsizetype(sizeof(Dir)));
+    out.write(reinterpret_cast<const char *>(entries.constData()), entries.size() * qsizetype(sizeof(Entry)));
+    out.write(strings);
+    return out.commit();
+}
+
+// 只覆寫固定大小的檔頭，不動表格與字串區（可能仍被映射中）
+bool SessionSnapshot::saveState(int count, const State &state, const QString &path) {
+    QFile f(path.isEmpty() ? defaultPath() : path);
+    if (!f.open(QIODevice::ReadWrite)) return false;
+    Header h{};
+    if (f.read(reinterpret_cast<char *>(&h), sizeof(h)) != sizeof(h)) return false;
+    if (memcmp(h.magic, kMagic, 4) != 0 || h.version != kVersion || h.count != static_cast<quint32>(count))
+        return false;
+
+    h.currentIndex = state.currentIndex;
+    h.flags = state.muted ? kMuted : 0;
+    h.volume = static_cast<float>(state.volume) / 100.0f;
+    h.positionMs = state.positionMs;
+    return f.seek(0) && f.write(reinterpret_cast<const char *>(&h), sizeof(h)) == sizeof(h);
+}
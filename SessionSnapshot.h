@@ -0,0 +1,89 @@
+#pragma once
+#include <QFile>
+#include <QString>
+#include <QUrl>
+#include <QVector>
+#include <memory>
+#include "TrackStore.h"
+
+// 工作階段快照：播放清單、目前曲目、位置、音量與靜音（記憶體映射的二進位檔）
+//
+// 檔案格式 (little-endian)：
+//   Header  { magic "MPSS", version, count, dirCount, currentIndex, flags, volume, reserved, positionMs }
+//   Dir[dirCount]    { off, len }        去重後的目錄
+//   Entry[count]     { dir, off, len }   檔名；dir = kNoDir 時為完整 URL（非本機檔案）
+//   字串區：UTF-8，不含結尾
+//
+// 載入只映射並檢查檔頭，不逐筆解析；每一列在第一次取用時才組成 QUrl。
+class SessionSnapshot final {
+public:
+    struct State {
+        int currentIndex = -1;
+        qint64 positionMs = 0;
+        int volume = 100; // 0–100
+        bool muted = false;
+    };
+
+    ~SessionSnapshot();
+
+    SessionSnapshot(const SessionSnapshot &) = delete;
+
+    SessionSnapshot &operator=(const SessionSnapshot &) = delete;
+
+    // 映射快照檔；不存在或格式不符時回傳 nullptr
+    static std::shared_ptr<const SessionSnapshot> open(const QString &path = QString());
+
+    // 寫出整份快照（QSaveFile，不會留下寫到一半的檔案）
+    static bool save(const TrackStore &tracks, const State &state, const QString &path = QString());
+
+    // 清單沒變時只改寫檔頭；檔案不存在或筆數不符時回傳 false
+    static bool saveState(int count, const State &state, const QString &path = QString());
+
+    int count() const;
+
+    State state() const;
+
+    // 第 row 列的 URL；範圍錯誤時回傳空 URL
+    QUrl url(int row) const;
+
+    static QString defaultPath();
+
+private:
+    struct Header {
+        char magic[4];
+        quint32 version;
+        quint32 count;
+        quint32 dirCount;
+        qint32 currentIndex;
+        quint32 flags;
+        float volume;
+        quint32 reserved;
+        qint64 positionMs;
+    };
+
+    struct Dir {
+        quint32 off;
+        quint32 len;
+    };
+
+    struct Entry {
+        quint32 dir;
+        quint32 off;
+        quint32 len;
+    };
+
+    static constexpr quint32 kNoDir = 0xFFFFFFFF;
+    static constexpr quint32 kMuted = 1;
+
+    SessionSnapshot() = default;
+
+    QString stringAt(quint32 off, quint32 len) const;
+
+    QFile m_file;
+    const uchar *m_map = nullptr;
+    qint64 m_mapSize = 0;
+    Header m_header{};
+    const Dir *m_dirs = nullptr;
+    const Entry *m_entries = nullptr;
+    qint64 m_stringsOff = 0;
+};
@@ -0,0 +1,128 @@
+#include "Spectrum.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+namespace {
+    constexpr float kMinHz = 40.0f;
+    constexpr float kMaxHz = 16000.0f;
+    constexpr float kFallPerSecond = 1.5f; // 整個刻度約 0.7 秒落下
+
+    float toLevel(float db) {
+        return std::clamp(1.0f - db / SpectrumAnalyzer::kFloorDb, 0.0f, 1.0f);
+    }
+
+    // 上升立即跟上，下降有速度上限
+    void follow(float &cur, float target, float dt) {
+        cur = target >= cur ? target : std::max(target, cur - kFallPerSecond * dt);
+    }
+}
+
+SpectrumAnalyzer::SpectrumAnalyzer()
+    : m_kernels(&DspKernels::best()) {
+    double windowSum = 0.0;
+    for (int i = 0; i < kSize; ++i) {
+        m_window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * std::numbers::pi * i / kSize));
+        windowSum += m_window[i];
+    }
+    m_norm = static_cast<float>(4.0 / (windowSum * windowSum));
+
+    int bits = 0;
+    while ((1 << bits) < kSize) ++bits;
+    for (int i = 0; i < kSize; ++i) {
+        int r = 0;
+        for (int b = 0; b < bits; ++b) r |= ((i >> b) & 1) << (bits - 1 - b);
+        m_bitrev[i] = r;
+    }
+
+    m_twRe.reserve(kSize - 1);
+    m_twIm.reserve(kSize - 1);
+    for (int half = 1; half < kSize; half *= 2) {
+        for (int k = 0; k < half; ++k) {
+            const double a = -std::numbers::pi * k / half;
+            m_twRe.push_back(static_cast<float>(std::cos(a)));
+            m_twIm.push_back(static_cast<float>(std::sin(a)));
+        }
+    }
+    setSampleRate(m_rate);
+}
+
+void SpectrumAnalyzer::setSampleRate(int rate) {
+    m_rate = std::max(8000, rate);
+    const float top = std::min(kMaxHz, m_rate / 2.0f);
+    int prev = 0;
+    for (int b = 0; b <= kBands; ++b) {
+        const float hz = kMinHz * std::pow(top / kMinHz, static_cast<float>(b) / kBands);
+        const int bin = std::clamp(static_cast<int>(std::lround(hz * kSize / m_rate)), 1, kSize / 2 - 1);
+        m_bandEdge[b] = b == 0 ? bin : std::max(bin, std::min(prev + 1, kSize / 2 - 1));
+        prev = m_bandEdge[b];
+    }
+}
+
+void SpectrumAnalyzer::reset() {
+    m_history.fill(0.0f);
+    m_pos = 0;
+    m_sumSq[0] = m_sumSq[1] = 0.0;
+    m_peakIn[0] = m_peakIn[1] = 0.0f;
+    m_count = 0;
+    m_frame = Frame{};
+}
+
+void SpectrumAnalyzer::push(const float *in, int frames, int channels) {
+    if (channels < 1) return;
+    const int right = channels > 1 ? 1 : 0;
+    for (int i = 0; i < frames; ++i) {
+        const float l = in[i * channels];
+        const float r = in[i * channels + right];
+        m_history[m_pos] = 0.5f * (l + r);
+        m_pos = (m_pos + 1) & (kSize - 1);
+        m_sumSq[0] += double(l) * l;
+        m_sumSq[1] += double(r) * r;
+        m_peakIn[0] = std::max(m_peakIn[0], std::fabs(l));
+        m_peakIn[1] = std::max(m_peakIn[1], std::fabs(r));
+    }
+    m_count += frames;
+}
+
+// 位元反轉排列時順便乘上視窗，再逐級做蝶形運算
+void SpectrumAnalyzer::fft() {
+    for (int i = 0; i < kSize; ++i) {
+        m_re[m_bitrev[i]] = m_history[(m_pos + i) & (kSize - 1)] * m_window[i];
+        m_im[i] = 0.0f;
+    }
+    const float *twRe = m_twRe.data();
+    const float *twIm = m_twIm.data();
+    for (int half = 1; half < kSize; half *= 2) {
+        for (int g = 0; g < kSize; g += 2 * half)
+            m_kernels->butterflies(m_re.data() + g, m_im.data() + g, twRe, twIm, half);
+        twRe += half;
+        twIm += half;
+    }
+    m_kernels->power(m_re.data(), m_im.data(), m_power.data(), kSize / 2);
+}
+
+const SpectrumAnalyzer::Frame &SpectrumAnalyzer::analyze(float dt) {
+    fft();
+    for (int b = 0; b < kBands; ++b) {
+        const auto first = m_power.begin() + m_bandEdge[b];
+        const auto last = m_power.begin() + std::clamp(m_bandEdge[b + 1], m_bandEdge[b] + 1, kSize / 2);
+        const float p = *std::max_element(first, last) * m_norm;
+        follow(m_frame.bands[b], toLevel(10.0f * std::log10(p + 1e-12f)), dt);
+    }
+
+    for (int ch = 0; ch < 2; ++ch) {
+        float rms = 0.0f;
+        float peak = 0.0f;
+        if (m_count > 0) {
+            rms = toLevel(static_cast<float>(10.0 * std::log10(m_sumSq[ch] / m_count + 1e-12)));
+            peak = toLevel(20.0f * std::log10(m_peakIn[ch] + 1e-6f));
+        }
+        follow(m_frame.rms[ch], rms, dt);
+        follow(m_frame.peak[ch], peak, dt);
+        m_sumSq[ch] = 0.0;
+        m_peakIn[ch] = 0.0f;
+    }
+    m_count = 0;
+    return m_frame;
+}
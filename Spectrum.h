@@ -0,0 +1,64 @@
+#pragma once
+#include <array>
+#include <vector>
+#include "DspKernels.h"
+
+// 即時頻譜與 VU：Hann 視窗 + 基 2 FFT（蝶形運算使用 DspKernels 的向量化版本）
+// 單一執行緒使用；建構後 push()/analyze() 不配置記憶體
+class SpectrumAnalyzer final {
+public:
+    static constexpr int kSize = 2048;
+    static constexpr int kBands = 32; // 40 Hz .. 16 kHz 對數分布
+    static constexpr float kFloorDb = -60.0f;
+
+    // 全部正規化為 0..1（kFloorDb .. 0 dBFS）
+    struct Frame {
+        float bands[kBands]{};
+        float rms[2]{};
+        float peak[2]{};
+    };
+
+    SpectrumAnalyzer();
+
+    void setSampleRate(int rate);
+
+    int sampleRate() const { return m_rate; }
+
+    // 交錯樣本（1 或 2 聲道）
+    void push(const float *interleaved, int frames, int channels);
+
+    // 以最近 kSize 個樣本計算；dt 為距上次的秒數（控制下降速度）
+    const Frame &analyze(float dt);
+
+    void reset();
+
+    void setKernels(const DspKernels &kernels) { m_kernels = &kernels; }
+
+    const char *kernelName() const { return m_kernels->name; }
+
+private:
+    void fft();
+
+    const DspKernels *m_kernels;
+    int m_rate = 48000;
+
+    std::array<float, kSize> m_window{};
+    std::array<int, kSize> m_bitrev{};
+    std::vector<float> m_twRe; // 各級旋轉因子依序存放（half = 1, 2, 4 … 共 kSize - 1 個）
+    std::vector<float> m_twIm;
+    std::array<int, kBands + 1> m_bandEdge{}; // 各頻帶的起始 bin
+    float m_norm = 1.0f; // 滿刻度正弦波 → 0 dB
+
+    std::array<float, kSize> m_history{}; // 單聲道混音（環形）
+    int m_pos = 0;
+    std::array<float, kSize> m_re{};
+    std::array<float, kSize> m_im{};
+    std::array<float, kSize / 2> m_power{};
+
+    // VU：自上次 analyze() 以來的累積
+    double m_sumSq[2]{};
+    float m_peakIn[2]{};
+    int m_count = 0;
+
+    Frame m_frame;
+};
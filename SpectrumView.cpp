@@ -0,0 +1,151 @@
+#include "SpectrumView.h"
+
+#include <QEvent>
+#include <QPainter>
+#include <QScreen>
+#include <algorithm>
+
+namespace {
+    constexpr int kVuWidth = 120;
+    constexpr int kGap = 2;
+}
+
+// 工作執行緒
+SpectrumWorker::SpectrumWorker(AudioTap &tap)
+    : m_tap(tap), m_timer(new QTimer(this)) {
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout, this, &SpectrumWorker::tick);
+}
+
+void SpectrumWorker::start(int intervalMs) {
+    m_tap.setEnabled(true);
+    m_clock.start();
+    m_timer->start(intervalMs);
+}
+
+void SpectrumWorker::stop() {
+    m_timer->stop();
+    m_tap.setEnabled(false);
+    while (m_tap.take()) {
+    }
+    m_analyzer.reset();
+    m_quiet = true;
+    m_frames.write(m_analyzer.analyze(0.0f)); // 清空畫面
+}
+
+void SpectrumWorker::push(const QAudioBuffer &buffer) {
+    if (!m_timer->isActive() || buffer.format().sampleFormat() != QAudioFormat::Float) return;
+    if (buffer.format().sampleRate() != m_analyzer.sampleRate()) m_analyzer.setSampleRate(buffer.format().sampleRate());
+    m_analyzer.push(buffer.constData<float>(), static_cast<int>(buffer.frameCount()), buffer.format().channelCount());
+    m_fresh = true;
+}
+
+void SpectrumWorker::tick() {
+    while (const AudioTap::Handle block = m_tap.take()) {
+        if (block.sampleRate() != m_analyzer.sampleRate()) m_analyzer.setSampleRate(block.sampleRate());
+        m_analyzer.push(block.samples(), block.frames(), block.channels());
+        m_fresh = true;
+    }
+    const float dt = static_cast<float>(m_clock.restart()) / 1000.0f;
+    if (!m_fresh && m_quiet) return; // 停止播放且已落下：不計算、不重繪
+    m_fresh = false;
+
+    const SpectrumAnalyzer::Frame &f = m_analyzer.analyze(dt);
+    m_quiet = std::all_of(std::begin(f.bands), std::end(f.bands), [](float v) { return v == 0.0f; }) &&
+              f.peak[0] == 0.0f && f.peak[1] == 0.0f;
+    m_frames.write(f);
+}
+
+// 顯示
+SpectrumView::SpectrumView(AudioTap &tap, QWidget *parent)
+    : QWidget(parent), m_worker(new SpectrumWorker(tap)) {
+    setAttribute(Qt::WA_OpaquePaintEvent, false);
+    setMinimumHeight(48);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+
+    m_thread.setObjectName("spectrum");
+    m_worker->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+    m_thread.start(QThread::LowPriority);
+
+    m_frameTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_frameTimer, &QTimer::timeout, this, &SpectrumView::onFrame);
+    window()->installEventFilter(this);
+}
+
+SpectrumView::~SpectrumView() {
+    QMetaObject::invokeMethod(m_worker, [w = m_worker] { w->stop(); }, Qt::BlockingQueuedConnection);
+    m_thread.quit();
+    m_thread.wait();
+}
+
+void SpectrumView::pushBuffer(const QAudioBuffer &buffer) {
+    if (!m_running) return;
+    QMetaObject::invokeMethod(m_worker, [w = m_worker, buffer] { w->push(buffer); });
+}
+
+void SpectrumView::showEvent(QShowEvent *event) {
+    QWidget::showEvent(event);
+    updateRunning();
+}
+
+void SpectrumView::hideEvent(QHideEvent *event) {
+    QWidget::hideEvent(event);
+    updateRunning();
+}
+
+bool SpectrumView::eventFilter(QObject *watched, QEvent *event) {
+    if (watched == window() && event->type() == QEvent::WindowStateChange) updateRunning();
+    return QWidget::eventFilter(watched, event);
+}
+
+// 看不見時工作執行緒與 tap 都停下
+void SpectrumView::updateRunning() {
+    const bool run = isVisible() && !window()->isMinimized();
+    if (run == m_running) return;
+    m_running = run;
+    if (run) {
+        const qreal hz = screen() ? screen()->refreshRate() : 60.0;
+        const int interval = std::max(8, qRound(1000.0 / (hz > 0 ? hz : 60.0)));
+        QMetaObject::invokeMethod(m_worker, [w = m_worker, interval] { w->start(interval); });
+        m_frameTimer.start(interval);
+    } else {
+        QMetaObject::invokeMethod(m_worker, [w = m_worker] { w->stop(); });
+        m_frameTimer.stop();
+    }
+}
+
+// 只有新結果才重繪
+void SpectrumView::onFrame() {
+    if (!m_worker->update()) return;
+    m_frame = m_worker->frame();
+    update();
+}
+
+void SpectrumView::paintEvent(QPaintEvent *) {
+    QPainter p(this);
+    const QRectF area = QRectF(rect()).adjusted(12, 6, -12, -6);
+    const QColor bar(0x5C, 0xC8, 0xFF);
+    const QColor dim(255, 255, 255, 25);
+
+    // 頻譜
+    const double specWidth = area.width() - kVuWidth - 12;
+    const double w = specWidth / SpectrumAnalyzer::kBands;
+    for (int b = 0; b < SpectrumAnalyzer::kBands; ++b) {
+        const QRectF slot(area.left() + b * w, area.top(), w - kGap, area.height());
+        p.fillRect(slot, dim);
+        const double h = slot.height() * m_frame.bands[b];
+        p.fillRect(QRectF(slot.left(), slot.bottom() - h, slot.width(), h), bar);
+    }
+
+    // VU：RMS 為實心，峰值為細線
+    const double left = area.right() - kVuWidth;
+    const double h = (area.height() - kGap) / 2;
+    for (int ch = 0; ch < 2; ++ch) {
+        const QRectF slot(left, area.top() + ch * (h + kGap), kVuWidth, h);
+        p.fillRect(slot, dim);
+        p.fillRect(QRectF(slot.left(), slot.top(), slot.width() * m_frame.rms[ch], slot.height()), bar);
+        const double x = slot.left() + slot.width() * m_frame.peak[ch];
+        p.fillRect(QRectF(x - 1, slot.top(), 2, slot.height()), m_frame.peak[ch] > 0.98f ? Qt::red : Qt::white);
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <QElapsedTimer>
+#include <QThread>
+#include <QTimer>
+#include <QWidget>
+#include <QtMultimedia/QAudioBuffer>
+#include "AudioTap.h"
+#include "Spectrum.h"
+#include "TripleBuffer.h"
+
+// 視覺化執行緒：定時從 tap 取出區塊計算頻譜，結果以三重緩衝交給 GUI
+class SpectrumWorker final : public QObject {
+    Q_OBJECT
+
+public:
+    explicit SpectrumWorker(AudioTap &tap);
+
+    // 以下三個在工作執行緒呼叫
+    void start(int intervalMs);
+
+    void stop();
+
+    // Qt Multimedia 引擎的樣本（QAudioBuffer 為隱式共用，傳遞不複製）
+    void push(const QAudioBuffer &buffer);
+
+    // GUI 端：有新結果時回傳 true
+    bool update() { return m_frames.update(); }
+
+    const SpectrumAnalyzer::Frame &frame() const { return m_frames.read(); }
+
+private:
+    void tick();
+
+    AudioTap &m_tap;
+    SpectrumAnalyzer m_analyzer;
+    QTimer *m_timer;
+    QElapsedTimer m_clock;
+    bool m_fresh = false; // 上次計算後有新樣本
+    bool m_quiet = true; // 已完全落下，沒有新樣本時不必再算
+    TripleBuffer<SpectrumAnalyzer::Frame> m_frames;
+};
+
+// 清單下方的頻譜與 VU 表：只在顯示時運作，依螢幕更新率重繪
+class SpectrumView final : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit SpectrumView(AudioTap &tap, QWidget *parent = nullptr);
+
+    ~SpectrumView() override;
+
+    void pushBuffer(const QAudioBuffer &buffer);
+
+    QSize sizeHint() const override { return {400, 64}; }
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+    void showEvent(QShowEvent *event) override;
+
+    void hideEvent(QHideEvent *event) override;
+
+    // 監看主視窗最小化
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    void updateRunning();
+
+    void onFrame();
+
+    QThread m_thread;
+    SpectrumWorker *m_worker;
+    QTimer m_frameTimer;
+    SpectrumAnalyzer::Frame m_frame;
+    bool m_running = false;
+};
@@ -0,0 +1,74 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+
+// 單一生產者 / 單一消費者的無鎖環形緩衝區
+// 建構後不再配置記憶體；write() 只能由生產者呼叫，read() 只能由消費者呼叫
+template<typename T>
+class SpscRingBuffer final {
+public:
+    explicit SpscRingBuffer(std::size_t minCapacity)
+        : m_capacity(std::bit_ceil(std::max<std::size_t>(minCapacity, 2))),
+          m_mask(m_capacity - 1),
+          m_data(std::make_unique<T[]>(m_capacity)) {
+    }
+
+    SpscRingBuffer(const SpscRingBuffer &) = delete;
+
+    SpscRingBuffer &operator=(const SpscRingBuffer &) = delete;
+
+    std::size_t capacity() const { return m_capacity; }
+
+    // 可讀取的元素數（任一端或第三個執行緒呼叫皆可，結果為當下的近似值）
+    // 先讀 m_read：它只會追上 m_write，之後讀到的 m_write 不會比它小；兩次讀取之間雙方都可能前進，所以上限取容量
+    std::size_t available() const {
+        const std::size_t r = m_read.load(std::memory_order_acquire);
+        const std::size_t w = m_write.load(std::memory_order_acquire);
+        return std::min(w - r, m_capacity);
+    }
+
+    std::size_t freeSpace() const { return m_capacity - available(); }
+
+    // 生產者：寫入最多 n 個，回傳實際寫入數
+    std::size_t write(const T *src, std::size_t n) {
+        const std::size_t w = m_write.load(std::memory_order_relaxed);
+        const std::size_t r = m_read.load(std::memory_order_acquire);
+        n = std::min(n, m_capacity - (w - r));
+        const std::size_t off = w & m_mask;
+        const std::size_t first = std::min(n, m_capacity - off);
+        std::copy_n(src, first, m_data.get() + off);
+        std::copy_n(src + first, n - first, m_data.get());
+        m_write.store(w + n, std::memory_order_release);
+        return n;
+    }
+
+    // 消費者：讀取最多 n 個，回傳實際讀取數
+    std::size_t read(T *dst, std::size_t n) {
+        const std::size_t r = m_read.load(std::memory_order_relaxed);
+        const std::size_t w = m_write.load(std::memory_order_acquire);
+        n = std::min(n, w - r);
+        const std::size_t off = r & m_mask;
+        const std::size_t first = std::min(n, m_capacity - off);
+        std::copy_n(m_data.get() + off, first, dst);
+        std::copy_n(m_data.get(), n - first, dst + first);
+        m_read.store(r + n, std::memory_order_release);
+        return n;
+    }
+
+    // 只能在兩端都停止時呼叫
+    void reset() {
+        m_read.store(0, std::memory_order_relaxed);
+        m_write.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    // 讀寫索引放在不同 cache line，避免 false sharing
+    alignas(64) std::atomic<std::size_t> m_write{0};
+    alignas(64) std::atomic<std::size_t> m_read{0};
+    const std::size_t m_capacity;
+    const std::size_t m_mask;
+    std::unique_ptr<T[]> m_data;
+};
@@ -0,0 +1,37 @@
+#pragma once
+#include <QString>
+#include <QtGlobal>
+
+// 曲目資訊（標籤 + 串流參數）
+struct TrackInfo {
+    QString title;
+    QString artist;
+    QString album;
+    qint64 durationMs = 0;
+    int bitrate = 0; // kbps
+    int sampleRate = 0; // Hz
+};
+
+// MPEG 音訊幀標頭
+struct MpegHeader {
+    int version = 0; // 1 = MPEG-1, 2 = MPEG-2, 25 = MPEG-2.5
+    int layer = 0; // 1..3
+    int bitrate = 0; // kbps
+    int sampleRate = 0; // Hz
+    int channels = 0;
+    int samplesPerFrame = 0;
+    int frameLength = 0; // bytes
+};
+
+// 直接讀檔解析標籤與長度（不需要媒體後端，可在背景執行緒使用）
+class TagReader final {
+public:
+    // 支援 MP3 (ID3v2/ID3v1 + Xing/VBRI)、FLAC、WAV、Ogg Vorbis/Opus、MP4/M4A
+    static bool read(const QString &path, TrackInfo &info);
+
+    // 解析 4 bytes 的 MPEG 幀標頭
+    static bool parseMpegHeader(const uchar *p, MpegHeader &h);
+
+    // ID3v2 標籤總長度（含標頭），沒有標籤時回傳 0
+    static qint64 id3v2Size(const uchar *p, qint64 len);
+};
@@ -0,0 +1,146 @@
+#include "Trace.h"
+
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace {
+    const auto kEpoch = std::chrono::steady_clock::now();
+
+    // 每格以序號保護：寫入中為奇數，讀取前後序號相同才算完整
+    struct Slot {
+        std::atomic<quint64> seq{0};
+        Trace::Event event{};
+    };
+
+    Slot g_ring[Trace::kCapacity];
+    std::atomic<quint64> g_next{0};
+    std::atomic<quint32> g_threads{0};
+    QString g_exportPath;
+
+    // 匯出時以小整數區分執行緒
+    quint32 threadNumber() {
+        thread_local const quint32 id = g_threads.fetch_add(1, std::memory_order_relaxed) + 1;
+        return id;
+    }
+
+    double percentile(const std::vector<qint64> &sorted, double p) {
+        const size_t i = std::min(sorted.size() - 1, static_cast<size_t>(p * static_cast<double>(sorted.size())));
+        return static_cast<double>(sorted[i]) / 1000.0;
+    }
+}
+
+std::atomic<bool> Trace::s_enabled{false};
+static_assert(Trace::SpanCount == 4, "s_open 初始值要與 Span 數量一致");
+std::atomic<qint64> Trace::s_open[SpanCount] = {-1, -1, -1, -1};
+
+void Trace::setEnabled(bool on) {
+    if (!on) {
+        for (auto &open: s_open) open.store(-1, std::memory_order_relaxed);
+    }
+    s_enabled.store(on, std::memory_order_relaxed);
+}
+
+void Trace::initFromEnvironment() {
+    const QString value = qEnvironmentVariable("MUSICPLAYER_TRACE");
+    if (value.isEmpty() || value == "0") return;
+    if (value != "1") g_exportPath = value;
+    setEnabled(true);
+}
+
+void Trace::finish() {
+    if (g_exportPath.isEmpty()) return;
+    if (QString error; !exportChrome(g_exportPath, &error))
+        std::fprintf(stderr, "MusicPlayer: trace export failed: %s\n", qPrintable(error));
+}
+
+qint64 Trace::nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - kEpoch).count();
+}
+
+const char *Trace::name(Span span) {
+    switch (span) {
+        case Startup: return "startup";
+        case WindowSetup: return "window setup";
+        case TrackSwitch: return "track switch";
+        case Seek: return "seek";
+        default: return "?";
+    }
+}
+
+// 寫入：取號後填入該格，舊資料直接覆蓋
+void Trace::push(Span span, qint64 startUs, qint64 endUs) {
+    const quint64 n = g_next.fetch_add(1, std::memory_order_relaxed);
+    Slot &slot = g_ring[n & (kCapacity - 1)];
+    slot.seq.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.event = {span, threadNumber(), startUs, std::max<qint64>(0, endUs - startUs)};
+    slot.seq.store(2 * n + 2, std::memory_order_release);
+}
+
+std::vector<Trace::Event> Trace::snapshot() {
+    const quint64 end = g_next.load(std::memory_order_acquire);
+    const quint64 begin = end > kCapacity ? end - kCapacity : 0;
+    std::vector<Event> events;
+    events.reserve(static_cast<size_t>(end - begin));
+    for (quint64 n = begin; n < end; ++n) {
+        const Slot &slot = g_ring[n & (kCapacity - 1)];
+        const quint64 before = slot.seq.load(std::memory_order_acquire);
+        if (before != 2 * n + 2) continue; // 寫入中或已被覆蓋
+        const Event e = slot.event;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) == before) events.push_back(e);
+    }
+    std::ranges::sort(events, {}, &Event::startUs);
+    return events;
+}
+
+Trace::Stats Trace::stats(Span span) {
+    std::vector<qint64> durations;
+    for (const Event &e: snapshot()) {
+        if (e.span == span) durations.push_back(e.durUs);
+    }
+    Stats s;
+    if (durations.empty()) return s;
+    std::ranges::sort(durations);
+    s.count = static_cast<int>(durations.size());
+    s.p50Ms = percentile(durations, 0.50);
+    s.p99Ms = percentile(durations, 0.99);
+    s.maxMs = static_cast<double>(durations.back()) / 1000.0;
+    return s;
+}
+
+// Chrome trace-event 格式：每個區間一個 "X"（complete）事件
+bool Trace::exportChrome(const QString &file, QString *error) {
+    const qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray events;
+    for (const Event &e: snapshot()) {
+        events.push_back(QJsonObject{
+            {"name", name(e.span)}, {"cat", "musicplayer"}, {"ph", "X"},
+            {"ts", e.startUs}, {"dur", e.durUs}, {"pid", pid}, {"tid", static_cast<qint64>(e.thread)}
+        });
+    }
+    const QJsonObject root{{"traceEvents", events}, {"displayTimeUnit", "ms"}};
+
+    QSaveFile f(file);
+    if (!f.open(QIODevice::WriteOnly)) {
+        if (error) *error = f.errorString();
+        return false;
+    }
+    f.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    if (!f.commit()) {
+        if (error) *error = f.errorString();
+        return false;
+    }
+    return true;
+}
+
+void Trace::clear() {
+    for (Slot &slot: g_ring) slot.seq.store(0, std::memory_order_relaxed);
+    g_next.store(0, std::memory_order_release);
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+#include <vector>
+
+// 熱路徑延遲追蹤：固定大小的環形緩衝，可匯出 Chrome trace-event JSON（chrome://tracing、Perfetto）
+//
+// 關閉時每個追蹤點只多讀一個 atomic；開啟時記錄不加鎖、不配置記憶體。
+// 設定環境變數 MUSICPLAYER_TRACE=1 從啟動開始記錄，設為檔名則在結束時寫出。
+class Trace final {
+public:
+    enum Span : quint8 {
+        Startup, // main() → 第一次 show()
+        WindowSetup, // MainWindow 建構
+        TrackSwitch, // playIndex() → 位置開始前進（第一個聽得到的樣本）
+        Seek, // 設定位置 → 從新位置繼續播放
+        SpanCount
+    };
+
+    struct Event {
+        Span span;
+        quint32 thread;
+        qint64 startUs;
+        qint64 durUs;
+    };
+
+    struct Stats {
+        int count = 0;
+        double p50Ms = 0.0;
+        double p99Ms = 0.0;
+        double maxMs = 0.0;
+    };
+
+    static constexpr int kCapacity = 4096; // 2 的次方
+
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    static void setEnabled(bool on);
+
+    // 讀取 MUSICPLAYER_TRACE
+    static void initFromEnvironment();
+
+    // 結束時依環境變數寫出
+    static void finish();
+
+    // 自行程啟動以來的微秒
+    static qint64 nowUs();
+
+    static void record(Span span, qint64 startUs, qint64 endUs) {
+        if (isEnabled()) push(span, startUs, endUs);
+    }
+
+    // 跨回呼的區間：同一種一次只追蹤一個，重新 begin 會取代尚未結束的
+    static void begin(Span span) {
+        if (isEnabled()) s_open[span].store(nowUs(), std::memory_order_relaxed);
+    }
+
+    static void end(Span span) {
+        if (!isEnabled()) return;
+        if (const qint64 start = s_open[span].exchange(-1, std::memory_order_relaxed); start >= 0)
+            push(span, start, nowUs());
+    }
+
+    static void cancel(Span span) { s_open[span].store(-1, std::memory_order_relaxed); }
+
+    static bool isOpen(Span span) { return s_open[span].load(std::memory_order_relaxed) >= 0; }
+
+    // 同步區間
+    class Scope {
+    public:
+        explicit Scope(Span span) : m_span(span), m_start(isEnabled() ? nowUs() : -1) {
+        }
+
+        ~Scope() {
+            if (m_start >= 0) record(m_span, m_start, nowUs());
+        }
+
+        Scope(const Scope &) = delete;
+
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        Span m_span;
+        qint64 m_start;
+    };
+
+    static const char *name(Span span);
+
+    // 目前緩衝中的事件（依時間排序）
+    static std::vector<Event> snapshot();
+
+    static Stats stats(Span span);
+
+    static bool exportChrome(const QString &file, QString *error = nullptr);
+
+    static void clear();
+
+private:
+    static void push(Span span, qint64 startUs, qint64 endUs);
+
+    static std::atomic<bool> s_enabled;
+    static std::atomic<qint64> s_open[SpanCount]; // 開始時間，-1 = 未追蹤
+};
@@ -0,0 +1,62 @@
+#include "TraceOverlay.h"
+
+#include <QEvent>
+#include "Trace.h"
+
+namespace {
+    constexpr int kMargin = 8;
+    const Trace::Span kShown[] = {Trace::TrackSwitch, Trace::Seek, Trace::Startup};
+}
+
+TraceOverlay::TraceOverlay(QWidget *parent)
+    : QLabel(parent) {
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    setTextFormat(Qt::RichText);
+    setStyleSheet("QLabel { background: rgba(0,0,0,0.65); color: #E6E6E6; border-radius: 6px;"
+                  " padding: 6px 8px; font-family: monospace; font-size: 11px; }");
+    m_timer.setInterval(1000);
+    connect(&m_timer, &QTimer::timeout, this, &TraceOverlay::refresh);
+    parent->installEventFilter(this);
+    hide();
+}
+
+void TraceOverlay::showEvent(QShowEvent *event) {
+    QLabel::showEvent(event);
+    refresh();
+    m_timer.start();
+}
+
+void TraceOverlay::hideEvent(QHideEvent *event) {
+    QLabel::hideEvent(event);
+    m_timer.stop();
+}
+
+bool TraceOverlay::eventFilter(QObject *watched, QEvent *event) {
+    if (watched == parentWidget() && event->type() == QEvent::Resize) reposition();
+    return QLabel::eventFilter(watched, event);
+}
+
+void TraceOverlay::refresh() {
+    QString html = "<table cellspacing=0 cellpadding=1>"
+            "<tr><td></td><td align=right>&nbsp;n</td><td align=right>&nbsp;p50 ms</td>"
+            "<td align=right>&nbsp;p99 ms</td></tr>";
+    for (const Trace::Span span: kShown) {
+        const Trace::Stats s = Trace::stats(span);
+        html += QString("<tr><td>%1</td><td align=right>&nbsp;%2</td>"
+                        "<td align=right>&nbsp;%3</td><td align=right>&nbsp;%4</td></tr>")
+                .arg(Trace::name(span))
+                .arg(s.count)
+                .arg(s.count ? QString::number(s.p50Ms, 'f', 1) : QString("–"))
+                .arg(s.count ? QString::number(s.p99Ms, 'f', 1) : QString("–"));
+    }
+    html += "</table>";
+    if (!Trace::isEnabled()) html += "<i>tracing off</i>";
+    setText(html);
+    adjustSize();
+    reposition();
+}
+
+void TraceOverlay::reposition() {
+    if (const QWidget *p = parentWidget()) move(p->width() - width() - kMargin, kMargin);
+    raise();
+}
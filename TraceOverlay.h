@@ -0,0 +1,26 @@
+#pragma once
+#include <QLabel>
+#include <QTimer>
+
+// 疊在清單右上角的延遲統計（p50/p99），每秒更新一次，滑鼠事件穿透
+class TraceOverlay final : public QLabel {
+    Q_OBJECT
+
+public:
+    explicit TraceOverlay(QWidget *parent);
+
+protected:
+    void showEvent(QShowEvent *event) override;
+
+    void hideEvent(QHideEvent *event) override;
+
+    // 跟著父元件調整位置
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    void refresh();
+
+    void reposition();
+
+    QTimer m_timer;
+};
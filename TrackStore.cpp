@@ -0,0 +1,209 @@
+#include "TrackStore.h"
+
+#include <QHash>
+#include <algorithm>
+
+namespace {
+    // 本機路徑在最後一個 '/' 拆成目錄與檔名（UTF-8 中 '/' 不會出現在多位元組字元內）
+    std::pair<QByteArrayView, QByteArrayView> splitPath(const QByteArray &utf8) {
+        const qsizetype slash = utf8.lastIndexOf('/');
+        return {QByteArrayView(utf8.constData(), std::max<qsizetype>(0, slash)),
+                QByteArrayView(utf8.constData() + slash + 1, utf8.size() - slash - 1)};
+    }
+}
+
+void TrackStore::reserve(qsizetype count) {
+    m_entries.reserve(count);
+}
+
+void TrackStore::append(const QUrl &url) {
+    m_entries.push_back(makeEntry(url));
+}
+
+void TrackStore::append(const TrackStore &other, int row) {
+    m_entries.push_back(import(other, row));
+}
+
+void TrackStore::appendPending(int count) {
+    m_entries.reserve(m_entries.size() + count);
+    for (int i = 0; i < count; ++i) m_entries.push_back({kPending, static_cast<quint32>(i)});
+}
+
+int TrackStore::pendingRow(int row) const {
+    const Entry &e = m_entries.at(row);
+    return e.dir == kPending ? static_cast<int>(e.name) : -1;
+}
+
+void TrackStore::set(int row, const QUrl &url) {
+    release(m_entries.at(row));
+    m_entries[row] = makeEntry(url);
+}
+
+QUrl TrackStore::url(int row) const {
+    const Entry &e = m_entries.at(row);
+    if (e.dir == kPending) return {};
+    if (e.dir == kNoDir) return QUrl::fromEncoded(nameUtf8(row).toByteArray());
+    return QUrl::fromLocalFile(localFile(row));
+}
+
+QString TrackStore::path(int row) const {
+    return isLocalFile(row) ? localFile(row) : url(row).toString();
+}
+
+QString TrackStore::localFile(int row) const {
+    if (!isLocalFile(row)) return {};
+    const QByteArrayView dir = dirUtf8(m_entries.at(row).dir);
+    const QByteArrayView name = nameUtf8(row);
+    QByteArray utf8;
+    utf8.reserve(dir.size() + 1 + name.size());
+    utf8.append(dir).append('/').append(name);
+    return QString::fromUtf8(utf8);
+}
+
+QString TrackStore::fileName(int row) const {
+    return isLocalFile(row) ? QString::fromUtf8(nameUtf8(row)) : url(row).fileName();
+}
+
+// 先找目錄編號，只比對同目錄的列
+int TrackStore::indexOf(const QUrl &url) const {
+    if (url.isLocalFile()) {
+        const QByteArray utf8 = url.toLocalFile().toUtf8();
+        const auto [dir, name] = splitPath(utf8);
+        const quint32 id = findDir(dir);
+        if (id == kNoDir) return -1;
+        for (int row = 0; row < count(); ++row) {
+            if (m_entries[row].dir == id && nameUtf8(row) == name) return row;
+        }
+        return -1;
+    }
+    const QByteArray encoded = url.toEncoded();
+    for (int row = 0; row < count(); ++row) {
+        if (m_entries[row].dir == kNoDir && nameUtf8(row) == encoded) return row;
+    }
+    return -1;
+}
+
+// 只搬移 8 位元組的列，字串區不動；移除夠多時才壓縮檔名
+void TrackStore::remap(const QVector<int> &newRowOf, int count) {
+    if (newRowOf.size() != m_entries.size()) return;
+    QVector<Entry> out(count);
+    for (int row = 0; row < newRowOf.size(); ++row) {
+        if (const int n = newRowOf[row]; n >= 0 && n < count) out[n] = m_entries[row];
+        else release(m_entries[row]);
+    }
+    m_entries = std::move(out);
+    if (m_names.size() > 2 * m_liveNameBytes + 0xFFFF) compactNames();
+}
+
+void TrackStore::insertAt(const QVector<int> &rows, const TrackStore &from) {
+    const qsizetype total = m_entries.size() + rows.size();
+    QVector<Entry> out;
+    out.reserve(total);
+    qsizetype old = 0;
+    qsizetype k = 0;
+    for (qsizetype n = 0; n < total; ++n) {
+        if (k < rows.size() && rows[k] == n) out.push_back(import(from, static_cast<int>(k++)));
+        else out.push_back(m_entries[old++]);
+    }
+    m_entries = std::move(out);
+}
+
+TrackStore TrackStore::subset(const QVector<int> &rows) const {
+    TrackStore s;
+    s.reserve(rows.size());
+    for (const int row: rows) s.append(*this, row);
+    return s;
+}
+
+void TrackStore::clear() {
+    *this = TrackStore();
+}
+
+qint64 TrackStore::memoryUsage() const {
+    return qint64(sizeof(*this)) + m_entries.capacity() * qint64(sizeof(Entry)) + m_names.capacity()
+           + m_dirs.capacity() + (m_dirOff.capacity() + m_slots.capacity()) * qint64(sizeof(quint32));
+}
+
+QByteArrayView TrackStore::dirUtf8(quint32 dir) const {
+    return QByteArrayView(m_dirs.constData() + m_dirOff.at(dir));
+}
+
+QByteArrayView TrackStore::nameUtf8(int row) const {
+    const Entry &e = m_entries.at(row);
+    if (e.dir == kPending) return {};
+    return QByteArrayView(m_names.constData() + e.name);
+}
+
+TrackStore::Entry TrackStore::makeEntry(const QUrl &url) {
+    if (!url.isLocalFile()) return {kNoDir, addName(url.toEncoded())};
+    const QByteArray utf8 = url.toLocalFile().toUtf8();
+    const auto [dir, name] = splitPath(utf8);
+    return {internDir(dir), addName(name)};
+}
+
+TrackStore::Entry TrackStore::import(const TrackStore &other, int row) {
+    const Entry &e = other.m_entries.at(row);
+    if (e.dir == kPending) return e;
+    const quint32 dir = e.dir == kNoDir ? kNoDir : internDir(other.dirUtf8(e.dir));
+    return {dir, addName(other.nameUtf8(row))};
+}
+
+void TrackStore::release(const Entry &e) {
+    if (e.dir != kPending) m_liveNameBytes -= qstrlen(m_names.constData() + e.name) + 1;
+}
+
+quint32 TrackStore::internDir(QByteArrayView dir) {
+    if (const quint32 id = findDir(dir); id != kNoDir) return id;
+    const auto id = static_cast<quint32>(m_dirOff.size());
+    m_dirOff.push_back(static_cast<quint32>(m_dirs.size()));
+    m_dirs.append(dir).append('\0');
+    if (m_dirOff.size() * 2 > m_slots.size()) {
+        rehash(std::max<qsizetype>(64, m_slots.size() * 2));
+    } else {
+        const qsizetype mask = m_slots.size() - 1;
+        qsizetype i = qHash(dir) & mask;
+        while (m_slots[i]) i = (i + 1) & mask;
+        m_slots[i] = id + 1;
+    }
+    return id;
+}
+
+// 線性探測；負載不超過一半
+quint32 TrackStore::findDir(QByteArrayView dir) const {
+    if (m_slots.isEmpty()) return kNoDir;
+    const qsizetype mask = m_slots.size() - 1;
+    for (qsizetype i = qHash(dir) & mask; m_slots[i]; i = (i + 1) & mask) {
+        if (dirUtf8(m_slots[i] - 1) == dir) return m_slots[i] - 1;
+    }
+    return kNoDir;
+}
+
+quint32 TrackStore::addName(QByteArrayView name) {
+    const auto off = static_cast<quint32>(m_names.size());
+    m_names.append(name).append('\0');
+    m_liveNameBytes += name.size() + 1;
+    return off;
+}
+
+void TrackStore::rehash(qsizetype slots) {
+    m_slots = QVector<quint32>(slots, 0);
+    const qsizetype mask = slots - 1;
+    for (qsizetype id = 0; id < m_dirOff.size(); ++id) {
+        qsizetype i = qHash(dirUtf8(static_cast<quint32>(id))) & mask;
+        while (m_slots[i]) i = (i + 1) & mask;
+        m_slots[i] = static_cast<quint32>(id + 1);
+    }
+}
+
+void TrackStore::compactNames() {
+    QByteArray names;
+    names.reserve(m_liveNameBytes);
+    for (Entry &e: m_entries) {
+        if (e.dir == kPending) continue;
+        const char *name = m_names.constData() + e.name;
+        const auto off = static_cast<quint32>(names.size());
+        names.append(name, qstrlen(name) + 1);
+        e.name = off;
+    }
+    m_names = std::move(names);
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QString>
+#include <QUrl>
+#include <QVector>
+
+// 播放清單的緊湊儲存：目錄前綴只存一次（字串區 + 開放定址雜湊），檔名連續存成 UTF-8，
+// 每列只有兩個 32 位元位移。交給播放器時才組成 QUrl。
+//
+// 成員都是隱式共享的容器：複製一份交給背景執行緒只增加參考計數。
+// 移除或改名留下的檔名位元組在浪費超過一半時壓縮；目錄在 clear() 前不回收（通常只有數百個）。
+class TrackStore final {
+public:
+    static constexpr quint32 kNoDir = 0xFFFFFFFF; // 非本機檔案：檔名欄位是完整 URL
+    static constexpr quint32 kPending = 0xFFFFFFFE; // 尚未從快照取出：檔名欄位是快照的列號
+
+    int count() const { return static_cast<int>(m_entries.size()); }
+
+    bool isEmpty() const { return m_entries.isEmpty(); }
+
+    void reserve(qsizetype count);
+
+    void append(const QUrl &url);
+
+    // 複製另一份儲存的第 row 列
+    void append(const TrackStore &other, int row);
+
+    // count 列佔位，之後以 set() 填入；pendingRow() 為 0..count-1
+    void appendPending(int count);
+
+    // 快照列號；已填入時回傳 -1
+    int pendingRow(int row) const;
+
+    void set(int row, const QUrl &url);
+
+    QUrl url(int row) const;
+
+    // 本機路徑；非本機時為完整 URL
+    QString path(int row) const;
+
+    // 非本機時為空字串
+    QString localFile(int row) const;
+
+    QString fileName(int row) const;
+
+    bool isLocalFile(int row) const { return m_entries.at(row).dir < kPending; }
+
+    int indexOf(const QUrl &url) const;
+
+    // newRowOf[舊列] = 新列，-1 = 移除；count 為剩下的列數（只移除與重新排序）
+    void remap(const QVector<int> &newRowOf, int count);
+
+    // 在升冪的最終列號 rows 插入 from 的各列
+    void insertAt(const QVector<int> &rows, const TrackStore &from);
+
+    // 依序取出 rows 各列（復原用）
+    TrackStore subset(const QVector<int> &rows) const;
+
+    void clear();
+
+    // 實際配置的位元組數（含預留容量）
+    qint64 memoryUsage() const;
+
+    // 原始 UTF-8，給二進位格式直接寫出；dir 為 kNoDir/kPending 時只有 nameUtf8 有意義
+    quint32 dirOf(int row) const { return m_entries.at(row).dir; }
+
+    int dirCount() const { return static_cast<int>(m_dirOff.size()); }
+
+    QByteArrayView dirUtf8(quint32 dir) const;
+
+    QByteArrayView nameUtf8(int row) const;
+
+private:
+    struct Entry {
+        quint32 dir;
+        quint32 name; // m_names 位移（以 0 結尾）；kPending 時為快照列號
+    };
+
+    Entry makeEntry(const QUrl &url);
+
+    // other 的第 row 列搬進本儲存的字串區
+    Entry import(const TrackStore &other, int row);
+
+    void release(const Entry &e);
+
+    quint32 internDir(QByteArrayView dir);
+
+    quint32 findDir(QByteArrayView dir) const;
+
+    quint32 addName(QByteArrayView name);
+
+    void rehash(qsizetype slots);
+
+    void compactNames();
+
+    QVector<Entry> m_entries;
+    QByteArray m_names;
+    qint64 m_liveNameBytes = 0; // 仍被引用的檔名位元組（含結尾）
+    QByteArray m_dirs; // 以 0 結尾
+    QVector<quint32> m_dirOff;
+    QVector<quint32> m_slots; // 目錄編號 + 1，0 = 空；大小為 2 的次方
+};
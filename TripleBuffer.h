@@ -0,0 +1,43 @@
+#pragma once
+#include <atomic>
+#include <type_traits>
+
+// 無鎖三重緩衝：一個寫入端、一個讀取端，讀取端永遠拿到最新的一份
+// 寫入端不會被阻塞，讀取端不加鎖也不配置記憶體（適合把參數交給音訊回呼）
+template<typename T>
+class TripleBuffer final {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+public:
+    TripleBuffer() = default;
+
+    explicit TripleBuffer(const T &initial) {
+        for (T &s: m_slots) s = initial;
+    }
+
+    // 寫入端
+    void write(const T &value) {
+        m_slots[m_back] = value;
+        const int old = m_middle.exchange(m_back | kDirty, std::memory_order_acq_rel);
+        m_back = old & kIndexMask;
+    }
+
+    // 讀取端：有新資料時換到最新的一份，回傳是否更新
+    bool update() {
+        if (!(m_middle.load(std::memory_order_relaxed) & kDirty)) return false;
+        const int old = m_middle.exchange(m_front, std::memory_order_acq_rel);
+        m_front = old & kIndexMask;
+        return true;
+    }
+
+    const T &read() const { return m_slots[m_front]; }
+
+private:
+    static constexpr int kDirty = 4;
+    static constexpr int kIndexMask = 3;
+
+    T m_slots[3]{};
+    int m_front = 0; // 只由讀取端使用
+    int m_back = 1; // 只由寫入端使用
+    std::atomic<int> m_middle{2};
+};
@@ -0,0 +1,231 @@
+#include "WaveformCache.h"
+#include "AudioFileDecoder.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThread>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace {
+    constexpr char kMagic[4] = {'M', 'P', 'W', 'F'};
+    constexpr quint32 kVersion = 1;
+    constexpr int kMaxRecent = 64;
+
+    struct Header {
+        char magic[4];
+        quint32 version;
+        qint64 size;
+        qint64 mtime;
+    };
+
+    qint8 quantize(float v) {
+        return static_cast<qint8>(std::lround(std::clamp(v, -1.0f, 1.0f) * 127.0f));
+    }
+
+    // FNV-1a（與 MetadataIndex 相同）
+    quint64 hashPath(const QString &path) {
+        quint64 h = 14695981039346656037ULL;
+        for (const QChar c: path) {
+            h ^= c.unicode();
+            h *= 1099511628211ULL;
+        }
+        return h;
+    }
+}
+
+const qint8 *WaveformPeaks::level(int level) const {
+    qsizetype off = 0;
+    for (int l = 0; l < level; ++l) off += 2 * levelSize(l);
+    return reinterpret_cast<const qint8 *>(data.constData()) + off;
+}
+
+int WaveformPeaks::levelFor(int pixels) {
+    int level = 0;
+    while (level + 1 < kLevels && levelSize(level + 1) >= pixels) ++level;
+    return level;
+}
+
+qsizetype WaveformPeaks::byteSize() {
+    qsizetype n = 0;
+    for (int l = 0; l < kLevels; ++l) n += 2 * levelSize(l);
+    return n;
+}
+
+WaveformCache::WaveformCache(QObject *parent)
+    : QObject(parent) {
+    // 只有目前曲目需要波形：單一執行緒，新請求取代舊的
+    m_pool.setMaxThreadCount(1);
+    m_pool.setThreadPriority(QThread::LowPriority);
+}
+
+WaveformCache::~WaveformCache() {
+    {
+        QMutexLocker lock(&m_lock);
+        if (m_cancel) *m_cancel = true;
+    }
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+QString WaveformCache::cacheDir() {
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/waveforms";
+    QDir().mkpath(dir);
+    return dir;
+}
+
+QString WaveformCache::fileFor(const QString &path) {
+    return cacheDir() + '/' + QString::number(hashPath(path), 16).rightJustified(16, '0') + ".wfm";
+}
+
+std::optional<WaveformPeaks> WaveformCache::request(const QString &path) {
+    if (path.isEmpty()) return std::nullopt;
+    {
+        QMutexLocker lock(&m_lock);
+        if (const auto it = m_recent.constFind(path); it != m_recent.cend()) return *it;
+    }
+    if (auto peaks = load(path)) {
+        remember(path, *peaks);
+        return peaks;
+    }
+
+    auto cancel = std::make_shared<std::atomic<bool>>(false);
+    {
+        QMutexLocker lock(&m_lock);
+        if (m_cancel) *m_cancel = true;
+        m_cancel = cancel;
+    }
+    m_pool.clear();
+    m_pool.start([this, path, cancel] {
+        const auto peaks = compute(path, cancel.get());
+        if (!peaks || *cancel) return;
+        store(path, *peaks);
+        remember(path, *peaks);
+        emit ready(path);
+    });
+    return std::nullopt;
+}
+
+void WaveformCache::remember(const QString &path, const WaveformPeaks &peaks) {
+    QMutexLocker lock(&m_lock);
+    if (m_recent.size() >= kMaxRecent) m_recent.clear();
+    m_recent.insert(path, peaks);
+}
+
+std::optional<WaveformPeaks> WaveformCache::load(const QString &path) {
+    const QFileInfo fi(path);
+    if (!fi.isFile()) return std::nullopt;
+
+    QFile f(fileFor(path));
+    if (!f.open(QIODevice::ReadOnly) || f.size() != static_cast<qint64>(sizeof(Header)) + WaveformPeaks::byteSize())
+        return std::nullopt;
+    Header h{};
+    if (f.read(reinterpret_cast<char *>(&h), sizeof(h)) != sizeof(h)) return std::nullopt;
+    if (memcmp(h.magic, kMagic, 4) != 0 || h.version != kVersion || h.size != fi.size() ||
+        h.mtime != fi.lastModified().toMSecsSinceEpoch())
+        return std::nullopt;
+
+    WaveformPeaks peaks;
+    peaks.data = f.readAll();
+    if (peaks.isEmpty()) return std::nullopt;
+    return peaks;
+}
+
+void WaveformCache::store(const QString &path, const WaveformPeaks &peaks) {
+    const QFileInfo fi(path);
+    Header h{};
+    memcpy(h.magic, kMagic, 4);
+    h.version = kVersion;
+    h.size = fi.size();
+    h.mtime = fi.lastModified().toMSecsSinceEpoch();
+
+    QSaveFile out(fileFor(path));
+    if (!out.open(QIODevice::WriteOnly)) return;
+    out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+    out.write(peaks.data);
+    out.commit();
+}
+
+// 事先不知道曲長：以固定區塊累積 min/max，區塊數滿了就兩兩合併、區塊長度加倍
+std::optional<WaveformPeaks> WaveformCache::compute(const QString &path, const std::atomic<bool> *abort) {
+    constexpr size_t kMaxBlocks = WaveformPeaks::kBuckets * 8;
+    std::vector<float> mins;
+    std::vector<float> maxs;
+    mins.reserve(kMaxBlocks);
+    maxs.reserve(kMaxBlocks);
+    qint64 blockFrames = 64;
+    qint64 fill = 0;
+    float lo = 0.0f;
+    float hi = 0.0f;
+
+    auto flush = [&] {
+        mins.push_back(lo);
+        maxs.push_back(hi);
+        lo = hi = 0.0f;
+        fill = 0;
+        if (mins.size() < kMaxBlocks) return;
+        for (size_t i = 0; i < kMaxBlocks / 2; ++i) {
+            mins[i] = std::min(mins[2 * i], mins[2 * i + 1]);
+            maxs[i] = std::max(maxs[2 * i], maxs[2 * i + 1]);
+        }
+        mins.resize(kMaxBlocks / 2);
+        maxs.resize(kMaxBlocks / 2);
+        blockFrames *= 2;
+    };
+
+    const bool ok = AudioFileDecoder::decode(path, [&](const float *samples, qint64 frames, const QAudioFormat &format) {
+        const int ch = format.channelCount();
+        for (qint64 f = 0; f < frames; ++f) {
+            for (int c = 0; c < ch; ++c) {
+                const float v = samples[f * ch + c];
+                lo = std::min(lo, v);
+                hi = std::max(hi, v);
+            }
+            if (++fill == blockFrames) flush();
+        }
+    }, abort);
+    if (!ok) return std::nullopt;
+    if (fill > 0) {
+        mins.push_back(lo);
+        maxs.push_back(hi);
+    }
+    if (mins.empty()) return std::nullopt;
+
+    WaveformPeaks peaks;
+    peaks.data.resize(WaveformPeaks::byteSize());
+    auto *out = reinterpret_cast<qint8 *>(peaks.data.data());
+
+    // 第 0 層：把區塊重新分配到 kBuckets 格
+    const size_t n = mins.size();
+    constexpr size_t buckets = WaveformPeaks::kBuckets;
+    for (size_t i = 0; i < buckets; ++i) {
+        const size_t b0 = i * n / buckets;
+        const size_t b1 = std::max(b0 + 1, (i + 1) * n / buckets);
+        float bucketLo = mins[b0];
+        float bucketHi = maxs[b0];
+        for (size_t b = b0 + 1; b < b1; ++b) {
+            bucketLo = std::min(bucketLo, mins[b]);
+            bucketHi = std::max(bucketHi, maxs[b]);
+        }
+        out[2 * i] = quantize(bucketLo);
+        out[2 * i + 1] = quantize(bucketHi);
+    }
+
+    // 其餘各層由上一層兩兩合併
+    qint8 *prev = out;
+    for (int l = 1; l < WaveformPeaks::kLevels; ++l) {
+        qint8 *cur = prev + 2 * WaveformPeaks::levelSize(l - 1);
+        for (int i = 0; i < WaveformPeaks::levelSize(l); ++i) {
+            cur[2 * i] = std::min(prev[4 * i], prev[4 * i + 2]);
+            cur[2 * i + 1] = std::max(prev[4 * i + 1], prev[4 * i + 3]);
+        }
+        prev = cur;
+    }
+    return peaks;
+}
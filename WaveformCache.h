@@ -0,0 +1,63 @@
+#pragma once
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QThreadPool>
+#include <atomic>
+#include <memory>
+#include <optional>
+
+// 多解析度峰值金字塔：第 0 層 kBuckets 格，之後每層減半；每格為 int8 的 (min, max)
+struct WaveformPeaks {
+    static constexpr int kBuckets = 1024;
+    static constexpr int kLevels = 6; // 1024 .. 32 格，共約 4 KB
+
+    QByteArray data; // 各層依序連續存放
+
+    bool isEmpty() const { return data.size() != byteSize(); }
+
+    static int levelSize(int level) { return kBuckets >> level; }
+
+    const qint8 *level(int level) const;
+
+    // 不少於 pixels 格的最粗一層（視窗縮放時只需掃描與寬度相當的資料）
+    static int levelFor(int pixels);
+
+    static qsizetype byteSize();
+};
+
+// 背景解碼產生波形，並以每首一個小檔案快取在磁碟（路徑雜湊為檔名，大小 + 修改時間驗證）
+class WaveformCache final : public QObject {
+    Q_OBJECT
+
+public:
+    explicit WaveformCache(QObject *parent = nullptr);
+
+    ~WaveformCache() override;
+
+    // 已快取就立即回傳；否則排入背景計算（取代先前尚未完成的請求），完成後發出 ready
+    std::optional<WaveformPeaks> request(const QString &path);
+
+    // 同步解碼並建立金字塔
+    static std::optional<WaveformPeaks> compute(const QString &path, const std::atomic<bool> *abort = nullptr);
+
+    static QString cacheDir();
+
+signals:
+    void ready(const QString &path);
+
+private:
+    static QString fileFor(const QString &path);
+
+    static std::optional<WaveformPeaks> load(const QString &path);
+
+    static void store(const QString &path, const WaveformPeaks &peaks);
+
+    void remember(const QString &path, const WaveformPeaks &peaks);
+
+    QThreadPool m_pool;
+    QMutex m_lock;
+    std::shared_ptr<std::atomic<bool>> m_cancel; // 目前背景工作的取消旗標
+    QHash<QString, WaveformPeaks> m_recent; // 最近用過的，避免反覆讀檔
+};
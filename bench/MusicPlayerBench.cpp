@@ -0,0 +1,333 @@
+// 播放清單、匯入與格式化熱路徑的基準（QTest QBENCHMARK）
+// 用法：MusicPlayerBench [QTest 參數，例如 -tickcounter、-iterations 10、enqueue:100k]
+// 預設使用 offscreen 平台，不需要顯示器；測試資料為合成路徑，不需要真正的音訊檔
+
+#include "../FormatSniffer.h"
+#include "../MainWindow.h"
+#include "../SeekIndex.h"
+#include "../TrackStore.h"
+
+#include <QApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QItemSelectionModel>
+#include <QListView>
+#include <QListWidget>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QtTest/QtTest>
+#include <memory>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace {
+    const char *const kAudioExts[] = {"mp3", "flac", "m4a", "ogg", "opus", "wav"};
+
+    // 像真實音樂庫的路徑：演出者/專輯/曲目，約 2% 為封面或文字檔（會被過濾）
+    QList<QUrl> syntheticUrls(int count, const QString &root) {
+        QList<QUrl> urls;
+        urls.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            const int artist = i / 120;
+            const int album = i / 12;
+            const bool junk = i % 50 == 49;
+            const QString name = junk
+                                     ? QString("cover %1.jpg").arg(i)
+                                     : QString("%1 Track %2.%3").arg(i % 12 + 1, 2, 10, QLatin1Char('0'))
+                                       .arg(i).arg(kAudioExts[i % std::size(kAudioExts)]);
+            urls.push_back(QUrl::fromLocalFile(
+                QString("%1/Artist %2/Album %3/%4").arg(root).arg(artist).arg(album).arg(name)));
+        }
+        return urls;
+    }
+
+    int audioCount(int count) {
+        return count - count / 50;
+    }
+
+    // 目前配置中的堆積位元組（含 mmap 的大區塊）；只在 glibc 上可量
+    qint64 heapBytes() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+        const struct mallinfo2 mi = mallinfo2();
+        return qint64(mi.uordblks + mi.hblkhd);
+#else
+        return -1;
+#endif
+    }
+
+    // 一小時的 VBR MP3（MPEG 1 Layer III、44.1 kHz）：每幀位元率隨機，內容只有幀頭，解碼不出聲音但幀長正確
+    QByteArray syntheticVbrMp3(int frames, QVector<qint64> *starts) {
+        static constexpr int kBitrates[] = {32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320};
+        QByteArray data;
+        data.reserve(qsizetype(frames) * 420);
+        quint32 seed = 1;
+        for (int i = 0; i < frames; ++i) {
+            seed = seed * 1664525u + 1013904223u;
+            const int index = int(seed >> 28) % 14;
+            const int pad = (seed >> 20) & 1;
+            starts->push_back(data.size());
+            const qsizetype at = data.size();
+            data.resize(at + 144 * kBitrates[index] * 1000 / 44100 + pad, '\0');
+            data[at] = char(0xFF);
+            data[at + 1] = char(0xFB);
+            data[at + 2] = char(((index + 1) << 4) | (pad << 1));
+        }
+        return data;
+    }
+
+    // M3U 載入會檢查檔案是否存在：建立空檔即可
+    bool materialize(const QList<QUrl> &urls) {
+        for (const QUrl &url: urls) {
+            const QString path = url.toLocalFile();
+            if (!QDir().mkpath(QFileInfo(path).absolutePath())) return false;
+            QFile f(path);
+            if (!f.open(QIODevice::WriteOnly)) return false;
+        }
+        return true;
+    }
+}
+
+class MusicPlayerBench final : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase() {
+        QVERIFY(m_dir.isValid());
+        m_window = std::make_unique<MainWindow>();
+        m_window->clearList(); // 上一次執行留下的工作階段
+        m_root = m_dir.path() + "/library";
+    }
+
+    void cleanupTestCase() {
+        m_window.reset();
+    }
+
+    void cleanup() {
+        m_window->clearList();
+    }
+
+    void enqueue_data() {
+        QTest::addColumn<int>("count");
+        QTest::newRow("10k") << 10'000;
+        QTest::newRow("100k") << 100'000;
+        QTest::newRow("1M") << 1'000'000;
+    }
+
+    // 一次加入整批（大清單只量一次）
+    void enqueue() {
+        QFETCH(int, count);
+        const QList<QUrl> urls = syntheticUrls(count, m_root);
+        QBENCHMARK_ONCE {
+            m_window->enqueue(urls);
+        }
+        QCOMPARE(m_window->m_model->count(), audioCount(count));
+    }
+
+    void saveM3U() {
+        constexpr int kCount = 10'000;
+        const QList<QUrl> urls = syntheticUrls(kCount, m_root);
+        m_window->enqueue(urls);
+        const QString file = m_dir.path() + "/save.m3u";
+        QBENCHMARK {
+            QVERIFY(m_window->writePlaylist(file));
+        }
+    }
+
+    // 存檔後再載入：包含相對路徑解析、存在檢查與 enqueue
+    void loadM3U() {
+        constexpr int kCount = 10'000;
+        const QList<QUrl> urls = syntheticUrls(kCount, m_dir.path() + "/onDisk");
+        QVERIFY(materialize(urls));
+        m_window->enqueue(urls);
+        const QString file = m_dir.path() + "/roundtrip.m3u";
+        QVERIFY(m_window->writePlaylist(file));
+
+        QBENCHMARK {
+            m_window->clearList();
+            QVERIFY(m_window->readPlaylist(file));
+        }
+        QCOMPARE(m_window->m_model->count(), audioCount(kCount));
+        QCOMPARE(m_window->m_model->url(0), urls.constFirst());
+    }
+
+    // 每 1M 列的記憶體：原本的 QVector<QUrl> + QListWidgetItem vs. TrackStore
+    void trackMemory() {
+        constexpr int kCount = 1'000'000;
+        if (heapBytes() < 0) QSKIP("heap usage is only measured with glibc");
+
+        const qint64 start = heapBytes();
+        const QList<QUrl> urls = syntheticUrls(kCount, m_root);
+        const qint64 urlBytes = heapBytes() - start;
+        qint64 itemBytes = 0;
+        {
+            QListWidget list;
+            const qint64 before = heapBytes();
+            for (const QUrl &url: urls) list.addItem(QFileInfo(url.fileName()).completeBaseName());
+            itemBytes = heapBytes() - before;
+        }
+
+        const qint64 before = heapBytes();
+        TrackStore store;
+        for (const QUrl &url: urls) store.append(url);
+        const qint64 storeBytes = heapBytes() - before;
+        QCOMPARE(store.url(kCount - 1), urls.constLast());
+
+        const double oldPerTrack = double(urlBytes + itemBytes) / kCount;
+        const double newPerTrack = double(storeBytes) / kCount;
+        qInfo("per 1M tracks: QVector<QUrl> %.1f MB + QListWidgetItem %.1f MB, TrackStore %.1f MB "
+              "(%.1f vs %.1f B/track, %.1fx smaller)",
+              urlBytes / 1e6, itemBytes / 1e6, storeBytes / 1e6, oldPerTrack, newPerTrack, oldPerTrack / newPerTrack);
+        QVERIFY(oldPerTrack >= 5 * newPerTrack);
+    }
+
+    void isAudioUrl() {
+        const QList<QUrl> urls = syntheticUrls(100'000, m_root);
+        int accepted = 0;
+        QBENCHMARK {
+            accepted = 0;
+            for (const QUrl &url: urls) accepted += MainWindow::isAudioUrl(url);
+        }
+        QCOMPARE(accepted, audioCount(100'000));
+    }
+
+    void formatTime() {
+        qsizetype chars = 0;
+        QBENCHMARK {
+            chars = 0;
+            for (qint64 ms = 0; ms < 100'000LL * 997; ms += 997) chars += MainWindow::formatTime(ms).size();
+        }
+        QVERIFY(chars > 0);
+    }
+
+    void removeSelected_data() {
+        QTest::addColumn<int>("count");
+        QTest::addColumn<int>("step"); // 0 = 前半段連續
+        QTest::newRow("100k, every 10th") << 100'000 << 10;
+        QTest::newRow("100k, first half") << 100'000 << 0;
+        QTest::newRow("1M, every 100th") << 1'000'000 << 100;
+    }
+
+    void removeSelected() {
+        QFETCH(int, count);
+        QFETCH(int, step);
+        m_window->enqueue(syntheticUrls(count, m_root));
+        const int rows = m_window->m_model->count();
+
+        QListView *view = m_window->m_list;
+        QAbstractItemModel *model = view->model();
+        QItemSelection selection;
+        int selected = 0;
+        if (step == 0) {
+            selected = rows / 2;
+            selection.select(model->index(0, 0), model->index(selected - 1, 0));
+        } else {
+            for (int r = 0; r < rows; r += step, ++selected) selection.select(model->index(r, 0), model->index(r, 0));
+        }
+        view->selectionModel()->select(selection, QItemSelectionModel::ClearAndSelect | QItemSelectionModel::Rows);
+
+        QBENCHMARK_ONCE {
+            m_window->removeSelected();
+        }
+        QCOMPARE(m_window->m_model->count(), rows - selected);
+    }
+
+    // 切換曲目的 GUI 端成本（來源不存在，後端只會回報錯誤）
+    void playIndex() {
+        m_window->enqueue(syntheticUrls(10'000, m_root));
+        const int rows = m_window->m_model->count();
+        int row = 0;
+        QBENCHMARK {
+            m_window->playIndex(row);
+            row = (row + 7919) % rows;
+        }
+        QVERIFY(m_window->m_currentIndex >= 0);
+    }
+
+    // 每種認得的檔頭都要判斷正確（ISO-BMFF 的 box 大小以 0 開頭，不能當補零跳過）
+    void sniff() {
+        const auto bytes = [](std::initializer_list<int> b) {
+            QByteArray a;
+            for (const int c: b) a.append(char(c));
+            return a;
+        };
+        const QByteArray mpeg = bytes({0xFF, 0xFB, 0x90, 0x64});
+        const QByteArray adts = bytes({0xFF, 0xF1, 0x50, 0x80});
+        const struct {
+            QByteArray head;
+            FormatSniffer::Format format;
+        } cases[] = {
+            {"fLaC" + QByteArray(60, '\0'), FormatSniffer::Flac},
+            {"OggS" + QByteArray(60, '\0'), FormatSniffer::Ogg},
+            {"RIFF" + bytes({0x24, 0, 0, 0}) + "WAVEfmt ", FormatSniffer::Wave},
+            {"RF64" + bytes({0xFF, 0xFF, 0xFF, 0xFF}) + "WAVEds64", FormatSniffer::Wave},
+            {bytes({0, 0, 0, 0x20}) + "ftypM4A " + QByteArray(20, '\0'), FormatSniffer::Mp4},
+            {bytes({0, 0, 0, 0x18}) + "ftypmp42" + QByteArray(12, '\0'), FormatSniffer::Mp4},
+            {mpeg, FormatSniffer::Mpeg},
+            {QByteArray(16, '\0') + mpeg, FormatSniffer::Mpeg}, // ID3 之後的補零
+            {adts, FormatSniffer::Adts},
+            {QByteArray(16, '\0') + adts, FormatSniffer::Adts},
+            {"<html><body>", FormatSniffer::Unsupported},
+            {QByteArray(64, '\0'), FormatSniffer::Unreadable},
+            {"fL", FormatSniffer::Unreadable},
+        };
+        for (const auto &c: cases) QCOMPARE(FormatSniffer::sniff(c.head), c.format);
+
+        const QByteArray m4a = bytes({0, 0, 0, 0x20}) + "ftypM4A " + QByteArray(FormatSniffer::kHeadBytes, '\0');
+        FormatSniffer::Format f = FormatSniffer::Unknown;
+        QBENCHMARK {
+            f = FormatSniffer::sniff(m4a);
+        }
+        QCOMPARE(f, FormatSniffer::Mp4);
+    }
+
+    // 跳轉表：掃描一小時的檔案，之後每次定位只做二分搜尋，落點準到 sample
+    void seekIndex() {
+        constexpr int kFrames = 138'000; // 約 60 分鐘
+        QVector<qint64> starts;
+        const QString path = m_dir.path() + "/podcast.mp3";
+        {
+            QFile f(path);
+            QVERIFY(f.open(QIODevice::WriteOnly));
+            f.write(syntheticVbrMp3(kFrames, &starts));
+        }
+
+        std::optional<SeekTable> table;
+        QElapsedTimer scan;
+        scan.start();
+        table = SeekIndex::scan(path);
+        qInfo("scanned %d frames in %lld ms", kFrames, scan.elapsed());
+        QVERIFY(table && table->exact);
+        QCOMPARE(table->durationMs(), qint64(kFrames) * 1152 * 1000 / 44100);
+
+        qint64 ms = 0;
+        SeekTable::Target target;
+        QBENCHMARK {
+            ms = (ms + 7919) % table->durationMs();
+            target = table->locate(ms);
+        }
+        const auto frame = std::lower_bound(starts.cbegin(), starts.cend(), target.offset);
+        QVERIFY(frame != starts.cend() && *frame == target.offset);
+        QCOMPARE((frame - starts.cbegin()) * 1152 + target.skipSamples, ms * 44100 / 1000);
+    }
+
+private:
+    QTemporaryDir m_dir;
+    QString m_root;
+    std::unique_ptr<MainWindow> m_window;
+};
+
+int main(int argc, char *argv[]) {
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+    QApplication::setApplicationName("MusicPlayerBench");
+    QApplication::setOrganizationName("Ethan");
+    QStandardPaths::setTestModeEnabled(true); // 索引、快取與設定不碰使用者的資料
+
+    MusicPlayerBench bench;
+    return QTest::qExec(&bench, argc, argv);
+}
+
+#include "MusicPlayerBench.moc"
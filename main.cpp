@@ -1,10 +1,34 @@
 #include <QApplication>
 #include <QColor>
+#include "HeadlessCli.h"
+#include "InstanceChannel.h"
+#include "Trace.h"
 #include "MainWindow.h"
 #include <QStyleFactory>
 #include <QPalette>
 
 int main(int argc, char *argv[]) {
+    // 子命令：不建立視窗，也不需要顯示器
+    if (argc > 1 && HeadlessCli::isCommand(argv[1])) {
+        QCoreApplication app(argc, argv);
+        QCoreApplication::setApplicationName("MusicPlayer");
+        QCoreApplication::setOrganizationName("Ethan"); // 與 GUI 共用索引位置
+        return HeadlessCli::run(QCoreApplication::arguments());
+    }
+
+    // 已有執行中的播放器：參數轉成命令送過去就結束，不載入視窗與多媒體
+    QStringList commands;
+    bool newInstance;
+    {
+        QCoreApplication probe(argc, argv);
+        QCoreApplication::setApplicationName("MusicPlayer");
+        const QStringList args = QCoreApplication::arguments();
+        commands = InstanceChannel::commandsFromArguments(args);
+        newInstance = args.contains("--new-instance"); // 不接管也不轉送（例如測試用的第二個視窗）
+        if (!newInstance && InstanceChannel::forward(commands)) return 0;
+    }
+
+    Trace::initFromEnvironment();
     QApplication app(argc, argv); // Qt 應用程式物件
     QApplication::setApplicationName("MusicPlayer");
     QApplication::setOrganizationName("Ethan");
@@ -64,27 +88,13 @@ int main(int argc, char *argv[]) {
         background: rgba(255,255,255,0.15);
     }
 
-    QListWidget {
+    QListView {
         outline: none;
         selection-background-color: transparent;
         color: #FFFFFF;
         selection-color: #5CC8FF;
     }
 
-    QListWidget::item:selected, QListWidget::item:selected:!active, QListWidget::item:selected:active, QListWidget::item:selected:focus, QListWidget::item:selected:!focus {
-        background: transparent;
-        color: #5CC8FF;
-        font-weight: bold;
-    }
-
-    QListWidget::item:hover {
-        background: rgba(255,255,255,0.08);
-    }
-
-    QListWidget::item:selected:hover, QListWidget::item:selected:!active:hover, QListWidget::item:selected:active:hover, QListWidget::item:selected:focus:hover, QListWidget::item:selected:!focus:hover {
-        background: rgba(255,255,255,0.08);
-    }
-
     QSlider::groove:horizontal {
         height: 6px;
         background: rgba(255,255,255,0.10);
@@ -123,8 +133,18 @@ int main(int argc, char *argv[]) {
     }
 )");
 
+    // 同時啟動時搶輸的一方改為轉送
+    InstanceChannel channel;
+    if (!newInstance && !channel.listen() && InstanceChannel::forward(commands)) return 0;
+
     MainWindow w; // 主視窗物件
+    channel.setHandler([&w](const QString &verb, const QString &arg) { return w.remoteCommand(verb, arg); });
     w.resize(900, 520); // 視窗大小
     w.show();
-    return QApplication::exec();
+    for (const QString &line: commands) channel.execute(line); // 自己的參數走同一套命令
+    Trace::record(Trace::Startup, 0, Trace::nowUs()); // 從行程啟動算起
+
+    const int rc = QApplication::exec();
+    Trace::finish();
+    return rc;
 }